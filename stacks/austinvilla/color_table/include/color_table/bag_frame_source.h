@@ -0,0 +1,140 @@
+/**
+ * \file  bag_frame_source.h
+ * \brief Header for lazy, cached access to the image frames of a bag file
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 08/30/2011 10:41:18 AM piyushk $
+ */
+
+#ifndef BAG_FRAME_SOURCE_V7NQ2KDL
+#define BAG_FRAME_SOURCE_V7NQ2KDL
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <rosbag/bag.h>
+#include <rosbag/view.h>
+#include <sensor_msgs/Image.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread.hpp>
+
+namespace color_table {
+
+  /**
+   * \class BagFrameSource
+   * \brief Gives random access to the images on a topic of a bag, without
+   *        loading all of them into memory
+   *
+   * Opening a bag only starts indexing it: a background thread collects the
+   * position of every message on the topic, and frames become available as
+   * they are indexed. Frames are deserialized on demand and kept in a bounded
+   * LRU cache. A second background thread decodes the frames around the
+   * current frame ahead of time, so that stepping through the bag does not
+   * wait on the disk.
+   */
+  class BagFrameSource : boost::noncopyable {
+
+    public:
+
+      /**
+       * \param   cacheSize Maximum number of decoded frames kept in memory
+       * \param   prefetchRadius Number of frames on either side of the
+       *          current frame that are decoded ahead of time
+       */
+      BagFrameSource(size_t cacheSize = 64, unsigned int prefetchRadius = 8);
+      ~BagFrameSource();
+
+      /**
+       * \brief   Opens a bag and starts indexing it in the background
+       * \param   error If not NULL, receives a description of the failure
+       * \return  false if the bag could not be opened
+       */
+      bool open(const std::string &filename, const std::string &topic, std::string *error = NULL);
+
+      /**
+       * \brief   Stops the background threads and closes the bag
+       */
+      void close();
+
+      /**
+       * \brief   Number of frames indexed so far
+       */
+      size_t getNumFrames();
+
+      /**
+       * \brief   Whether the bag is still being indexed
+       */
+      bool isIndexing();
+
+      /**
+       * \brief   Returns a frame, decoding it if it is not cached
+       * \return  NULL if index is past the frames indexed so far
+       */
+      sensor_msgs::ImageConstPtr getFrame(size_t index);
+
+      /**
+       * \brief   Returns a frame without adding it to the cache, for passes
+       *          over the whole bag that would otherwise evict the frames
+       *          around the current one
+       * \return  NULL if index is past the frames indexed so far
+       */
+      sensor_msgs::ImageConstPtr readFrame(size_t index);
+
+      /**
+       * \brief   Tells the prefetch thread which frame is being looked at
+       */
+      void setCurrentFrame(size_t index);
+
+    private:
+
+      void indexBag(std::string topic);
+      void prefetch();
+
+      /**
+       * \brief   Looks up a frame in the cache, marking it as recently used
+       */
+      sensor_msgs::ImageConstPtr findCached(size_t index);
+      void addCached(size_t index, const sensor_msgs::ImageConstPtr &image);
+
+      /**
+       * \brief   Reads a frame from the bag. Must not be called with
+       *          indexMutex held.
+       */
+      sensor_msgs::ImageConstPtr decode(size_t index);
+
+      rosbag::Bag bag;
+      boost::mutex bagMutex;                    ///< rosbag is not thread safe
+
+      std::vector<rosbag::MessageInstance> messages;
+      bool indexing;
+      boost::mutex indexMutex;                  ///< Protects messages and indexing
+
+      typedef std::list<std::pair<size_t, sensor_msgs::ImageConstPtr> > CacheList;
+      CacheList cache;                          ///< Most recently used first
+      std::map<size_t, CacheList::iterator> cacheIndex;
+      size_t cacheSize;
+      boost::mutex cacheMutex;
+
+      unsigned int prefetchRadius;
+      size_t currentFrame;
+      bool currentFrameChanged;
+      bool stopping;
+      boost::mutex prefetchMutex;               ///< Protects currentFrame, currentFrameChanged and stopping
+      boost::condition_variable prefetchCondition;
+
+      boost::scoped_ptr<boost::thread> indexThread;
+      boost::scoped_ptr<boost::thread> prefetchThread;
+
+  };
+
+}
+
+#endif /* end of include guard: BAG_FRAME_SOURCE_V7NQ2KDL */
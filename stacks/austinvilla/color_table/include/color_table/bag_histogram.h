@@ -0,0 +1,90 @@
+/**
+ * \file  bag_histogram.h
+ * \brief Header for the BagHistogram class, which adds up the color
+ * histograms of all frames of a bag in the background
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 09/07/2011 02:12:09 PM piyushk $
+ */
+
+#ifndef BAG_HISTOGRAM_M4RV8ZCQ
+#define BAG_HISTOGRAM_M4RV8ZCQ
+
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include <color_table/bag_frame_source.h>
+#include <color_table/color_histogram.h>
+
+namespace color_table {
+
+  /**
+   * \class BagHistogram
+   * \brief Builds the histogram of all frames of a bag on a pool of threads
+   *
+   * Frames are read without going through the frame cache. Each thread
+   * converts its frames and adds their histograms up, and the threads'
+   * histograms are added up at the end. Once built, the coverage of the
+   * whole bag by any table is a pass over the histogram's cells, so it can
+   * be updated after every edit.
+   */
+  class BagHistogram : boost::noncopyable {
+
+    public:
+
+      BagHistogram();
+      ~BagHistogram();
+
+      /**
+       * \brief   Starts building the histogram of the first numFrames frames
+       *          in the background. frames must stay open until the
+       *          histogram is done, or stop() is called.
+       * \param   numThreads 0 for one per core
+       */
+      void start(BagFrameSource &frames, size_t numFrames, unsigned int numThreads = 0);
+
+      /**
+       * \brief   Stops the threads. The histogram is dropped.
+       */
+      void stop();
+
+      /**
+       * \brief   Whether the histogram is still being built
+       */
+      bool isRunning();
+
+      void getProgress(size_t &numDone, size_t &numFrames);
+
+      /**
+       * \brief   The histogram of all frames, NULL until it is done
+       */
+      boost::shared_ptr<const ColorHistogram> getHistogram();
+
+    private:
+
+      void run();
+
+      BagFrameSource *frames;
+
+      boost::mutex mutex;                     ///< Protects everything below
+      size_t numFrames;
+      size_t nextFrame;
+      size_t numDone;
+      unsigned int numRunning;
+      bool stopping;
+      ColorHistogram total;                   ///< Sum of the histograms of the threads that finished
+      boost::shared_ptr<const ColorHistogram> result;
+
+      boost::scoped_ptr<boost::thread_group> threads;
+
+  };
+
+}
+
+#endif /* end of include guard: BAG_HISTOGRAM_M4RV8ZCQ */
@@ -0,0 +1,120 @@
+/**
+ * \file  blob_detector.h
+ * \brief Header for the BlobDetector class, which groups segmented pixels
+ * into connected blobs of a single color
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 08/26/2011 10:14:51 AM piyushk $
+ */
+
+#ifndef BLOB_DETECTOR_C9XK2TQE
+#define BLOB_DETECTOR_C9XK2TQE
+
+#include <cstddef>
+#include <vector>
+
+#include <color_table/common.h>
+
+namespace color_table {
+
+  /**
+   * \struct Run
+   * \brief  A horizontal run of pixels of the same color inside a row
+   */
+  struct Run {
+    uint16_t y;                     ///< Row of the run
+    uint16_t xStart;                ///< First pixel of the run
+    uint16_t xEnd;                  ///< One past the last pixel of the run
+    uint8_t color;                  ///< Label of all pixels in the run
+    unsigned int parent;            ///< Union-find parent (index into the run list)
+  };
+
+  /**
+   * \struct Blob
+   * \brief  A 4-connected component of pixels of the same color
+   */
+  struct Blob {
+    uint8_t color;                  ///< Label of all pixels in the blob
+    unsigned int area;              ///< Number of pixels
+    uint16_t xMin, xMax;            ///< Horizontal extent of the bounding box (inclusive)
+    uint16_t yMin, yMax;            ///< Vertical extent of the bounding box (inclusive)
+    float centroidX, centroidY;     ///< Mean pixel position
+    unsigned int numRuns;           ///< Number of runs the blob is made of
+  };
+
+  /**
+   * \class BlobDetector
+   * \brief Finds blobs in a label image
+   *
+   * Each row is run length encoded first. Runs of the same color that overlap
+   * in consecutive rows are then merged with union-find, so the work depends
+   * on the number of runs rather than the number of pixels. UNDEFINED pixels
+   * never form blobs.
+   */
+  class BlobDetector {
+
+    public:
+
+      /**
+       * \param   minArea Blobs with fewer pixels than this are not reported
+       */
+      explicit BlobDetector(unsigned int minArea = 1);
+
+      /**
+       * \brief   Finds the blobs in a label image
+       * \param   labels The label image, one byte per pixel
+       * \param   width Number of pixels in a row
+       * \param   height Number of rows
+       * \param   labelStep Number of bytes between 2 consecutive rows of labels
+       */
+      void detect(const uint8_t *labels, unsigned int width, unsigned int height, size_t labelStep);
+
+      /**
+       * \brief   Blobs found by the last call to detect(), largest first
+       */
+      inline const std::vector<Blob>& getBlobs() const {
+        return blobs;
+      }
+
+      /**
+       * \brief   Runs found by the last call to detect(), in row major order
+       */
+      inline const std::vector<Run>& getRuns() const {
+        return runs;
+      }
+
+      /**
+       * \brief   Index into getBlobs() of the blob a run belongs to, or -1 if
+       *          the blob is smaller than the minimum area
+       */
+      inline int getBlobIndex(unsigned int run) const {
+        return blobOfRun[run];
+      }
+
+      inline void setMinArea(unsigned int area) {
+        minArea = area;
+      }
+
+    private:
+
+      void encodeRuns(const uint8_t *labels, unsigned int width, unsigned int height, size_t labelStep);
+      void mergeRuns();
+      void collectBlobs();
+
+      unsigned int findRoot(unsigned int run);
+
+      unsigned int minArea;
+      std::vector<Run> runs;
+      std::vector<unsigned int> rowStarts;    ///< First run of each row, plus one end marker
+      std::vector<Blob> blobs;
+      std::vector<int> blobOfRun;
+
+  };
+
+}
+
+#endif /* end of include guard: BLOB_DETECTOR_C9XK2TQE */
@@ -0,0 +1,249 @@
+/**
+ * \file  block_color_table.h
+ * \brief Header for a block sparse, copy-on-write color table used while
+ * editing a table, along with cheap previews of pending edits
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 08/19/2011 11:02:37 AM piyushk $
+ */
+
+#ifndef BLOCK_COLOR_TABLE_F4CW8ZLM
+#define BLOCK_COLOR_TABLE_F4CW8ZLM
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <color_table/common.h>
+#include <color_table/color_table.h>
+
+namespace color_table {
+
+  /**
+   * \class BlockColorTable
+   * \brief A color table split into 8x8x8 blocks of cells
+   *
+   * Blocks are reference counted and copied on write. All blocks that are
+   * entirely UNDEFINED share a single block, so an empty table costs a few
+   * kilobytes. Cells are indexed by cell (not rgb) coordinates.
+   *
+   * Segmentation goes through the segmentPixels() kernel, on a flat copy of
+   * the table that is built on first use and shared between copies. Edits
+   * do not rebuild it: blocks changed since it was built are marked stale,
+   * and pixels falling in a stale block are looked up in the block itself.
+   * When no copy shares the flat table, edits are written straight into it,
+   * and a shared one is only copied once many blocks have gone stale.
+   */
+  class BlockColorTable {
+
+    public:
+
+      static const unsigned int BLOCK_BITS = 3;
+      static const unsigned int BLOCK_SIZE = 1 << BLOCK_BITS;
+      static const unsigned int BLOCK_CELLS = BLOCK_SIZE * BLOCK_SIZE * BLOCK_SIZE;
+      static const unsigned int BLOCKS_PER_AXIS = Resolution::SIZE / BLOCK_SIZE;
+      static const unsigned int NUM_BLOCKS = BLOCKS_PER_AXIS * BLOCKS_PER_AXIS * BLOCKS_PER_AXIS;
+
+      typedef boost::shared_ptr<uint8_t> BlockPtr;
+
+      /**
+       * \brief   Constructs a table with every cell set to UNDEFINED
+       */
+      BlockColorTable();
+
+      BlockColorTable(const BlockColorTable &other);
+      BlockColorTable& operator=(const BlockColorTable &other);
+
+      /**
+       * \brief   Sets every cell to UNDEFINED
+       */
+      void clear();
+
+      /**
+       * \brief   Copies a flat table into this one. Uniform UNDEFINED blocks are shared.
+       */
+      void fromColorTable(const ColorTable &table);
+
+      /**
+       * \brief   Copies this table into a flat table (for saving, or the segmentation kernel)
+       */
+      void toColorTable(ColorTable &table) const;
+
+      static inline unsigned int getBlockIndex(unsigned int r, unsigned int g, unsigned int b) {
+        return ((r >> BLOCK_BITS) * BLOCKS_PER_AXIS + (g >> BLOCK_BITS)) * BLOCKS_PER_AXIS + (b >> BLOCK_BITS);
+      }
+
+      static inline unsigned int getCellIndex(unsigned int r, unsigned int g, unsigned int b) {
+        const unsigned int mask = BLOCK_SIZE - 1;
+        return (((r & mask) << BLOCK_BITS) | (g & mask)) << BLOCK_BITS | (b & mask);
+      }
+
+      /**
+       * \brief   Key of a cell that orders cells block by block: block index
+       *          in the high bits, cell inside the block in the low bits
+       */
+      static inline uint32_t getCellKey(unsigned int r, unsigned int g, unsigned int b) {
+        return (getBlockIndex(r, g, b) << (3 * BLOCK_BITS)) | getCellIndex(r, g, b);
+      }
+
+      inline uint8_t get(unsigned int r, unsigned int g, unsigned int b) const {
+        return blocks[getBlockIndex(r, g, b)].get()[getCellIndex(r, g, b)];
+      }
+
+      /**
+       * \brief   Sets a single cell, copying its block first if it is shared
+       */
+      void set(unsigned int r, unsigned int g, unsigned int b, uint8_t color);
+
+      /**
+       * \brief   Segments a packed array of pixels. Safe to call from several
+       *          threads at once.
+       */
+      void segment(const Rgb *pixels, size_t numPixels, uint8_t *labels) const;
+
+      inline const BlockPtr& getBlock(unsigned int block) const {
+        return blocks[block];
+      }
+
+      /**
+       * \brief   Exchanges one of the table's blocks with the given block
+       */
+      inline void swapBlock(unsigned int block, BlockPtr &other) {
+        blocks[block].swap(other);
+        markStale(block);
+      }
+
+      /**
+       * \brief   Returns a new, unshared copy of a block
+       */
+      static BlockPtr cloneBlock(const BlockPtr &block);
+
+    private:
+
+      friend class ColorTablePreview;
+
+      /**
+       * \brief   Segments pixels, taking the blocks of overlay (if not NULL)
+       *          in place of the table's own wherever they are set
+       */
+      void segment(const Rgb *pixels, size_t numPixels, uint8_t *labels,
+          const std::vector<BlockPtr> *overlay) const;
+
+      boost::shared_ptr<ColorTable> getFlatTable() const;
+
+      /**
+       * \brief   Brings the flat table up to date with a changed block, or
+       *          marks the block stale if the flat table is shared
+       */
+      void markStale(unsigned int block);
+
+      /**
+       * \brief   Copies the stale blocks into the flat table, which must not be shared
+       */
+      void flushStale();
+
+      std::vector<BlockPtr> blocks;   ///< Block directory, indexed by getBlockIndex()
+      BlockPtr undefinedBlock;        ///< Block shared by all entirely UNDEFINED blocks
+
+      mutable boost::shared_ptr<ColorTable> flatTable;  ///< NULL until built. Never written to while shared.
+      mutable boost::mutex flatMutex;                   ///< Guards building flatTable
+      std::vector<uint8_t> isStale;                     ///< Non zero for blocks that differ from flatTable
+      std::vector<unsigned int> staleBlocks;            ///< Indices of the non zero isStale entries
+
+  };
+
+  /**
+   * \class ColorTablePreview
+   * \brief A set of pending edits on top of a BlockColorTable
+   *
+   * The first write to a block copies just that block. Reads fall through to
+   * the base table for blocks that were not written to. Committing swaps the
+   * edited blocks into the base table, so both previewing and committing cost
+   * time proportional to the number of blocks touched, not the size of the
+   * table.
+   */
+  class ColorTablePreview {
+
+    public:
+
+      explicit ColorTablePreview(BlockColorTable &base);
+
+      inline uint8_t get(unsigned int r, unsigned int g, unsigned int b) const {
+        return getBlock(BlockColorTable::getBlockIndex(r, g, b)).get()[BlockColorTable::getCellIndex(r, g, b)];
+      }
+
+      /**
+       * \brief   The block as seen through the preview (edited copy or base block)
+       */
+      inline const BlockColorTable::BlockPtr& getBlock(unsigned int block) const {
+        return overlay[block] ? overlay[block] : base->getBlock(block);
+      }
+
+      inline const BlockColorTable& getBase() const {
+        return *base;
+      }
+
+      /**
+       * \brief   Sets a cell in the preview, leaving the base table untouched
+       */
+      void set(unsigned int r, unsigned int g, unsigned int b, uint8_t color);
+
+      /**
+       * \brief   Sets many cells in one pass. A block is only copied if at
+       *          least one of its cells actually changes.
+       * \param   keys Cells as BlockColorTable::getCellKey() values, grouped
+       *          by block (sorted keys are)
+       * \param   onlyColor If not NUM_COLORS, only cells currently holding
+       *          this color are changed
+       */
+      void setCells(const std::vector<uint32_t> &keys, uint8_t color, uint8_t onlyColor = NUM_COLORS);
+
+      /**
+       * \brief   Segments a packed array of pixels as if the edits were
+       *          committed. Safe to call from several threads at once.
+       */
+      void segment(const Rgb *pixels, size_t numPixels, uint8_t *labels) const;
+
+      /**
+       * \brief   Whether a block has been written to in this preview
+       */
+      inline bool isBlockTouched(unsigned int block) const {
+        return overlay[block].get() != NULL;
+      }
+
+      /**
+       * \brief   Blocks written to in this preview, in the order they were first touched
+       */
+      inline const std::vector<unsigned int>& getTouchedBlocks() const {
+        return touchedBlocks;
+      }
+
+      inline bool empty() const {
+        return touchedBlocks.empty();
+      }
+
+      /**
+       * \brief   Applies the edits to the base table and empties the preview
+       */
+      void commit();
+
+      /**
+       * \brief   Drops all edits
+       */
+      void discard();
+
+    private:
+
+      BlockColorTable *base;
+      std::vector<BlockColorTable::BlockPtr> overlay;   ///< Edited copies of blocks, NULL if untouched
+      std::vector<unsigned int> touchedBlocks;          ///< Indices of non NULL overlay entries
+
+  };
+
+}
+
+#endif /* end of include guard: BLOCK_COLOR_TABLE_F4CW8ZLM */
@@ -14,17 +14,24 @@
 #ifndef CLASSIFICATION_WINDOW_GZ6WWOJ1
 #define CLASSIFICATION_WINDOW_GZ6WWOJ1
 
+#include <QtGui/QLabel>
 #include <QtGui/QMainWindow>
 #include <sensor_msgs/Image.h>
 
 #include <color_table/common.h>
+#include <color_table/blob_detector.h>
+#include <color_table/block_color_table.h>
+#include <color_table/color_histogram.h>
+#include <color_table/edit_history.h>
+#include <color_table/frame_bin_index.h>
+#include <color_table/region_fill.h>
+#include <color_table/rgb_frame.h>
+#include <color_table/segmentation_worker.h>
+#include <color_table/table_compiler.h>
 #include "ui_classification_window.h"
 
 namespace color_table {
 
-  typedef Rgb RgbImage[IMAGE_HEIGHT][IMAGE_WIDTH];
-  typedef uint8_t SegImage[IMAGE_HEIGHT][IMAGE_WIDTH];
-
   enum Image {
     RGB,
     SEG
@@ -48,20 +55,54 @@ namespace color_table {
     ClassificationWindow(QWidget *parent = 0);
 
     /**
-     * \brief  Get an updated image from the main window
+     * \brief  Get an updated image from the main window. Any resolution and
+     *         any encoding supported by RgbFrame is accepted. The frame is
+     *         converted and segmented in the background, and shown when done,
+     *         unless a newer frame has been requested in the meantime.
      */
     void changeImage(sensor_msgs::ImageConstPtr image);
 
+    /**
+     * \brief  Same as above, but the image is also loaded in the background
+     *         (for instance decoded from a bag)
+     */
+    void changeImage(const SegmentationWorker::ImageLoader &loader);
+
+    /**
+     * \brief  Drops any frame that is still being loaded or segmented, and
+     *         waits for its loader to return
+     */
+    void cancelSegmentation();
+
+    /**
+     * \brief  Sets the histogram of all frames of the bag, so that the
+     *         coverage of the bag is shown along with the coverage of the
+     *         frame. NULL hides it.
+     */
+    void setBagHistogram(const boost::shared_ptr<const ColorHistogram> &histogram);
+
+    /**
+     * \brief  A snapshot of the table as currently previewed, which stays
+     *         valid (and unchanged) while the user keeps editing
+     */
+    boost::shared_ptr<const BlockColorTable> getTableSnapshot();
+
     /** 
-     * \brief Function to draw an RgbImage onto an ImageWidget screen
+     * \brief Function to draw the current frame onto an ImageWidget screen
      */
     void drawRgbImage(ImageWidget *widget);
 
     /** 
-     * \brief Function to draw an RgbImage onto an ImageWidget screen
+     * \brief Function to draw the SegImage onto an ImageWidget screen
      */
     void drawSegImage(ImageWidget *widget);
 
+    /**
+     * \brief Detects blobs in the SegImage and outlines them on the seg
+     *        image screens, if blob display is enabled
+     */
+    void updateBlobOverlay();
+
     /** 
      * \brief Obtains seg image by segmenting the raw image using specified
      *        color table
@@ -73,6 +114,54 @@ namespace color_table {
      */
     void redrawImages(bool useTempColorTable = false);
 
+    /**
+     * \brief Relabels and redraws only the pixels that the current preview
+     *        (or the previously displayed one) can affect
+     */
+    void redrawPreview();
+
+    /**
+     * \brief Shows the share of the frame's (and bag's) pixels that the
+     *        previewed table assigns to each color in the status bar
+     */
+    void updateCoverage();
+
+    /**
+     * \brief Commits the current preview, recording it in the edit history
+     */
+    void commitPreview();
+
+    /**
+     * \brief Enables the undo and redo actions if there is something to undo/redo
+     */
+    void updateHistoryActions();
+
+    /**
+     * \brief Selects the region around a point of the frame, if one of the
+     *        region brushes is enabled
+     * \return Number of pixels in the region, 0 if no region brush is enabled
+     */
+    size_t selectRegion(int x, int y);
+
+    /**
+     * \brief Writes the table cells of the region around a point into the
+     *        preview in one batch
+     */
+    void paintRegion(int x, int y);
+
+    /**
+     * \brief Adds the pixels around a point of the frame (or the selected
+     *        region) to the training samples, labeled with the current color
+     *        (or UNDEFINED when removing)
+     */
+    void addSamples(int x, int y);
+
+    /**
+     * \brief Replaces the table with one compiled from the training
+     *        samples. The change is recorded as a single edit.
+     */
+    void compileSamples(CompileMethod method);
+
     /**
      * \brief Sets currentColor if the user indicates a different color
      */
@@ -106,7 +195,20 @@ namespace color_table {
      */
     void closeEvent(QCloseEvent *event);
 
+  signals:
+    /**
+     * \brief Emitted whenever the previewed table changes, including on
+     *        every preview while the mouse moves
+     */
+    void tableChanged();
+
   public slots:
+    /**
+     * \brief Displays the frame segmented by the worker, if it is the
+     *        newest one
+     */
+    void showSegmentationResult();
+
     void on_bigImage_clicked(int x, int y, int button);
     void on_bigImage_mouseXY(int x, int y);
     void on_rawImage_clicked(int x, int y, int button);
@@ -128,18 +230,52 @@ namespace color_table {
     void on_actionOpen_triggered();
     void on_actionSave_triggered();
     void on_actionSave_As_triggered();
+    void on_actionUndo_triggered();
+    void on_actionRedo_triggered();
+    void on_actionShow_Blobs_toggled(bool checked);
+    void on_actionRegion_Color_toggled(bool checked);
+    void on_actionRegion_Labels_toggled(bool checked);
+    void on_actionCollect_Samples_toggled(bool checked);
+    void on_actionClear_Samples_triggered();
+    void on_actionCompile_Majority_triggered();
+    void on_actionCompile_Gaussian_triggered();
+    void on_actionCompile_Nearest_Neighbors_triggered();
 
   private:
+    /**
+     * \brief  Called whenever the previewed table changes. A frame still
+     *         being segmented with the old table is requested again.
+     */
+    void invalidateTableSnapshot();
+
     Ui::ClassificationWindow ui;
     std::string colorTableFilename;
     std::string dataDirectory;
 
-    RgbImage rgbImage;
-    SegImage segImage;
-    ColorTable colorTable;                 ///< The actual color table that the user is editing
-    ColorTable tempColorTable;             ///< Temp color table for user to visualize the pixels once before saving
-
-    QRgb segColors[NUM_COLORS];
+    RgbFrame frame;                        ///< The current frame, as packed rgb pixels
+    std::vector<uint8_t> segImage;         ///< Labels of the current frame, row major
+    BlockColorTable colorTable;            ///< The actual color table that the user is editing
+    ColorTablePreview preview;             ///< Pending edits on colorTable for user to visualize the pixels once before committing
+    std::vector<unsigned int> displayedPreviewBlocks;  ///< Blocks of the preview that segImage was last labeled with
+    FrameBinIndex binIndex;                ///< Pixels of frame grouped by color table cell
+    bool binIndexValid;                    ///< Whether binIndex was built for the current frame
+    boost::shared_ptr<const BlockColorTable> tableSnapshot;   ///< Cached result of getTableSnapshot()
+
+    SegmentationWorker worker;
+    SegmentationWorker::ImageLoader pendingLoader;  ///< Loader of the newest request, until its result is shown
+    SegmentationResult spareResult;        ///< Buffers handed back and forth with the worker
+    boost::shared_ptr<const ColorHistogram> frameHistogram;   ///< Histogram of frame, built by the worker
+    boost::shared_ptr<const ColorHistogram> bagHistogram;
+    QLabel *coverageLabel;                 ///< Permanent status bar entry, so messages do not hide it
+
+    EditHistory history;                   ///< Committed edits, for undo and redo
+    BlobDetector blobDetector;
+    std::vector<Blob> displayedBlobs;      ///< Blobs currently outlined on the seg image screens
+    RegionFill regionFill;                 ///< Region selected by the last click of a region brush
+    std::vector<uint32_t> regionCells;     ///< Table cells of that region
+    TrainingSet trainingSamples;           ///< Samples collected in training mode, from any number of frames
+
+    QVector<QRgb> segColors;               ///< Palette used to draw labels, indexed by Color
     std::string segColorNames[NUM_COLORS];
 
     Image imageSelected;
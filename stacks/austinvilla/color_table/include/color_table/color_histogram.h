@@ -0,0 +1,108 @@
+/**
+ * \file  color_histogram.h
+ * \brief Header for the ColorHistogram class, a sparse 3D histogram of
+ * pixels over the color table cells
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 09/07/2011 10:35:18 AM piyushk $
+ */
+
+#ifndef COLOR_HISTOGRAM_W2HN5TJD
+#define COLOR_HISTOGRAM_W2HN5TJD
+
+#include <vector>
+
+#include <color_table/common.h>
+#include <color_table/block_color_table.h>
+
+namespace color_table {
+
+  /**
+   * \class ColorHistogram
+   * \brief Number of pixels falling in each table cell, for the cells that
+   *        hold any
+   *
+   * A frame typically touches a few thousand of the table's cells, so
+   * computing how much of a frame a table labels is a pass over those cells
+   * rather than over the pixels. Histograms of many frames add up to the
+   * histogram of all of them.
+   */
+  class ColorHistogram {
+
+    public:
+
+      ColorHistogram();
+
+      /**
+       * \brief   Replaces the histogram with that of a buffer of pixels
+       */
+      void build(const Rgb *pixels, size_t numPixels);
+
+      /**
+       * \brief   Adds the counts of another histogram to this one
+       */
+      void add(const ColorHistogram &other);
+
+      void clear();
+
+      inline size_t getNumBins() const {
+        return keys.size();
+      }
+
+      inline uint64_t getNumPixels() const {
+        return numPixels;
+      }
+
+      /**
+       * \brief   Cells holding pixels, as BlockColorTable::getCellKey()
+       *          values in ascending order
+       */
+      inline const std::vector<uint32_t>& getKeys() const {
+        return keys;
+      }
+
+      /**
+       * \brief   Number of pixels in each cell of getKeys()
+       */
+      inline const std::vector<uint64_t>& getCounts() const {
+        return counts;
+      }
+
+      /**
+       * \brief   Number of pixels a table assigns to each color
+       * \param   table Any table with a get(r, g, b) function taking cell
+       *          coordinates, indexed by rgb
+       * \param   colorCounts Receives NUM_COLORS entries, one per color.
+       *          The UNDEFINED entry is the unlabeled mass.
+       */
+      template <typename TableT>
+      void getCoverage(const TableT &table, std::vector<uint64_t> &colorCounts) const {
+        colorCounts.assign(NUM_COLORS, 0);
+        const unsigned int mask = BlockColorTable::BLOCK_SIZE - 1;
+        const unsigned int bits = BlockColorTable::BLOCK_BITS;
+        const unsigned int cellBits = 3 * bits;
+        for (size_t i = 0; i < keys.size(); i++) {
+          unsigned int block = keys[i] >> cellBits;
+          unsigned int cell = keys[i] & (BlockColorTable::BLOCK_CELLS - 1);
+          unsigned int r = ((block / (BlockColorTable::BLOCKS_PER_AXIS * BlockColorTable::BLOCKS_PER_AXIS)) << bits) | (cell >> (2 * bits));
+          unsigned int g = (((block / BlockColorTable::BLOCKS_PER_AXIS) % BlockColorTable::BLOCKS_PER_AXIS) << bits) | ((cell >> bits) & mask);
+          unsigned int b = ((block % BlockColorTable::BLOCKS_PER_AXIS) << bits) | (cell & mask);
+          colorCounts[table.get(r, g, b)] += counts[i];
+        }
+      }
+
+    private:
+
+      std::vector<uint32_t> keys;
+      std::vector<uint64_t> counts;           ///< 64 bit, since bag histograms add up every frame
+      uint64_t numPixels;
+
+  };
+
+}
+
+#endif /* end of include guard: COLOR_HISTOGRAM_W2HN5TJD */
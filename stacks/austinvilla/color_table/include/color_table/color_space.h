@@ -0,0 +1,61 @@
+/**
+ * \file  color_space.h
+ * \brief Color spaces a color table can be indexed by, and conversions
+ * between them
+ *
+ * Conversions follow ITU-R BT.601 with full range (0-255) luma and chroma,
+ * which is what the robots' cameras deliver. They use 8 bit fixed point
+ * arithmetic, so that converting whole tables stays cheap.
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 08/25/2011 11:32:48 AM piyushk $
+ */
+
+#ifndef COLOR_SPACE_H8TQ3XWB
+#define COLOR_SPACE_H8TQ3XWB
+
+#include <color_table/common.h>
+
+namespace color_table {
+
+  /**
+   * \brief  Channels a color table is indexed by
+   */
+  enum ColorSpace {
+    COLOR_SPACE_RGB,                ///< Indexed by [r][g][b]
+    COLOR_SPACE_YUV                 ///< Indexed by [y][u][v]
+  };
+
+  namespace detail {
+    inline uint8_t clampChannel(int value) {
+      return (value < 0) ? 0 : ((value > 255) ? 255 : value);
+    }
+  }
+
+  inline Yuv rgbToYuv(const Rgb &rgb) {
+    // Offsetting by 128 << 8 keeps the numerators positive before shifting
+    Yuv yuv;
+    yuv.y = detail::clampChannel((77 * rgb.r + 150 * rgb.g + 29 * rgb.b + 128) >> 8);
+    yuv.u = detail::clampChannel((-43 * rgb.r - 85 * rgb.g + 128 * rgb.b + (128 << 8) + 128) >> 8);
+    yuv.v = detail::clampChannel((128 * rgb.r - 107 * rgb.g - 21 * rgb.b + (128 << 8) + 128) >> 8);
+    return yuv;
+  }
+
+  inline Rgb yuvToRgb(const Yuv &yuv) {
+    int y = yuv.y << 8;
+    int u = yuv.u - 128;
+    int v = yuv.v - 128;
+    Rgb rgb;
+    rgb.r = detail::clampChannel((y + 359 * v + 128) >> 8);
+    rgb.g = detail::clampChannel((y - 88 * u - 183 * v + 128) >> 8);
+    rgb.b = detail::clampChannel((y + 454 * u + 128) >> 8);
+    return rgb;
+  }
+
+}
+
+#endif /* end of include guard: COLOR_SPACE_H8TQ3XWB */
@@ -0,0 +1,228 @@
+/**
+ * \file  color_table.h
+ * \brief Header for the ColorTable class, the runtime representation of a
+ * color lookup table shared by the color table tool, the ground truth
+ * detection system and any other vision node
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 08/17/2011 09:41:27 AM piyushk $
+ */
+
+#ifndef COLOR_TABLE_K2Z8VQ4P
+#define COLOR_TABLE_K2Z8VQ4P
+
+#include <string>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+#include <sensor_msgs/Image.h>
+#include <sensor_msgs/PointCloud2.h>
+
+#include <color_table/common.h>
+#include <color_table/color_space.h>
+#include <color_table/segmentation.h>
+#include <color_table/table_file.h>
+
+namespace color_table {
+
+  /**
+   * \struct ColorStatistics
+   * \brief  Summary of the table cells assigned to a single color
+   */
+  struct ColorStatistics {
+    unsigned int numCells;          ///< Number of table cells assigned to the color
+    Rgb minRgb;                     ///< Lower corner of the rgb bounding box of these cells
+    Rgb maxRgb;                     ///< Upper corner of the rgb bounding box of these cells
+    float meanR, meanG, meanB;      ///< Mean rgb value of these cells
+  };
+
+  /**
+   * \class ColorTable
+   * \brief A lookup table from rgb values to colors, along with helper
+   *        functions to load, save and validate the table, and to segment
+   *        images and point clouds with it
+   *
+   * The table has COLOR_TABLE_BITS bits per channel (128x128x128 cells by
+   * default). Tables saved at a different resolution are resampled on load.
+   *
+   * A table is indexed either by rgb or by yuv values (see ColorSpace). Yuv
+   * tables classify YUV 4:2:2 camera images directly; convert() switches a
+   * table between the two once, so that no per pixel conversion is needed.
+   */
+  class ColorTable {
+
+    public:
+
+      static const unsigned int NUM_CELLS = Resolution::NUM_CELLS;
+
+      /**
+       * \brief   Constructs a table with every cell set to UNDEFINED
+       */
+      ColorTable();
+
+      ColorTable(const ColorTable &other);
+      ColorTable& operator=(const ColorTable &other);
+
+      /**
+       * \brief   Loads the table from file. The table is left untouched on failure.
+       *
+       * Both legacy raw tables and version 2 tables are supported (see
+       * table_file.h). The file is read whole and decoded into memory owned
+       * by the table. A version 2 table is a few tens of kilobytes, so this
+       * is much faster than reading a raw 2 MB dump.
+       *
+       * \param   filename Path of the .col file
+       * \param   error If not NULL, receives a description of the failure
+       * \param   callerBits Leave to the default. It is evaluated where load()
+       *          is called, which lets the library check that the caller was
+       *          built with the same COLOR_TABLE_BITS.
+       * \return  true if the table was loaded and validated successfully
+       */
+      bool load(const std::string &filename, std::string *error = NULL,
+          unsigned int callerBits = COLOR_TABLE_BITS);
+
+      /**
+       * \brief   Saves the table to file. The file is replaced atomically, so
+       *          that other processes never load a partially written table.
+       * \param   format FORMAT_V2 (default), or FORMAT_RAW for old readers
+       * \return  true if the table was written successfully
+       */
+      bool save(const std::string &filename, std::string *error = NULL, TableFileFormat format = FORMAT_V2) const;
+
+      /**
+       * \brief   Checks that every cell holds a valid color
+       */
+      bool isValid() const;
+
+      /**
+       * \brief   Sets every cell to UNDEFINED. The color space is unchanged.
+       */
+      void clear();
+
+      inline ColorSpace getColorSpace() const {
+        return colorSpace;
+      }
+
+      /**
+       * \brief   Re-indexes the table by another color space. Each cell takes
+       *          the color of the value at its center in the old table.
+       */
+      void convert(ColorSpace space);
+
+      /**
+       * \brief   Returns the color for a value in the table's color space
+       *          (r, g, b for rgb tables and y, u, v for yuv tables)
+       */
+      inline uint8_t classify(uint8_t r, uint8_t g, uint8_t b) const {
+        return (*table)[Resolution::toCell(r)][Resolution::toCell(g)][Resolution::toCell(b)];
+      }
+
+      /**
+       * \brief   Access to an individual cell, indexed by cell (not rgb) coordinates
+       */
+      inline uint8_t& cell(unsigned int r, unsigned int g, unsigned int b) {
+        return (*table)[r][g][b];
+      }
+      inline uint8_t cell(unsigned int r, unsigned int g, unsigned int b) const {
+        return (*table)[r][g][b];
+      }
+
+      /**
+       * \brief   Raw access to the table, as used by the segmentation kernel
+       */
+      inline const ColorTableArray& getArray() const {
+        return *table;
+      }
+      inline ColorTableArray& getArray() {
+        return *table;
+      }
+
+      /**
+       * \brief   Segments a buffer of pixels. See segmentPixels() for details.
+       */
+      inline void segment(const uint8_t *src, unsigned int width, unsigned int height,
+          size_t srcStep, const PixelLayout &layout, uint8_t *labels, size_t labelStep) const {
+        segmentPixels(*table, src, width, height, srcStep, layout, labels, labelStep);
+      }
+
+      /**
+       * \brief   Segments a YUV 4:2:2 buffer with a yuv table. See
+       *          segmentYuv422Pixels() for details.
+       */
+      inline void segmentYuv422(const uint8_t *src, unsigned int width, unsigned int height,
+          size_t srcStep, const Yuv422Layout &layout, uint8_t *labels, size_t labelStep) const {
+        segmentYuv422Pixels(*table, src, width, height, srcStep, layout, labels, labelStep);
+      }
+
+      /**
+       * \brief   Segments an image message. Rgb tables take rgb8, bgr8, rgba8
+       *          or bgra8 images, and yuv tables take yuv422 (uyvy) or yuyv
+       *          images.
+       * \param   labels Receives width * height labels in row major order
+       * \return  false if the image encoding does not match the table, or
+       *          the data is smaller than the size and step require
+       */
+      bool segmentImage(const sensor_msgs::Image &image, std::vector<uint8_t> &labels) const;
+
+      /**
+       * \brief   Segments a point cloud message straight from its data buffer
+       * \param   labels Receives one label per point
+       * \return  false if the cloud does not have an rgb field, the table
+       *          is not rgb indexed, or the data is smaller than the size
+       *          and steps require
+       */
+      bool segmentPointCloud(const sensor_msgs::PointCloud2 &cloud, std::vector<uint8_t> &labels) const;
+
+      /**
+       * \brief   Segments a pcl::PointCloud of any point type with a packed
+       *          rgb field (such as pcl::PointXYZRGB)
+       * \param   labels Receives one label per point
+       * \return  false if the table is not rgb indexed
+       */
+      template <typename PointCloudT>
+      bool segmentPointCloud(const PointCloudT &cloud, std::vector<uint8_t> &labels) const {
+        if (colorSpace != COLOR_SPACE_RGB)
+          return false;
+        labels.resize(cloud.points.size());
+        if (cloud.points.size() == 0)
+          return true;
+        const uint8_t *first = reinterpret_cast<const uint8_t*>(&cloud.points[0]);
+        unsigned int rgbOffset = reinterpret_cast<const uint8_t*>(&cloud.points[0].rgb) - first;
+        segment(first, cloud.points.size(), 1, 0,
+            getPackedRgbLayout(sizeof(cloud.points[0]), rgbOffset), &labels[0], 0);
+        return true;
+      }
+
+      /**
+       * \brief   Computes per color statistics over the table cells. For yuv
+       *          tables the bounds and means are y, u, v values.
+       * \param   stats Receives NUM_COLORS entries, one per color
+       */
+      void getStatistics(std::vector<ColorStatistics> &stats) const;
+
+      /**
+       * \brief   Counts the number of occurences of each color in a label buffer
+       * \param   counts Receives NUM_COLORS entries, one per color
+       */
+      static void countLabels(const uint8_t *labels, size_t numLabels, std::vector<unsigned int> &counts);
+
+    private:
+
+      boost::shared_ptr<void> storage;  ///< Owner of the memory table points into
+      ColorTableArray *table;           ///< The table itself
+      ColorSpace colorSpace;            ///< Channels the table is indexed by
+
+      /**
+       * \brief   Replaces the storage with a fresh heap allocation
+       */
+      void allocate();
+
+  };
+
+}
+
+#endif /* end of include guard: COLOR_TABLE_K2Z8VQ4P */
@@ -15,6 +15,19 @@
 #define COMMON_29E2EKDP
 
 #include <stdint.h>
+#include <color_table/table_resolution.h>
+
+/**
+ * Number of bits per channel used to index the color table (5 to 8). A 6 bit
+ * table (256 KB) stays in the L2 cache, while an 8 bit table (16 MB) does not
+ * lose any precision. All packages using color_table have to be built with
+ * the same value: it is set in CMakeLists.txt and exported through the
+ * manifest cflags, and ColorTable::load() fails if the caller was built with
+ * a different value than the library.
+ */
+#ifndef COLOR_TABLE_BITS
+#define COLOR_TABLE_BITS 7
+#endif
 
 namespace color_table {
 
@@ -30,7 +43,9 @@ namespace color_table {
     uint8_t v;
   };
 
-  typedef uint8_t ColorTable[128][128][128];
+  typedef TableResolution<COLOR_TABLE_BITS> Resolution;
+
+  typedef uint8_t ColorTableArray[Resolution::SIZE][Resolution::SIZE][Resolution::SIZE];
 
   enum Color {
     UNDEFINED,
@@ -0,0 +1,118 @@
+/**
+ * \file  edit_history.h
+ * \brief Header for the undo/redo history of color table edits
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 08/23/2011 02:37:15 PM piyushk $
+ */
+
+#ifndef EDIT_HISTORY_N3GQ8ASD
+#define EDIT_HISTORY_N3GQ8ASD
+
+#include <deque>
+#include <vector>
+
+#include <color_table/block_color_table.h>
+
+namespace color_table {
+
+  /**
+   * \class EditHistory
+   * \brief Journal of committed color table edits, for undo and redo
+   *
+   * Each edit is stored as a delta: runs of consecutive changed cells, along
+   * with their labels before and after the edit (about 2 bytes per changed
+   * cell). There is no limit on the number of edits, but once the journal
+   * grows past its memory budget the oldest edits are forgotten.
+   */
+  class EditHistory {
+
+    public:
+
+      /**
+       * \param   memoryBudget Maximum number of bytes used by the journal
+       */
+      explicit EditHistory(size_t memoryBudget = 64 * 1024 * 1024);
+
+      /**
+       * \brief   Records the edits in a preview. Must be called before the
+       *          preview is committed. Clears the redo history.
+       * \return  false if the preview did not change any cell
+       */
+      bool record(const ColorTablePreview &preview);
+
+      /**
+       * \brief   Writes the cells changed by the last edit back to their old
+       *          labels into preview, which the caller then commits
+       * \return  false if there is nothing to undo
+       */
+      bool undo(ColorTablePreview &preview);
+
+      /**
+       * \brief   Writes the cells of the last undone edit to their new labels
+       *          into preview, which the caller then commits
+       * \return  false if there is nothing to redo
+       */
+      bool redo(ColorTablePreview &preview);
+
+      inline bool canUndo() const {
+        return !undoEdits.empty();
+      }
+
+      inline bool canRedo() const {
+        return !redoEdits.empty();
+      }
+
+      inline size_t getNumUndo() const {
+        return undoEdits.size();
+      }
+
+      inline size_t getMemoryUsage() const {
+        return memoryUsage;
+      }
+
+      /**
+       * \brief   Forgets all edits (for instance, after loading a new table)
+       */
+      void clear();
+
+    private:
+
+      /**
+       * \struct CellRun
+       * \brief  Consecutive changed cells inside a block
+       */
+      struct CellRun {
+        uint16_t block;
+        uint16_t firstCell;
+        uint16_t numCells;
+        uint32_t labelOffset;         ///< Offset of the labels of this run in Edit::oldLabels / newLabels
+      };
+
+      struct Edit {
+        std::vector<CellRun> runs;
+        std::vector<uint8_t> oldLabels;
+        std::vector<uint8_t> newLabels;
+
+        size_t getMemoryUsage() const {
+          return sizeof(Edit) + runs.capacity() * sizeof(CellRun) + oldLabels.capacity() + newLabels.capacity();
+        }
+      };
+
+      void apply(const Edit &edit, bool useNewLabels, ColorTablePreview &preview);
+      void enforceBudget();
+
+      std::deque<Edit> undoEdits;     ///< Oldest edit first
+      std::vector<Edit> redoEdits;    ///< Most recently undone edit last
+      size_t memoryBudget;
+      size_t memoryUsage;
+
+  };
+
+}
+
+#endif /* end of include guard: EDIT_HISTORY_N3GQ8ASD */
@@ -0,0 +1,105 @@
+/**
+ * \file  filmstrip_widget.h
+ * \brief Header for the FilmstripWidget class, a timeline of thumbnails
+ * under the frame slider
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 09/08/2011 01:37:12 PM piyushk $
+ */
+
+#ifndef FILMSTRIP_WIDGET_W7NC2HDX
+#define FILMSTRIP_WIDGET_W7NC2HDX
+
+#include <vector>
+
+#include <QWidget>
+#include <QTimer>
+
+#include <boost/shared_ptr.hpp>
+
+#include <color_table/block_color_table.h>
+#include <color_table/thumbnail_loader.h>
+
+class QPaintEvent;
+
+namespace color_table {
+
+  /**
+   * \class FilmstripWidget
+   * \brief Shows the frames of a bag as a row of thumbnails, with a
+   *        sparkline of the table's coverage of each frame below them
+   *
+   * Every column of the widget stands for one frame. The thumbnails shown
+   * are those of the columns at the middle of each slot, and the sparkline
+   * has one bar per column. Thumbnails are requested from the loader slots
+   * first, then columns coarse to fine, so that the whole bag is sketched
+   * before it is filled in. The coverage is worked out by the loader's
+   * workers, and painting only draws the values they have so far.
+   */
+  class FilmstripWidget : public QWidget {
+  Q_OBJECT
+
+    public:
+      FilmstripWidget(QWidget *parent);
+
+      /**
+       * \brief Sets where thumbnails come from. The loader has to outlive
+       *        the widget.
+       */
+      void setLoader(ThumbnailLoader *loader);
+
+      /**
+       * \brief Sets the number of frames of the bag, 0 to clear the strip
+       */
+      void setNumFrames(size_t numFrames);
+
+      void setCurrentFrame(size_t frame);
+
+      /**
+       * \brief Sets the table whose coverage is plotted. The plot is only
+       *        redone once the table stops changing for a moment.
+       */
+      void setColorTable(const boost::shared_ptr<const BlockColorTable> &table);
+
+      void paintEvent(QPaintEvent *event);
+      void resizeEvent(QResizeEvent *event);
+      void mousePressEvent(QMouseEvent *event);
+      void mouseMoveEvent(QMouseEvent *event);
+
+    signals:
+      void frameSelected(int frame);
+
+    private slots:
+      void pollLoader();
+      void applyColorTable();
+
+    private:
+
+      /**
+       * \brief Frame under a column of the widget
+       */
+      size_t getFrame(int x) const;
+
+      /**
+       * \brief Requests the thumbnails of all frames on screen again
+       */
+      void requestThumbnails();
+
+      ThumbnailLoader *loader;
+      size_t numFrames;
+      size_t currentFrame;
+
+      boost::shared_ptr<const BlockColorTable> table;
+      boost::shared_ptr<const BlockColorTable> nextTable;  ///< Handed to the loader when tableTimer fires
+
+      QTimer pollTimer;                       ///< Polls the loader while it is busy
+      QTimer tableTimer;
+  };
+
+}
+
+#endif /* end of include guard: FILMSTRIP_WIDGET_W7NC2HDX */
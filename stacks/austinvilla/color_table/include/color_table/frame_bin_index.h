@@ -0,0 +1,96 @@
+/**
+ * \file  frame_bin_index.h
+ * \brief Header for an index from color table cells to the pixels of a frame
+ * that fall into them, used to re-segment only what an edit can change
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 08/22/2011 10:18:26 AM piyushk $
+ */
+
+#ifndef FRAME_BIN_INDEX_P1MH6VXE
+#define FRAME_BIN_INDEX_P1MH6VXE
+
+#include <vector>
+
+#include <color_table/common.h>
+#include <color_table/block_color_table.h>
+
+namespace color_table {
+
+  /**
+   * \class FrameBinIndex
+   * \brief Groups the pixels of a frame by the color table cell (bin) they
+   *        fall into, with the bins grouped by BlockColorTable block
+   *
+   * After an edit to a set of blocks, relabel() looks up each bin in those
+   * blocks once and updates only the pixels in them, instead of segmenting
+   * the whole frame again.
+   */
+  class FrameBinIndex {
+
+    public:
+
+      /**
+       * \brief   Builds the index for a new frame
+       */
+      void build(const Rgb *pixels, size_t numPixels);
+
+      /**
+       * \brief   Relabels the pixels whose bins lie in the given blocks
+       * \param   blocks Block indices (see BlockColorTable::getBlockIndex())
+       * \param   table Any table with a get(r, g, b) function taking cell coordinates
+       * \param   labels The labels of the frame, updated in place
+       * \param   changedPixels Receives the indices of the pixels whose label changed
+       */
+      template <typename TableT>
+      void relabel(const std::vector<unsigned int> &blocks, const TableT &table,
+          uint8_t *labels, std::vector<unsigned int> &changedPixels) const {
+        changedPixels.clear();
+        if (blockStarts.empty())
+          return;
+        const unsigned int mask = BlockColorTable::BLOCK_SIZE - 1;
+        const unsigned int bits = BlockColorTable::BLOCK_BITS;
+        for (unsigned int i = 0; i < blocks.size(); i++) {
+          unsigned int block = blocks[i];
+          unsigned int r0 = (block / (BlockColorTable::BLOCKS_PER_AXIS * BlockColorTable::BLOCKS_PER_AXIS)) << bits;
+          unsigned int g0 = ((block / BlockColorTable::BLOCKS_PER_AXIS) % BlockColorTable::BLOCKS_PER_AXIS) << bits;
+          unsigned int b0 = (block % BlockColorTable::BLOCKS_PER_AXIS) << bits;
+          for (unsigned int bin = blockStarts[block]; bin < blockStarts[block + 1]; bin++) {
+            unsigned int cell = binCells[bin];
+            uint8_t label = table.get(r0 | (cell >> (2 * bits)), g0 | ((cell >> bits) & mask), b0 | (cell & mask));
+            for (unsigned int p = binStarts[bin]; p < binStarts[bin + 1]; p++) {
+              unsigned int pixel = pixels[p];
+              if (labels[pixel] != label) {
+                labels[pixel] = label;
+                changedPixels.push_back(pixel);
+              }
+            }
+          }
+        }
+      }
+
+      /**
+       * \brief   Number of distinct bins used by the frame
+       */
+      inline size_t getNumBins() const {
+        return binCells.size();
+      }
+
+    private:
+
+      std::vector<unsigned int> pixels;       ///< Pixel indices, sorted by block and then by cell
+      std::vector<unsigned int> binStarts;    ///< Start of each bin in pixels, plus one end marker
+      std::vector<uint16_t> binCells;         ///< Cell index (inside its block) of each bin
+      std::vector<unsigned int> blockStarts;  ///< First bin of each block, plus one end marker
+
+      std::vector<unsigned int> keys;         ///< Scratch space for build()
+      std::vector<unsigned int> scratch;      ///< Scratch space for build()
+  };
+
+}
+
+#endif /* end of include guard: FRAME_BIN_INDEX_P1MH6VXE */
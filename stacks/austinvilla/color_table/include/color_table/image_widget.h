@@ -1,6 +1,6 @@
 /**
  * \file  image_widget.h
- * \brief Header for a separate ImageWidget to control 
+ * \brief Header for a separate ImageWidget to control
  * images in the gui window effectively
  *
  * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
@@ -15,10 +15,17 @@
 #ifndef IMAGE_WIDGET_MERDB9QX
 #define IMAGE_WIDGET_MERDB9QX
 
+#include <vector>
+
 #include <QWidget>
 #include <QImage>
+#include <QRect>
+#include <QVector>
+
+#include <color_table/common.h>
 
 class QPaintEvent;
+class QResizeEvent;
 
 namespace color_table {
 
@@ -26,23 +33,71 @@ namespace color_table {
    * \class ImageWidget
    * \brief ImageWidget adds additional functionality to a standard widget
    *        such as obtaining mouse click events and easy repaint
+   *
+   * The widget draws straight from the caller's rgb or label buffer, without
+   * a per pixel copy. A thumbnail widget instead keeps a copy downsampled to
+   * its own size, built once per call to showRgb() or showLabels() and again
+   * when the widget is resized, so that it does not have to scale the full
+   * image on every paint.
    */
   class ImageWidget : public QWidget {
   Q_OBJECT
-      
+
     public:
      ImageWidget(QWidget *parent);
-     void reduceImageSize(int factor);
+
+     /**
+      * \brief Makes the widget keep a copy of the image downsampled to the
+      *        size of the widget, instead of referring to the full image
+      */
+     void setThumbnail(bool thumbnail);
+
+     /**
+      * \brief Shows a packed array of rgb pixels. The buffer is not copied
+      *        and has to stay valid until the next call to showRgb() or
+      *        showLabels() (thumbnails are rebuilt from it on resize).
+      */
+     void showRgb(const Rgb *pixels, unsigned int width, unsigned int height);
+
+     /**
+      * \brief Shows an array of labels (one byte per pixel), drawing each
+      *        label with its color from the palette. The same lifetime rule
+      *        as showRgb() applies.
+      */
+     void showLabels(const uint8_t *labels, unsigned int width, unsigned int height, const QVector<QRgb> &palette);
+
+     /**
+      * \brief Outlines a set of rectangles (in image coordinates) on top of
+      *        the image
+      */
+     void setBoxes(const std::vector<QRect> &boxes, QRgb color);
 
      void paintEvent(QPaintEvent *event);
+     void resizeEvent(QResizeEvent *event);
      void mousePressEvent(QMouseEvent *event);
      void mouseMoveEvent(QMouseEvent *event);
-    
-    QImage* img;
-     
+
     signals:
       void clicked(int x, int y, int button);
       void mouseXY(int x, int y);
+
+    private:
+
+      /**
+       * \brief Rebuilds the thumbnail from the buffer being shown
+       */
+      void downsampleRgb();
+      void downsampleLabels();
+
+      QImage img;                     ///< Wraps the caller's buffer, or holds the thumbnail
+      const Rgb *rgbPixels;           ///< Buffer being shown, if it is an rgb one
+      const uint8_t *labels;          ///< Buffer being shown, if it is a label one
+      QVector<QRgb> palette;
+      bool thumbnail;
+      unsigned int imageWidth;        ///< Size of the full image, for mapping clicks and boxes
+      unsigned int imageHeight;
+      std::vector<QRect> boxes;
+      QRgb boxColor;
   };
 
 }
@@ -0,0 +1,108 @@
+/**
+ * \file  live_camera_source.h
+ * \brief Header for the LiveCameraSource class, which feeds the newest frame
+ * of a camera topic to the color table tool
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 09/01/2011 10:12:50 AM piyushk $
+ */
+
+#ifndef LIVE_CAMERA_SOURCE_R5TB3XQW
+#define LIVE_CAMERA_SOURCE_R5TB3XQW
+
+#include <string>
+
+#include <QObject>
+
+#include <ros/ros.h>
+#include <ros/callback_queue.h>
+#include <image_transport/image_transport.h>
+#include <sensor_msgs/Image.h>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread.hpp>
+
+namespace color_table {
+
+  /**
+   * \class LiveCameraSource
+   * \brief Subscribes to a camera topic on its own thread, and hands the
+   *        newest frame to the gui
+   *
+   * Incoming images are held in a single slot where a newer frame replaces
+   * an older one that the gui did not take yet. When the camera outruns the
+   * gui, frames are dropped instead of queueing up. The gui passes the
+   * frames on to the SegmentationWorker, which drops frames the same way if
+   * the segmentation falls behind.
+   */
+  class LiveCameraSource : public QObject {
+  Q_OBJECT
+
+    public:
+
+      LiveCameraSource(QObject *parent = 0);
+      ~LiveCameraSource();
+
+      /**
+       * \brief   Subscribes to a camera topic
+       * \param   error If not NULL, receives a description of the failure
+       * \return  false if the ros master cannot be reached
+       */
+      bool start(const std::string &topic, std::string *error = NULL);
+
+      /**
+       * \brief   Unsubscribes and stops the subscriber thread
+       */
+      void stop();
+
+      inline bool isRunning() const {
+        return spinThread.get() != NULL;
+      }
+
+      /**
+       * \brief   Takes the newest frame
+       * \return  NULL if no frame arrived since the last call
+       */
+      sensor_msgs::ImageConstPtr takeImage();
+
+      /**
+       * \brief   Number of frames received, and how many of them were
+       *          replaced by a newer frame before the gui took them
+       */
+      void getCounts(size_t &numReceived, size_t &numDropped);
+
+    signals:
+
+      /**
+       * \brief   Emitted from the subscriber thread when a frame arrives,
+       *          at most once until takeImage() is called
+       */
+      void imageReady();
+
+    private:
+
+      void imageCallback(const sensor_msgs::ImageConstPtr &image);
+      void spin();
+
+      boost::scoped_ptr<ros::NodeHandle> nodeHandle;
+      ros::CallbackQueue callbackQueue;               ///< Keeps the subscription off the global queue
+      image_transport::Subscriber subscriber;
+
+      boost::mutex mutex;                             ///< Protects everything below
+      sensor_msgs::ImageConstPtr pendingImage;        ///< Newest image not yet taken by the gui
+      bool notified;                                  ///< Whether imageReady() was emitted since the last takeImage()
+      bool stopping;
+      size_t numReceived;
+      size_t numDropped;
+
+      boost::scoped_ptr<boost::thread> spinThread;
+
+  };
+
+}
+
+#endif /* end of include guard: LIVE_CAMERA_SOURCE_R5TB3XQW */
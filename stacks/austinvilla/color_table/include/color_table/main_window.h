@@ -18,9 +18,14 @@
 #define MAIN_WINDOW_D9KV76TW
 
 #include <QtGui/QMainWindow>
+#include <QtCore/QTimer>
 #include <sensor_msgs/Image.h>
 
+#include <color_table/bag_frame_source.h>
+#include <color_table/bag_histogram.h>
 #include <color_table/classification_window.h>
+#include <color_table/live_camera_source.h>
+#include <color_table/thumbnail_loader.h>
 #include "ui_main_window.h"
 
 namespace color_table {
@@ -66,11 +71,68 @@ namespace color_table {
     void on_currentFrameSpin_valueChanged(int value);
     void on_frameSlider_sliderMoved(int value);
 
+    /**
+     * \brief  Polls the bag being indexed, and extends the frame controls
+     *         as frames become available
+     */
+    void updateIndexProgress();
+
+    /**
+     * \brief  Starts or stops segmenting frames from a camera topic
+     */
+    void on_actionLive_Camera_toggled(bool checked);
+
+    /**
+     * \brief  Hands the newest camera frame to the classification window
+     */
+    void showLiveFrame();
+
+    /**
+     * \brief  Starts adding up the histograms of all frames of the bag, for
+     *         the coverage shown by the classification window
+     */
+    void on_actionBag_Coverage_triggered();
+
+    /**
+     * \brief  Polls the bag histogram while it is being built
+     */
+    void updateCoverageProgress();
+
+    /**
+     * \brief  Plots the coverage of the edited table on the filmstrip
+     */
+    void updateFilmstripTable();
+
   private:
+
+      /**
+       * \brief  Sets the range of the frame controls to the frames indexed so far
+       */
+      void updateFrameRange(size_t numFrames);
+
+      /**
+       * \brief  Stops everything that reads from the bag, before it is
+       *         closed or replaced
+       */
+      void stopBagReaders();
+
       Ui::ClassificationTool ui;
+
+      // Declared before classWindow, so that it outlives the segmentation
+      // worker that decodes its frames
+      BagFrameSource frames;            ///< Frames of the current bag file, loaded on demand
+      ThumbnailLoader thumbnails;       ///< Thumbnails of frames for the filmstrip
       ClassificationWindow classWindow;
 
-      std::vector<sensor_msgs::ImageConstPtr> images;  ///< Current array of images retrieved from the bag file
+      QTimer indexTimer;                ///< Polls the frame source while the bag is being indexed
+      bool firstFrameShown;
+
+      BagHistogram bagHistogram;        ///< Histogram of all frames of the bag, for its coverage
+      QTimer coverageTimer;             ///< Polls bagHistogram while it is being built
+
+      LiveCameraSource liveSource;
+      ros::WallTime lastLiveStatus;     ///< When the frame rate was last shown in the status bar
+      size_t lastLiveCount;
   };
 
 } 
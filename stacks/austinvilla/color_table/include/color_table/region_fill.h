@@ -0,0 +1,83 @@
+/**
+ * \file  region_fill.h
+ * \brief Header for the RegionFill class, which selects a connected image
+ * region for the region brush
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 09/06/2011 02:21:40 PM piyushk $
+ */
+
+#ifndef REGION_FILL_C7XK2PBN
+#define REGION_FILL_C7XK2PBN
+
+#include <vector>
+
+#include <color_table/common.h>
+
+namespace color_table {
+
+  /**
+   * \class RegionFill
+   * \brief Flood fills the 4-connected region around a seed pixel, and
+   *        collects the table cells its pixels fall in
+   *
+   * Buffers are kept between calls, so selecting regions on frames of the
+   * same size does not allocate.
+   */
+  class RegionFill {
+
+    public:
+
+      /**
+       * \brief  Which neighbors join the region
+       */
+      enum Criterion {
+        SIMILAR_COLOR,    ///< Pixels whose color is close to the neighbor they are reached from
+        SAME_LABEL        ///< Pixels with the same label as the seed
+      };
+
+      /**
+       * \brief   Selects the region around pixel (x, y)
+       * \param   labels Only used with SAME_LABEL
+       * \param   tolerance SIMILAR_COLOR: largest difference in any channel
+       *          between neighboring pixels of the region. Pixels also have
+       *          to stay within twice that of the seed, so that a smooth
+       *          gradient does not leak across the whole frame.
+       * \return  Number of pixels in the region
+       */
+      size_t fill(const Rgb *pixels, const uint8_t *labels, unsigned int width, unsigned int height,
+          unsigned int x, unsigned int y, Criterion criterion, unsigned int tolerance);
+
+      /**
+       * \brief   Indices of the pixels of the last region, in no particular order
+       */
+      inline const std::vector<uint32_t>& getRegion() const {
+        return region;
+      }
+
+      /**
+       * \brief   Histogram of the table cells of the last region
+       * \param   pixels The pixels the region was selected on
+       * \param   minCount Cells holding fewer of the region's pixels are left
+       *          out (mixed pixels along the region's border)
+       * \param   cellKeys Receives the cells as BlockColorTable::getCellKey()
+       *          values in ascending order, ready for ColorTablePreview::setCells()
+       */
+      void getCells(const Rgb *pixels, unsigned int minCount, std::vector<uint32_t> &cellKeys);
+
+    private:
+
+      std::vector<uint32_t> region;
+      std::vector<uint32_t> stack;            ///< Pixels reached but not expanded yet
+      std::vector<uint8_t> visited;           ///< One flag per pixel of the frame
+      std::vector<uint32_t> keys;             ///< Scratch space for getCells()
+
+  };
+
+}
+
+#endif /* end of include guard: REGION_FILL_C7XK2PBN */
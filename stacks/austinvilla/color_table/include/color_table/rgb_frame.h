@@ -0,0 +1,108 @@
+/**
+ * \file  rgb_frame.h
+ * \brief Header for converting image messages of any common encoding,
+ * resolution and row step into a packed array of rgb pixels
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 08/31/2011 10:05:44 AM piyushk $
+ */
+
+#ifndef RGB_FRAME_K2WQ8NVE
+#define RGB_FRAME_K2WQ8NVE
+
+#include <string>
+#include <vector>
+#include <sensor_msgs/Image.h>
+
+#include <color_table/common.h>
+
+namespace color_table {
+
+  /**
+   * \class RgbFrame
+   * \brief A frame as a packed, row major array of rgb pixels
+   *
+   * Supports rgb8, bgr8, rgba8, bgra8, mono8, yuv422 (uyvy), yuyv and the
+   * 4 bayer 8 bit encodings, with any row step. Packed rgb8 messages are
+   * wrapped without copying; everything else is converted into a buffer
+   * that is reused from frame to frame. 320x240, 640x480 and 1280x1024
+   * frames are converted by kernels specialized for their size.
+   */
+  class RgbFrame {
+
+    public:
+
+      RgbFrame();
+
+      /**
+       * \brief   Makes this frame show an image message. The message is kept
+       *          alive for as long as the frame refers to it.
+       * \param   error If not NULL, receives a description of the failure
+       * \return  false if the encoding is not supported or the message is
+       *          malformed, in which case the frame is left empty
+       */
+      bool assign(const sensor_msgs::ImageConstPtr &image, std::string *error = NULL);
+
+      /**
+       * \brief   Empties the frame, releasing the message
+       */
+      void clear();
+
+      /**
+       * \brief   Exchanges the contents of 2 frames, without copying pixels
+       */
+      void swap(RgbFrame &other);
+
+      /**
+       * \brief   Whether assign() can handle a given encoding
+       */
+      static bool isSupportedEncoding(const std::string &encoding);
+
+      inline const Rgb* getPixels() const {
+        return pixels;
+      }
+
+      inline const Rgb& at(unsigned int x, unsigned int y) const {
+        return pixels[y * width + x];
+      }
+
+      inline unsigned int getWidth() const {
+        return width;
+      }
+
+      inline unsigned int getHeight() const {
+        return height;
+      }
+
+      inline size_t getNumPixels() const {
+        return (size_t)width * height;
+      }
+
+      inline bool empty() const {
+        return getNumPixels() == 0;
+      }
+
+      /**
+       * \brief   Whether the pixels point straight into the message's buffer
+       */
+      inline bool isWrapped() const {
+        return image && pixels != (buffer.empty() ? NULL : &buffer[0]);
+      }
+
+    private:
+
+      sensor_msgs::ImageConstPtr image;   ///< Message the frame was made from
+      std::vector<Rgb> buffer;            ///< Converted pixels, unless the message is wrapped
+      const Rgb *pixels;
+      unsigned int width;
+      unsigned int height;
+
+  };
+
+}
+
+#endif /* end of include guard: RGB_FRAME_K2WQ8NVE */
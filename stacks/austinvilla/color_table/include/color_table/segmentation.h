@@ -0,0 +1,136 @@
+/**
+ * \file  segmentation.h
+ * \brief Declares the color table segmentation kernel shared by the color
+ * table tool and the ground truth detection system
+ *
+ * The kernel takes an arbitrary-stride buffer of pixels (or points), looks up
+ * each pixel in a color table and writes out a buffer of labels. A second
+ * kernel classifies YUV 4:2:2 images directly with a YUV indexed table. Depending on
+ * the cpu the code is running on, an SSE2, SSSE3 or AVX2 implementation is
+ * selected at runtime, with a plain scalar loop as the fallback.
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 08/16/2011 10:12:35 AM piyushk $
+ */
+
+#ifndef SEGMENTATION_Q3KX7B2M
+#define SEGMENTATION_Q3KX7B2M
+
+#include <cstddef>
+#include <color_table/common.h>
+
+namespace color_table {
+
+  /**
+   * \struct PixelLayout
+   * \brief  Describes where the color channels of a single pixel live in
+   *         memory, relative to the start of the pixel
+   *
+   * All 3 channels need to lie within 4 consecutive bytes, which is true for
+   * all packed image encodings as well as the packed rgb field of a pcl point.
+   */
+  struct PixelLayout {
+    unsigned int pixelStride;       ///< Number of bytes between 2 consecutive pixels in a row
+    unsigned int rOffset;           ///< Offset of the red byte inside a pixel
+    unsigned int gOffset;           ///< Offset of the green byte inside a pixel
+    unsigned int bOffset;           ///< Offset of the blue byte inside a pixel
+  };
+
+  const PixelLayout RGB8_LAYOUT = {3, 0, 1, 2};
+  const PixelLayout BGR8_LAYOUT = {3, 2, 1, 0};
+  const PixelLayout RGBA8_LAYOUT = {4, 0, 1, 2};
+  const PixelLayout BGRA8_LAYOUT = {4, 2, 1, 0};
+
+  /**
+   * \brief  Layout of a point type with a packed float rgb field (such as
+   *         pcl::PointXYZRGB), given the size of the point and the offset of
+   *         the rgb field inside it
+   */
+  inline PixelLayout getPackedRgbLayout(unsigned int pointSize, unsigned int rgbOffset) {
+    // rgb is packed as 0x00RRGGBB, i.e. b g r 0 on a little endian machine
+    PixelLayout layout = {pointSize, rgbOffset + 2, rgbOffset + 1, rgbOffset};
+    return layout;
+  }
+
+  /**
+   * \struct Yuv422Layout
+   * \brief  Describes a YUV 4:2:2 macropixel: 4 bytes holding 2 pixels that
+   *         share their u and v samples
+   */
+  struct Yuv422Layout {
+    unsigned int y0Offset;          ///< Offset of the luma byte of the first pixel
+    unsigned int y1Offset;          ///< Offset of the luma byte of the second pixel
+    unsigned int uOffset;           ///< Offset of the shared u byte
+    unsigned int vOffset;           ///< Offset of the shared v byte
+  };
+
+  const Yuv422Layout YUYV_LAYOUT = {0, 2, 1, 3};
+  const Yuv422Layout UYVY_LAYOUT = {1, 3, 0, 2};   ///< The ROS "yuv422" encoding
+
+  /**
+   * \brief  Instruction set extensions that the segmentation kernel can use
+   */
+  enum SimdLevel {
+    SIMD_NONE,
+    SIMD_SSE2,
+    SIMD_SSSE3,
+    SIMD_AVX2
+  };
+
+  /**
+   * \brief   Returns the instruction set used by segmentPixels(). Detected
+   *          from the cpu on first use.
+   */
+  SimdLevel getSimdLevel();
+
+  /**
+   * \brief   Restricts the kernel to a given instruction set (useful for
+   *          benchmarking and debugging). Levels not supported by the cpu are
+   *          clamped to the best supported level.
+   */
+  void setSimdLevel(SimdLevel level);
+
+  /**
+   * \brief   Human readable name of a SimdLevel, for log messages
+   */
+  const char* getSimdLevelName(SimdLevel level);
+
+  /**
+   * \brief   Segments a buffer of pixels using the specified color table
+   * \param   table The color table used for classification
+   * \param   src Pointer to the first pixel of the first row
+   * \param   width Number of pixels in a row
+   * \param   height Number of rows
+   * \param   srcStep Number of bytes between 2 consecutive rows of src
+   * \param   layout Position of the color channels inside a pixel
+   * \param   labels Output buffer for the labels (one byte per pixel)
+   * \param   labelStep Number of bytes between 2 consecutive rows of labels
+   */
+  void segmentPixels(const ColorTableArray &table, const uint8_t *src,
+      unsigned int width, unsigned int height, size_t srcStep,
+      const PixelLayout &layout, uint8_t *labels, size_t labelStep);
+
+  /**
+   * \brief   Segments a YUV 4:2:2 buffer using a YUV indexed color table.
+   *          Each macropixel is loaded once and gives the labels of its 2
+   *          pixels, with no conversion to rgb.
+   * \param   table The color table used for classification, indexed by [y][u][v]
+   * \param   src Pointer to the first macropixel of the first row
+   * \param   width Number of pixels in a row (2 per macropixel)
+   * \param   height Number of rows
+   * \param   srcStep Number of bytes between 2 consecutive rows of src
+   * \param   layout Position of the samples inside a macropixel
+   * \param   labels Output buffer for the labels (one byte per pixel)
+   * \param   labelStep Number of bytes between 2 consecutive rows of labels
+   */
+  void segmentYuv422Pixels(const ColorTableArray &table, const uint8_t *src,
+      unsigned int width, unsigned int height, size_t srcStep,
+      const Yuv422Layout &layout, uint8_t *labels, size_t labelStep);
+
+}
+
+#endif /* end of include guard: SEGMENTATION_Q3KX7B2M */
@@ -0,0 +1,158 @@
+/**
+ * \file  segmentation_worker.h
+ * \brief Header for the SegmentationWorker class, which loads, converts and
+ * segments frames for the classification window in the background
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 09/02/2011 09:48:31 AM piyushk $
+ */
+
+#ifndef SEGMENTATION_WORKER_J6PD2VMA
+#define SEGMENTATION_WORKER_J6PD2VMA
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include <QObject>
+#include <sensor_msgs/Image.h>
+
+#include <boost/function.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include <color_table/block_color_table.h>
+#include <color_table/color_histogram.h>
+#include <color_table/rgb_frame.h>
+
+namespace color_table {
+
+  /**
+   * \struct SegmentationResult
+   * \brief  A frame and its labels, as produced by the SegmentationWorker
+   */
+  struct SegmentationResult {
+    RgbFrame frame;
+    std::vector<uint8_t> labels;
+    boost::shared_ptr<const ColorHistogram> histogram;
+    std::string error;                    ///< Set if the frame could not be read or converted
+    bool loaded;                          ///< false if the frame could not be read. Only error is set then.
+    unsigned int generation;              ///< Request this is the result of
+
+    SegmentationResult() : loaded(false), generation(0) {}
+
+    void swap(SegmentationResult &other);
+  };
+
+  /**
+   * \class SegmentationWorker
+   * \brief Runs requests to load and segment a frame on a background thread
+   *
+   * Only the newest request matters. A new request replaces one that has not
+   * started yet, and makes the one being worked on give up at its next
+   * check. Every request gets a new generation number, and only a result of
+   * the newest generation is ever handed out, so the gui never shows a
+   * frame, or a table, that the user has already moved on from.
+   *
+   * The color histogram of a frame is cached for as long as the image
+   * message is alive somewhere (for instance in the cache of a
+   * BagFrameSource), so that going back to a frame does not build it again.
+   */
+  class SegmentationWorker : public QObject {
+  Q_OBJECT
+
+    public:
+
+      /** Produces the image to segment. Runs on the worker thread. */
+      typedef boost::function<sensor_msgs::ImageConstPtr ()> ImageLoader;
+
+      SegmentationWorker(QObject *parent = 0);
+      ~SegmentationWorker();
+
+      /**
+       * \brief   Queues a frame to be loaded and segmented with a table,
+       *          superseding all earlier requests
+       * \param   table Table snapshot, which must not change afterwards
+       * \return  Generation number of the request
+       */
+      unsigned int request(const ImageLoader &loader, const boost::shared_ptr<const BlockColorTable> &table);
+
+      /**
+       * \brief   Drops all requests, and waits for the one being worked on
+       *          to stop (so that the loader's data can be released)
+       */
+      void cancel();
+
+      /**
+       * \brief   Exchanges the result of the newest request with the given
+       *          buffers, which are reused for later requests
+       * \return  false if the newest request has not completed yet
+       */
+      bool takeResult(SegmentationResult &result);
+
+      /**
+       * \brief   Number of requests made, and how many of them were
+       *          superseded before their result was taken
+       */
+      void getCounts(size_t &numRequested, size_t &numSuperseded);
+
+    signals:
+
+      /**
+       * \brief   Emitted from the worker thread when a result is ready, at
+       *          most once until takeResult() is called
+       */
+      void resultReady();
+
+    private:
+
+      void run();
+
+      /**
+       * \brief   Whether a newer request was made after the given one
+       */
+      bool isStale(unsigned int requestGeneration);
+
+      /**
+       * \brief   Looks up the histogram of an image in the cache, building
+       *          it from the converted frame if it is not there. Only used
+       *          by the worker thread.
+       */
+      boost::shared_ptr<const ColorHistogram> getHistogram(const sensor_msgs::ImageConstPtr &image, const RgbFrame &frame);
+
+      struct CachedHistogram {
+        boost::weak_ptr<const sensor_msgs::Image> image;
+        boost::shared_ptr<const ColorHistogram> histogram;
+      };
+      std::list<CachedHistogram> histogramCache;    ///< Most recently used first
+
+      boost::mutex mutex;                     ///< Protects everything below
+      boost::condition_variable requestAvailable;
+      boost::condition_variable idle;
+
+      ImageLoader pendingLoader;
+      boost::shared_ptr<const BlockColorTable> pendingTable;
+      bool hasRequest;
+      unsigned int generation;                ///< Generation of the newest request
+      bool busy;                              ///< Whether a request is being worked on
+
+      SegmentationResult ready;               ///< Result of the newest request, if resultIsReady
+      bool resultIsReady;
+      bool notified;                          ///< Whether resultReady() was emitted since the last takeResult()
+      bool stopping;
+      size_t numRequested;
+      size_t numTaken;
+
+      boost::scoped_ptr<boost::thread> thread;
+
+  };
+
+}
+
+#endif /* end of include guard: SEGMENTATION_WORKER_J6PD2VMA */
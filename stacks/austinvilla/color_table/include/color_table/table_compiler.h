@@ -0,0 +1,138 @@
+/**
+ * \file  table_compiler.h
+ * \brief Labeled pixel samples collected for training a color table, and
+ * the compiler that turns their statistics into a table
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 09/05/2011 10:14:36 AM piyushk $
+ */
+
+#ifndef TABLE_COMPILER_Q8MZ3RXE
+#define TABLE_COMPILER_Q8MZ3RXE
+
+#include <map>
+#include <vector>
+
+#include <color_table/common.h>
+#include <color_table/color_table.h>
+
+namespace color_table {
+
+  /**
+   * \struct CellVotes
+   * \brief  Number of samples of each color that fell in one table cell
+   */
+  struct CellVotes {
+    uint32_t cell;                  ///< Index of the cell, see TableResolution::getCellIndex()
+    uint32_t votes[NUM_COLORS];
+    uint32_t total;
+  };
+
+  /**
+   * \struct ColorMoments
+   * \brief  Running sums over the rgb values of the samples of one color
+   */
+  struct ColorMoments {
+    double count;
+    double sum[3];                  ///< r, g, b
+    double sumProducts[3][3];       ///< Sums of r*r, r*g, ... b*b
+
+    ColorMoments();
+    void add(const Rgb &rgb, unsigned int weight);
+  };
+
+  /**
+   * \class TrainingSet
+   * \brief Labeled rgb samples, collected from any number of frames
+   *
+   * Samples are not stored individually. Each sample adds a vote for its
+   * color to the cell its rgb value falls in, and to the moments of its
+   * color. Samples labeled UNDEFINED are negative examples: they vote
+   * against a cell being assigned any color.
+   */
+  class TrainingSet {
+
+    public:
+
+      TrainingSet();
+
+      /**
+       * \brief   Adds a sample
+       * \param   weight Number of times the sample counts
+       */
+      void add(const Rgb &rgb, uint8_t color, unsigned int weight = 1);
+
+      /**
+       * \brief   Removes all samples
+       */
+      void clear();
+
+      inline size_t getNumSamples() const {
+        return numSamples;
+      }
+
+      inline size_t getNumSamples(uint8_t color) const {
+        return (size_t) moments[color].count;
+      }
+
+      /**
+       * \brief   Cells with at least one sample, in the order they were first sampled
+       */
+      inline const std::vector<CellVotes>& getCells() const {
+        return cells;
+      }
+
+      inline const ColorMoments& getMoments(uint8_t color) const {
+        return moments[color];
+      }
+
+    private:
+
+      std::vector<CellVotes> cells;
+      std::map<uint32_t, uint32_t> cellPositions;   ///< Position of a cell's entry in cells
+      ColorMoments moments[NUM_COLORS];
+      size_t numSamples;
+
+  };
+
+  /**
+   * \brief  Ways of deciding the color of a cell from a TrainingSet
+   */
+  enum CompileMethod {
+    COMPILE_MAJORITY,               ///< Most votes among the samples in a cube around the cell
+    COMPILE_GAUSSIAN,               ///< Closest color by Mahalanobis distance to each color's samples
+    COMPILE_NEAREST_NEIGHBORS       ///< Most votes among the k samples closest to the cell
+  };
+
+  /**
+   * \struct CompileOptions
+   * \brief  Parameters of compileTable()
+   */
+  struct CompileOptions {
+    CompileMethod method;
+    unsigned int radius;            ///< Majority: half width of the cube of cells that vote. Nearest neighbors: furthest distance of a neighbor, in cells. At most BlockColorTable::BLOCK_SIZE.
+    unsigned int minVotes;          ///< Majority: fewest votes needed to assign a color
+    unsigned int k;                 ///< Nearest neighbors: number of samples that vote
+    float maxSigma;                 ///< Gaussian: furthest Mahalanobis distance of a cell from its color
+    unsigned int numThreads;        ///< 0 for one per core
+
+    CompileOptions();
+  };
+
+  /**
+   * \brief   Computes the color of every cell of an rgb table from the
+   *          samples. Cells are split among threads in blocks of
+   *          BlockColorTable::BLOCK_SIZE^3 cells, and blocks that no sample
+   *          can reach are skipped. Ties, and cells without enough evidence,
+   *          are left UNDEFINED.
+   * \param   table Receives the result. Its color space is set to rgb.
+   */
+  void compileTable(const TrainingSet &samples, const CompileOptions &options, ColorTable &table);
+
+}
+
+#endif /* end of include guard: TABLE_COMPILER_Q8MZ3RXE */
@@ -0,0 +1,124 @@
+/**
+ * \file  table_file.h
+ * \brief Describes the on-disk formats of a color table (.col) file
+ *
+ * Two formats are supported:
+ *
+ * - Legacy raw tables: a plain dump of the table (2 MB for 128x128x128
+ *   tables), with no header at all. The resolution is deduced from the size,
+ *   and the table is always rgb indexed.
+ * - Version 2 tables: a TableFileHeader, followed by a block directory and a
+ *   run length encoded stream of the non-uniform blocks. The table is split
+ *   into 8x8x8 blocks. Each block has a single directory byte, which is
+ *   either the color of a uniform block, BLOCK_RLE or BLOCK_RAW. The data for
+ *   the non-uniform blocks follows the directory in block order, as
+ *   (length - 1, color) byte pairs for BLOCK_RLE blocks and 512 plain bytes
+ *   for BLOCK_RAW blocks. Cells inside a block are stored in r, g, b order.
+ *   The crc32 checksum in the header covers everything after the header.
+ *   The header records the resolution of the table, which may be anything
+ *   from 5 to 8 bits per channel, and whether it is indexed by rgb or yuv.
+ *
+ * Typical tables are almost entirely UNDEFINED, and compress from 2 MB down to
+ * a few tens of kilobytes.
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 08/18/2011 01:15:40 PM piyushk $
+ */
+
+#ifndef TABLE_FILE_W6PE3HNU
+#define TABLE_FILE_W6PE3HNU
+
+#include <string>
+#include <vector>
+
+#include <color_table/common.h>
+#include <color_table/color_space.h>
+
+namespace color_table {
+
+  /**
+   * \brief  File formats that a ColorTable can be saved in
+   */
+  enum TableFileFormat {
+    FORMAT_RAW,                     ///< Legacy headerless 2 MB dump
+    FORMAT_V2                       ///< Versioned, block sparse and run length encoded
+  };
+
+  /**
+   * \struct TableFileHeader
+   * \brief  Header of a version 2 .col file. All fields are little endian.
+   */
+  struct TableFileHeader {
+    char magic[4];                  ///< Always TABLE_FILE_MAGIC
+    uint16_t version;               ///< File format version (2)
+    uint16_t headerSize;            ///< Size of this header in bytes
+    uint8_t bitsPerChannel;         ///< Number of bits per channel used to index the table
+    uint8_t blockBits;              ///< Blocks are (1 << blockBits) cells along each axis
+    uint8_t numColors;              ///< NUM_COLORS at the time the table was written
+    uint8_t colorSpace;             ///< ColorSpace the table is indexed by (0 for rgb)
+    uint32_t payloadSize;           ///< Number of bytes following the header
+    uint32_t checksum;              ///< crc32 of the payload
+    uint32_t reserved[3];
+  };
+
+  const char TABLE_FILE_MAGIC[4] = {'U', 'T', 'C', 'T'};
+  const uint16_t TABLE_FILE_VERSION = 2;
+
+  /* Block directory entries that are not a color */
+
+  const uint8_t BLOCK_RLE = 0xFE;   ///< Block is stored as (length - 1, color) pairs
+  const uint8_t BLOCK_RAW = 0xFF;   ///< Block is stored as plain cells
+
+  /**
+   * \brief   Encodes a table into a complete version 2 file image
+   * \param   cells The table, in [r][g][b] order
+   * \param   bitsPerChannel Resolution of the table (5 to 8)
+   * \param   colorSpace Channels the table is indexed by
+   * \param   file Receives the header and payload
+   */
+  void encodeTableFile(const uint8_t *cells, unsigned int bitsPerChannel, ColorSpace colorSpace,
+      std::vector<uint8_t> &file);
+
+  /**
+   * \brief   Reads the header of a version 2 file image
+   * \return  false if data does not start with a version 2 header
+   */
+  bool readTableFileHeader(const uint8_t *data, size_t size, TableFileHeader &header);
+
+  /**
+   * \brief   Resolution of a legacy raw table of the given size in bytes, or
+   *          0 if no resolution matches the size
+   */
+  unsigned int getRawTableBits(size_t size);
+
+  /**
+   * \brief   Decodes a version 2 file image (header included)
+   * \param   data Start of the file
+   * \param   size Size of the file in bytes
+   * \param   cells Receives the table, which has header.bitsPerChannel bits per channel
+   * \param   error If not NULL, receives a description of the failure
+   * \return  true if the file was well formed and the checksum matched
+   */
+  bool decodeTableFile(const uint8_t *data, size_t size, uint8_t *cells, std::string *error = NULL);
+
+  /**
+   * \brief   Checks whether a file image starts with a version 2 header
+   */
+  bool isTableFileV2(const uint8_t *data, size_t size);
+
+  /**
+   * \brief   Converts a table to a different resolution. When reducing the
+   *          resolution, each cell gets the majority color of the cells it
+   *          covers, ignoring UNDEFINED.
+   * \param   src The table to convert, with srcBits bits per channel
+   * \param   dst Receives the table, with dstBits bits per channel
+   */
+  void resampleTable(const uint8_t *src, unsigned int srcBits, uint8_t *dst, unsigned int dstBits);
+
+}
+
+#endif /* end of include guard: TABLE_FILE_W6PE3HNU */
@@ -0,0 +1,100 @@
+/**
+ * \file  table_merge.h
+ * \brief Comparing color tables, and merging tables labelled in separate
+ * sessions into one
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 09/09/2011 10:12:36 AM piyushk $
+ */
+
+#ifndef TABLE_MERGE_Q8DF3KZA
+#define TABLE_MERGE_Q8DF3KZA
+
+#include <string>
+#include <vector>
+
+#include <color_table/color_table.h>
+
+namespace color_table {
+
+  /**
+   * \struct TableDiff
+   * \brief  Differences between an old table a and a new table b
+   */
+  struct TableDiff {
+    /** Number of cells that are color i in a and color j in b, for i != j
+     *  (the diagonal is left at 0) */
+    unsigned int changes[NUM_COLORS][NUM_COLORS];
+
+    /**
+     * \brief  Cells that are the color in b but not in a
+     */
+    unsigned int getGained(unsigned int color) const;
+
+    /**
+     * \brief  Cells that are the color in a but not in b
+     */
+    unsigned int getLost(unsigned int color) const;
+
+    /**
+     * \brief  Cells that differ in any way
+     */
+    unsigned int getNumChanged() const;
+
+    /**
+     * \brief  Cells that are a different color in both tables, as opposed to
+     *         cells that only one of them has labelled
+     */
+    unsigned int getNumConflicts() const;
+  };
+
+  /**
+   * \brief   Compares two tables cell by cell. Runs of identical cells are
+   *          skipped 16 at a time.
+   * \return  false if the tables are not indexed by the same color space
+   */
+  bool diffTables(const ColorTable &a, const ColorTable &b, TableDiff &diff, std::string *error = NULL);
+
+  /**
+   * \brief  How cells that the tables disagree on are merged. UNDEFINED
+   *         never counts as a vote, so a cell that only some of the tables
+   *         have labelled keeps their color under every policy.
+   */
+  enum MergePolicy {
+    MERGE_MAJORITY,                 ///< The color most tables have. UNDEFINED on a tie.
+    MERGE_PRIORITY,                 ///< The color of the first table that has one
+    MERGE_KEEP_UNDEFINED            ///< UNDEFINED whenever two tables disagree
+  };
+
+  /**
+   * \struct MergeStatistics
+   */
+  struct MergeStatistics {
+    unsigned int numLabelled;       ///< Cells labelled by at least one table
+    unsigned int numConflicts;      ///< Cells labelled with different colors by different tables
+    unsigned int numDropped;        ///< Conflicts that were left UNDEFINED
+  };
+
+  /**
+   * \brief   Merges any number of tables (up to MAX_MERGE_TABLES) into one.
+   *          The merge is vectorized, counting the votes for 16 cells at a
+   *          time, so that it stays fast with many tables.
+   * \param   tables Tables to merge, in priority order for MERGE_PRIORITY
+   * \param   result Receives the merged table. It may be one of the inputs.
+   * \param   stats If not NULL, receives the number of conflicts
+   * \return  false if the tables are not indexed by the same color space,
+   *          or there are too many of them
+   */
+  bool mergeTables(const std::vector<const ColorTable*> &tables, MergePolicy policy, ColorTable &result,
+      MergeStatistics *stats = NULL, std::string *error = NULL);
+
+  /** Votes are counted in bytes */
+  const unsigned int MAX_MERGE_TABLES = 255;
+
+}
+
+#endif /* end of include guard: TABLE_MERGE_Q8DF3KZA */
@@ -0,0 +1,75 @@
+/**
+ * \file  table_resolution.h
+ * \brief Index math for color tables with a given number of bits per channel
+ *
+ * A table with BITS bits per channel has (1 << BITS)^3 cells, and an 8 bit
+ * channel value v falls in cell v >> (8 - BITS). Everything is computed at
+ * compile time, so the index math compiles down to the same shifts as a
+ * hand written table of that size.
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 08/24/2011 10:05:12 AM piyushk $
+ */
+
+#ifndef TABLE_RESOLUTION_R4WN7C2E
+#define TABLE_RESOLUTION_R4WN7C2E
+
+#include <stdint.h>
+#include <boost/static_assert.hpp>
+
+namespace color_table {
+
+  /**
+   * \struct TableResolution
+   * \brief  Size and index math of a table with BITS bits per channel
+   */
+  template <unsigned int BITS>
+  struct TableResolution {
+
+    BOOST_STATIC_ASSERT(BITS >= 5 && BITS <= 8);
+
+    enum {
+      BITS_PER_CHANNEL = BITS,
+      SHIFT = 8 - BITS,                       ///< Low bits of a channel value dropped by the table
+      SIZE = 1 << BITS,                       ///< Number of cells along each axis
+      CELL_WIDTH = 1 << SHIFT,                ///< Number of channel values per cell along each axis
+      NUM_CELLS = SIZE * SIZE * SIZE
+    };
+
+    /**
+     * \brief  Cell coordinate of an 8 bit channel value
+     */
+    static inline unsigned int toCell(uint8_t value) {
+      return value >> SHIFT;
+    }
+
+    /**
+     * \brief  Smallest channel value falling in a cell
+     */
+    static inline uint8_t toValue(unsigned int cell) {
+      return cell << SHIFT;
+    }
+
+    /**
+     * \brief  Index of a cell in the flat [r][g][b] table, from cell coordinates
+     */
+    static inline uint32_t getCellIndex(unsigned int r, unsigned int g, unsigned int b) {
+      return (r << (2 * BITS)) | (g << BITS) | b;
+    }
+
+    /**
+     * \brief  Index of the cell an rgb value falls in
+     */
+    static inline uint32_t getIndex(uint8_t r, uint8_t g, uint8_t b) {
+      return getCellIndex(toCell(r), toCell(g), toCell(b));
+    }
+
+  };
+
+}
+
+#endif /* end of include guard: TABLE_RESOLUTION_R4WN7C2E */
@@ -0,0 +1,195 @@
+/**
+ * \file  thumbnail_loader.h
+ * \brief Header for the ThumbnailLoader class, which makes small thumbnails
+ * of bag frames for the filmstrip on a pool of threads
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 09/08/2011 10:22:47 AM piyushk $
+ */
+
+#ifndef THUMBNAIL_LOADER_T3KB9WQS
+#define THUMBNAIL_LOADER_T3KB9WQS
+
+#include <deque>
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include <color_table/common.h>
+#include <color_table/bag_frame_source.h>
+#include <color_table/block_color_table.h>
+
+namespace color_table {
+
+  /**
+   * \struct Thumbnail
+   * \brief  A frame scaled down to a fixed size
+   *
+   * Pixels are point sampled rather than averaged, so that their colors are
+   * real colors of the frame, and segmenting the thumbnail estimates the
+   * coverage of the frame.
+   */
+  struct Thumbnail {
+    static const unsigned int WIDTH = 80;
+    static const unsigned int HEIGHT = 60;
+    static const unsigned int NUM_PIXELS = WIDTH * HEIGHT;
+
+    Rgb pixels[NUM_PIXELS];
+  };
+
+  /**
+   * \class ThumbnailLoader
+   * \brief Loads the thumbnails of requested frames in the background
+   *
+   * Thumbnails are kept in a bounded LRU cache in memory, and appended to a
+   * cache file on disk ($ROS_HOME/color_table/thumbnails, or
+   * ~/.ros/color_table/thumbnails). There is one file per bag (path, size
+   * and modification time) and topic, holding a record per frame. Reopening
+   * a bag reads the thumbnails back instead of decoding frames. The files of
+   * all bags together are kept under a size limit: opening a bag deletes the
+   * files of the least recently opened bags, and a single bag stops adding
+   * thumbnails once it reaches the limit.
+   *
+   * Given a color table, the workers also work out the table's coverage of
+   * each thumbnail they hold, so that the filmstrip only has to draw it.
+   * Changing the table queues the requested thumbnails again for coverage.
+   */
+  class ThumbnailLoader : boost::noncopyable {
+
+    public:
+
+      /**
+       * \param   cacheSize Maximum number of thumbnails kept in memory
+       * \param   numThreads Number of worker threads, 0 for one per core
+       * \param   maxDiskBytes Size limit of the cache files on disk
+       */
+      ThumbnailLoader(size_t cacheSize = 4096, unsigned int numThreads = 0,
+          uint64_t maxDiskBytes = 256 << 20);
+      ~ThumbnailLoader();
+
+      /**
+       * \brief   Starts the workers for a bag. frames must stay open until
+       *          close() is called.
+       */
+      void open(BagFrameSource &frames, const std::string &bagFilename, const std::string &topic);
+
+      /**
+       * \brief   Stops the workers and empties the memory cache
+       */
+      void close();
+
+      /**
+       * \brief   Replaces the frames waiting to be loaded. Frames are loaded
+       *          in the given order, and frames already cached are skipped.
+       */
+      void request(const std::vector<size_t> &indices);
+
+      /**
+       * \return  NULL if the thumbnail is not loaded (yet)
+       */
+      boost::shared_ptr<const Thumbnail> getThumbnail(size_t index);
+
+      /**
+       * \brief   Sets the table whose coverage of the thumbnails is worked
+       *          out, NULL for none
+       */
+      void setColorTable(const boost::shared_ptr<const BlockColorTable> &table);
+
+      /**
+       * \return  Share of the thumbnail's pixels given a color by the table,
+       *          or -1 if it has not been worked out (yet)
+       */
+      float getCoverage(size_t index);
+
+      /**
+       * \brief   Whether thumbnails were loaded or coverage worked out since
+       *          the last call
+       */
+      bool takeChanged();
+
+      /**
+       * \brief   Whether there are requests left to work on
+       */
+      bool isBusy();
+
+    private:
+
+      void run();
+
+      /**
+       * \brief   Decodes a frame and scales it down
+       * \return  false if the frame could not be read or converted, or is
+       *          empty
+       */
+      bool makeThumbnail(size_t index, Thumbnail &thumbnail);
+
+      /**
+       * \brief   Queues the requested thumbnails that are cached but have no
+       *          coverage for the current table. Called with mutex held.
+       */
+      void queueCoverage();
+
+      /**
+       * \brief   Share of the thumbnail's pixels given a color by table
+       */
+      static float computeCoverage(const BlockColorTable &table, const Thumbnail &thumbnail,
+          std::vector<uint8_t> &labels);
+
+      void openDiskCache(const std::string &bagFilename, const std::string &topic);
+      void closeDiskCache();
+      bool loadFromDisk(size_t index, Thumbnail &thumbnail);
+      void saveToDisk(size_t index, const Thumbnail &thumbnail);
+
+      BagFrameSource *frames;
+      unsigned int numThreads;
+      uint64_t maxDiskBytes;
+
+      boost::mutex diskMutex;                 ///< Protects the cache file and diskIndex
+      int cacheFile;                          ///< -1 if the disk cache cannot be used
+      std::map<size_t, uint64_t> diskIndex;   ///< Offset of the record of each frame in the cache file
+
+      boost::mutex mutex;                     ///< Protects everything below
+      boost::condition_variable requestAvailable;
+      std::deque<size_t> pending;
+      std::set<size_t> loading;               ///< Frames being worked on
+      std::vector<size_t> requested;          ///< Frames of the last request, in order
+      typedef std::list<std::pair<size_t, boost::shared_ptr<const Thumbnail> > > CacheList;
+      CacheList cache;                        ///< Most recently used first
+      std::map<size_t, CacheList::iterator> cacheIndex;
+      size_t cacheSize;
+
+      /**
+       * \struct Coverage
+       * \brief  Coverage of a thumbnail, and the table it was worked out with
+       */
+      struct Coverage {
+        float value;
+        unsigned int generation;
+      };
+
+      boost::shared_ptr<const BlockColorTable> table;
+      unsigned int tableGeneration;           ///< Bumped by every setColorTable()
+      std::deque<size_t> pendingCoverage;     ///< Cached frames waiting for coverage
+      unsigned int numCovering;               ///< Coverage being worked out
+      std::map<size_t, Coverage> coverage;    ///< Cached frames only, possibly of an older table
+      bool changed;
+      bool stopping;
+
+      boost::scoped_ptr<boost::thread_group> threads;
+
+  };
+
+}
+
+#endif /* end of include guard: THUMBNAIL_LOADER_T3KB9WQS */
@@ -0,0 +1,242 @@
+/**
+ * \file  bag_frame_source.cpp
+ * \brief Definitions for the BagFrameSource class
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 08/30/2011 11:20:05 AM piyushk $
+ */
+
+#include <boost/bind.hpp>
+
+#include <color_table/bag_frame_source.h>
+
+namespace color_table {
+
+  namespace {
+    /** Number of messages indexed between releases of the bag lock */
+    const unsigned int INDEX_BATCH_SIZE = 256;
+  }
+
+  BagFrameSource::BagFrameSource(size_t cacheSize, unsigned int prefetchRadius) :
+      indexing(false), cacheSize(cacheSize), prefetchRadius(prefetchRadius),
+      currentFrame(0), currentFrameChanged(false), stopping(false) {}
+
+  BagFrameSource::~BagFrameSource() {
+    close();
+  }
+
+  /**
+   * \brief   Opens a bag and starts indexing it in the background
+   */
+  bool BagFrameSource::open(const std::string &filename, const std::string &topic, std::string *error) {
+
+    close();
+
+    try {
+      bag.open(filename, rosbag::bagmode::Read);
+    } catch (rosbag::BagException &e) {
+      if (error) {
+        *error = e.what();
+      }
+      return false;
+    }
+
+    indexing = true;
+    stopping = false;
+    currentFrame = 0;
+    currentFrameChanged = false;
+    indexThread.reset(new boost::thread(boost::bind(&BagFrameSource::indexBag, this, topic)));
+    prefetchThread.reset(new boost::thread(boost::bind(&BagFrameSource::prefetch, this)));
+    return true;
+  }
+
+  /**
+   * \brief   Stops the background threads and closes the bag
+   */
+  void BagFrameSource::close() {
+
+    {
+      boost::mutex::scoped_lock lock(prefetchMutex);
+      stopping = true;
+      prefetchCondition.notify_all();
+    }
+    if (indexThread) {
+      indexThread->join();
+      indexThread.reset();
+    }
+    if (prefetchThread) {
+      prefetchThread->join();
+      prefetchThread.reset();
+    }
+
+    {
+      boost::mutex::scoped_lock lock(cacheMutex);
+      cache.clear();
+      cacheIndex.clear();
+    }
+    {
+      boost::mutex::scoped_lock lock(indexMutex);
+      messages.clear();
+      indexing = false;
+    }
+    boost::mutex::scoped_lock lock(bagMutex);
+    bag.close();
+  }
+
+  size_t BagFrameSource::getNumFrames() {
+    boost::mutex::scoped_lock lock(indexMutex);
+    return messages.size();
+  }
+
+  bool BagFrameSource::isIndexing() {
+    boost::mutex::scoped_lock lock(indexMutex);
+    return indexing;
+  }
+
+  /**
+   * \brief   Returns a frame, decoding it if it is not cached
+   */
+  sensor_msgs::ImageConstPtr BagFrameSource::getFrame(size_t index) {
+    sensor_msgs::ImageConstPtr image = findCached(index);
+    if (!image) {
+      image = decode(index);
+      if (image) {
+        addCached(index, image);
+      }
+    }
+    return image;
+  }
+
+  /**
+   * \brief   Returns a frame without adding it to the cache
+   */
+  sensor_msgs::ImageConstPtr BagFrameSource::readFrame(size_t index) {
+    sensor_msgs::ImageConstPtr image = findCached(index);
+    if (!image) {
+      image = decode(index);
+    }
+    return image;
+  }
+
+  /**
+   * \brief   Tells the prefetch thread which frame is being looked at
+   */
+  void BagFrameSource::setCurrentFrame(size_t index) {
+    boost::mutex::scoped_lock lock(prefetchMutex);
+    currentFrame = index;
+    currentFrameChanged = true;
+    prefetchCondition.notify_all();
+  }
+
+  /**
+   * \brief   Collects the position of every message on the topic
+   */
+  void BagFrameSource::indexBag(std::string topic) {
+
+    std::vector<std::string> topics(1, topic);
+    boost::mutex::scoped_lock bagLock(bagMutex);
+    rosbag::View view(bag, rosbag::TopicQuery(topics));
+    rosbag::View::iterator it = view.begin();
+    while (it != view.end()) {
+
+      // Release the bag now and then, so that frames can be decoded while
+      // the rest of the bag is indexed
+      std::vector<rosbag::MessageInstance> batch;
+      for (unsigned int i = 0; i < INDEX_BATCH_SIZE && it != view.end(); i++, ++it) {
+        batch.push_back(*it);
+      }
+      bagLock.unlock();
+
+      {
+        boost::mutex::scoped_lock lock(indexMutex);
+        messages.insert(messages.end(), batch.begin(), batch.end());
+      }
+      {
+        boost::mutex::scoped_lock lock(prefetchMutex);
+        if (stopping)
+          return;
+        // Frames around the current frame may have just become available
+        prefetchCondition.notify_all();
+      }
+
+      bagLock.lock();
+    }
+
+    boost::mutex::scoped_lock lock(indexMutex);
+    indexing = false;
+  }
+
+  /**
+   * \brief   Decodes the frames around the current frame, nearest first
+   */
+  void BagFrameSource::prefetch() {
+
+    while (true) {
+      size_t center;
+      {
+        boost::mutex::scoped_lock lock(prefetchMutex);
+        if (!currentFrameChanged && !stopping) {
+          prefetchCondition.wait(lock);
+        }
+        if (stopping)
+          return;
+        center = currentFrame;
+        currentFrameChanged = false;
+      }
+
+      for (unsigned int distance = 1; distance <= prefetchRadius; distance++) {
+        {
+          // Start over if the user moved on
+          boost::mutex::scoped_lock lock(prefetchMutex);
+          if (stopping || currentFrameChanged)
+            break;
+        }
+        getFrame(center + distance);
+        if (center >= distance) {
+          getFrame(center - distance);
+        }
+      }
+    }
+  }
+
+  sensor_msgs::ImageConstPtr BagFrameSource::findCached(size_t index) {
+    boost::mutex::scoped_lock lock(cacheMutex);
+    std::map<size_t, CacheList::iterator>::iterator entry = cacheIndex.find(index);
+    if (entry == cacheIndex.end())
+      return sensor_msgs::ImageConstPtr();
+    cache.splice(cache.begin(), cache, entry->second);
+    return entry->second->second;
+  }
+
+  void BagFrameSource::addCached(size_t index, const sensor_msgs::ImageConstPtr &image) {
+    boost::mutex::scoped_lock lock(cacheMutex);
+    if (cacheIndex.count(index))
+      return;
+    cache.push_front(std::make_pair(index, image));
+    cacheIndex[index] = cache.begin();
+    while (cache.size() > cacheSize) {
+      cacheIndex.erase(cache.back().first);
+      cache.pop_back();
+    }
+  }
+
+  /**
+   * \brief   Reads a frame from the bag
+   */
+  sensor_msgs::ImageConstPtr BagFrameSource::decode(size_t index) {
+    boost::scoped_ptr<rosbag::MessageInstance> message;
+    {
+      boost::mutex::scoped_lock lock(indexMutex);
+      if (index >= messages.size())
+        return sensor_msgs::ImageConstPtr();
+      message.reset(new rosbag::MessageInstance(messages[index]));
+    }
+    boost::mutex::scoped_lock lock(bagMutex);
+    return message->instantiate<sensor_msgs::Image>();
+  }
+
+}
@@ -0,0 +1,129 @@
+/**
+ * \file  bag_histogram.cpp
+ * \brief Definitions for the BagHistogram class
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 09/07/2011 02:40:33 PM piyushk $
+ */
+
+#include <algorithm>
+#include <boost/bind.hpp>
+
+#include <color_table/bag_histogram.h>
+#include <color_table/rgb_frame.h>
+
+namespace color_table {
+
+  BagHistogram::BagHistogram() : frames(NULL), numFrames(0), nextFrame(0), numDone(0),
+      numRunning(0), stopping(false) {}
+
+  BagHistogram::~BagHistogram() {
+    stop();
+  }
+
+  /**
+   * \brief   Starts building the histogram in the background
+   */
+  void BagHistogram::start(BagFrameSource &frames, size_t numFrames, unsigned int numThreads) {
+
+    stop();
+    if (numThreads == 0) {
+      numThreads = std::max(boost::thread::hardware_concurrency(), 1u);
+    }
+
+    this->frames = &frames;
+    {
+      boost::mutex::scoped_lock lock(mutex);
+      this->numFrames = numFrames;
+      nextFrame = numDone = 0;
+      numRunning = numThreads;
+      stopping = false;
+      total.clear();
+      result.reset();
+    }
+    threads.reset(new boost::thread_group);
+    for (unsigned int i = 0; i < numThreads; i++) {
+      threads->create_thread(boost::bind(&BagHistogram::run, this));
+    }
+  }
+
+  /**
+   * \brief   Stops the threads
+   */
+  void BagHistogram::stop() {
+    {
+      boost::mutex::scoped_lock lock(mutex);
+      stopping = true;
+    }
+    if (threads) {
+      threads->join_all();
+      threads.reset();
+    }
+
+    boost::mutex::scoped_lock lock(mutex);
+    total.clear();
+    result.reset();
+    numRunning = 0;
+  }
+
+  bool BagHistogram::isRunning() {
+    boost::mutex::scoped_lock lock(mutex);
+    return numRunning > 0;
+  }
+
+  void BagHistogram::getProgress(size_t &numDone, size_t &numFrames) {
+    boost::mutex::scoped_lock lock(mutex);
+    numDone = this->numDone;
+    numFrames = this->numFrames;
+  }
+
+  boost::shared_ptr<const ColorHistogram> BagHistogram::getHistogram() {
+    boost::mutex::scoped_lock lock(mutex);
+    return result;
+  }
+
+  /**
+   * \brief   Thread body. Takes frames until none are left.
+   */
+  void BagHistogram::run() {
+
+    ColorHistogram sum;
+    ColorHistogram frameHistogram;
+    RgbFrame frame;
+
+    while (true) {
+      size_t index;
+      {
+        boost::mutex::scoped_lock lock(mutex);
+        if (stopping || nextFrame >= numFrames)
+          break;
+        index = nextFrame++;
+      }
+
+      // Frames that cannot be converted are left out
+      sensor_msgs::ImageConstPtr image = frames->readFrame(index);
+      if (image && frame.assign(image)) {
+        frameHistogram.build(frame.getPixels(), frame.getNumPixels());
+        sum.add(frameHistogram);
+      }
+
+      boost::mutex::scoped_lock lock(mutex);
+      numDone++;
+    }
+
+    boost::mutex::scoped_lock lock(mutex);
+    if (stopping)
+      return;
+    total.add(sum);
+    numRunning--;
+    if (numRunning == 0) {
+      result.reset(new ColorHistogram(total));
+      total.clear();
+    }
+  }
+
+}
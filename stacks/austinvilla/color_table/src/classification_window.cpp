@@ -12,20 +12,44 @@
  */
 
 #include <iostream>
+#include <sstream>
 #include <algorithm>
 
 #include <QtGui>
 #include <QMessageBox>
 #include <QColor>
 
+#include <boost/bind.hpp>
+
 #include <color_table/classification_window.h>
 
 namespace color_table {
 
   using namespace Qt;
 
-  ClassificationWindow::ClassificationWindow(QWidget *parent) : QMainWindow(parent) {
+  namespace {
+    const unsigned int MIN_BLOB_AREA = 16;        ///< Smaller blobs are noise, and are not outlined
+    const QRgb BLOB_BOX_COLOR = qRgb(255, 0, 0);
+    const unsigned int REGION_TOLERANCE_STEP = 3;    ///< Color tolerance of the region brush per notch of the dial
+    const unsigned int REGION_BIN_FRACTION = 2000;   ///< Cells with less than this fraction of a region's pixels are left out
+    const unsigned int NEAREST_NEIGHBORS_DISTANCE = 8;  ///< Furthest neighbor of a cell, in rgb values
+
+    /** NEAREST_NEIGHBORS_DISTANCE in cells at the table's resolution */
+    const unsigned int NEAREST_NEIGHBORS_RADIUS = std::max(1u, NEAREST_NEIGHBORS_DISTANCE / Resolution::CELL_WIDTH);
+  }
+
+  ClassificationWindow::ClassificationWindow(QWidget *parent) : QMainWindow(parent), preview(colorTable),
+      binIndexValid(false), blobDetector(MIN_BLOB_AREA), segColors(NUM_COLORS) {
     ui.setupUi(this); // Calling this incidentally connects all ui's triggers to on_...() callbacks in this class.
+    connect(&worker, SIGNAL(resultReady()), this, SLOT(showSegmentationResult()));
+
+    // The small screens keep a downsampled copy instead of scaling the
+    // full image every time they are painted
+    ui.rawImage->setThumbnail(true);
+    ui.segImage->setThumbnail(true);
+
+    coverageLabel = new QLabel(this);
+    ui.statusBar->addPermanentWidget(coverageLabel);
 
     // Set up segmented colors
     segColors[UNDEFINED] = qRgb(0,0,0);
@@ -103,6 +127,14 @@ namespace color_table {
   void ClassificationWindow::updateStatus() {
 
     std::string status;
+    if (ui.actionCollect_Samples->isChecked()) {
+      std::stringstream ss;
+      ss << "Collecting " << segColorNames[clickMode == ADD ? currentColor : UNDEFINED]
+         << " samples (" << trainingSamples.getNumSamples() << " so far).";
+      ui.statusBar->showMessage(QString(ss.str().c_str()));
+      return;
+    }
+
     switch(clickMode) {
       case ADD:
         status += "Adding";
@@ -121,53 +153,145 @@ namespace color_table {
   }
 
   /** 
-   * \brief Function to draw an RgbImage onto an ImageWidget screen
+   * \brief Function to draw the current frame onto an ImageWidget screen
    */
   void ClassificationWindow::drawRgbImage(ImageWidget *widget) {
-
-    QRgb value;
-    for (unsigned int i = 0; i < IMAGE_HEIGHT; i++) {
-      for (unsigned int j = 0; j < IMAGE_WIDTH; j++) {
-        value = qRgb(rgbImage[i][j].r, rgbImage[i][j].g, rgbImage[i][j].b);
-        widget->img->setPixel(j,i,value);
-      }
-    }
-
-    widget->repaint();
-
+    widget->showRgb(frame.getPixels(), frame.getWidth(), frame.getHeight());
   }
 
   /** 
-   * \brief Function to draw an RgbImage onto an ImageWidget screen
+   * \brief Function to draw the SegImage onto an ImageWidget screen
    */
   void ClassificationWindow::drawSegImage(ImageWidget *widget) {
+    widget->showLabels(segImage.empty() ? NULL : &segImage[0], frame.getWidth(), frame.getHeight(), segColors);
+  }
 
-    QRgb value;
-    for (unsigned int i = 0; i < IMAGE_HEIGHT; i++) {
-      for (unsigned int j = 0; j < IMAGE_WIDTH; j++) {
-        value = segColors[segImage[i][j]];
-        widget->img->setPixel(j,i,value);
-      }
+  /**
+   * \brief Detects blobs in the SegImage and outlines them on the seg image screens
+   */
+  void ClassificationWindow::updateBlobOverlay() {
+
+    displayedBlobs.clear();
+    if (ui.actionShow_Blobs->isChecked() && !frame.empty()) {
+      blobDetector.detect(&segImage[0], frame.getWidth(), frame.getHeight(), frame.getWidth());
+      displayedBlobs = blobDetector.getBlobs();
     }
 
-    widget->repaint();
+    std::vector<QRect> boxes(displayedBlobs.size());
+    for (unsigned int i = 0; i < displayedBlobs.size(); i++) {
+      const Blob &blob = displayedBlobs[i];
+      boxes[i] = QRect(blob.xMin, blob.yMin, blob.xMax - blob.xMin, blob.yMax - blob.yMin);
+    }
+    ui.segImage->setBoxes(boxes, BLOB_BOX_COLOR);
+    ui.bigImage->setBoxes(imageSelected == SEG ? boxes : std::vector<QRect>(), BLOB_BOX_COLOR);
 
   }
 
+  namespace {
+    sensor_msgs::ImageConstPtr returnImage(const sensor_msgs::ImageConstPtr &image) {
+      return image;
+    }
+  }
+
   /**
    * \brief  Get an updated image from the main window
    */
   void ClassificationWindow::changeImage(sensor_msgs::ImageConstPtr image) {
+    changeImage(boost::bind(&returnImage, image));
+  }
 
-    for (unsigned int i = 0; i < image->height; i++) {
-      for (unsigned int j = 0; j < image->width; j++) {
-        rgbImage[i][j].r =  image->data[i * image->step + 3 * j + 0]; 
-        rgbImage[i][j].g =  image->data[i * image->step + 3 * j + 1]; 
-        rgbImage[i][j].b =  image->data[i * image->step + 3 * j + 2];
-      }
+  /**
+   * \brief  Get an updated image from the main window, loaded in the background
+   */
+  void ClassificationWindow::changeImage(const SegmentationWorker::ImageLoader &loader) {
+    // Replaces whatever the worker was doing, so scrubbing never queues up work
+    pendingLoader = loader;
+    worker.request(loader, getTableSnapshot());
+  }
+
+  /**
+   * \brief  Drops any frame that is still being loaded or segmented
+   */
+  void ClassificationWindow::cancelSegmentation() {
+    pendingLoader.clear();
+    worker.cancel();
+  }
+
+  /**
+   * \brief  Displays the frame segmented by the worker
+   */
+  void ClassificationWindow::showSegmentationResult() {
+
+    if (!worker.takeResult(spareResult))
+      return;
+    pendingLoader.clear();
+    if (!spareResult.error.empty()) {
+      ui.statusBar->showMessage(QString(spareResult.error.c_str()));
     }
+    // The current frame stays on screen
+    if (!spareResult.loaded)
+      return;
 
-    redrawImages();
+    // The previous buffers go back to the worker with the next result. The
+    // worker never writes to buffers that are on screen.
+    frame.swap(spareResult.frame);
+    segImage.swap(spareResult.labels);
+    frameHistogram = spareResult.histogram;
+
+    // The labels were made with a snapshot that included the preview. The
+    // bin index is only built if the user edits this frame.
+    displayedPreviewBlocks = preview.getTouchedBlocks();
+    binIndexValid = false;
+
+    drawRgbImage(ui.rawImage);
+    drawSegImage(ui.segImage);
+    if (imageSelected == RGB) {
+      drawRgbImage(ui.bigImage);
+    } else {
+      drawSegImage(ui.bigImage);
+    }
+    updateBlobOverlay();
+    updateCoverage();
+  }
+
+  /**
+   * \brief  Sets the histogram of all frames of the bag
+   */
+  void ClassificationWindow::setBagHistogram(const boost::shared_ptr<const ColorHistogram> &histogram) {
+    bagHistogram = histogram;
+    updateCoverage();
+  }
+
+  /**
+   * \brief  Requests the pending frame again if the table changed before it
+   *         was shown, since its labels would be out of date
+   */
+  void ClassificationWindow::invalidateTableSnapshot() {
+    tableSnapshot.reset();
+    if (pendingLoader) {
+      worker.request(pendingLoader, getTableSnapshot());
+    }
+    emit tableChanged();
+  }
+
+  /**
+   * \brief  A snapshot of the table as currently previewed
+   */
+  boost::shared_ptr<const BlockColorTable> ClassificationWindow::getTableSnapshot() {
+
+    if (tableSnapshot)
+      return tableSnapshot;
+
+    // Copies share their blocks with colorTable, which copies a block before
+    // writing to it, so only the preview's blocks need to be cloned
+    boost::shared_ptr<BlockColorTable> table(new BlockColorTable(colorTable));
+    const std::vector<unsigned int> &touchedBlocks = preview.getTouchedBlocks();
+    for (unsigned int i = 0; i < touchedBlocks.size(); i++) {
+      BlockColorTable::BlockPtr block = BlockColorTable::cloneBlock(preview.getBlock(touchedBlocks[i]));
+      table->swapBlock(touchedBlocks[i], block);
+    }
+    tableSnapshot = table;
+    return tableSnapshot;
   }
 
   /** 
@@ -176,16 +300,58 @@ namespace color_table {
    */
   void ClassificationWindow::segmentImage(bool useTempColorTable) {
 
-    ColorTable *table = &colorTable;
     if (useTempColorTable) {
-      table = &tempColorTable;
+      displayedPreviewBlocks = preview.getTouchedBlocks();
+    } else {
+      displayedPreviewBlocks.clear();
+    }
+    if (frame.empty())
+      return;
+
+    if (useTempColorTable) {
+      preview.segment(frame.getPixels(), frame.getNumPixels(), &segImage[0]);
+    } else {
+      colorTable.segment(frame.getPixels(), frame.getNumPixels(), &segImage[0]);
     }
 
-    for (unsigned int i = 0; i < IMAGE_HEIGHT; i++) {
-      for (unsigned int j = 0; j < IMAGE_WIDTH; j++) {
-        segImage[i][j] = (*table)[rgbImage[i][j].r / 2][rgbImage[i][j].g / 2][rgbImage[i][j].b / 2];
+  }
+
+  /**
+   * \brief Relabels and redraws only the pixels that the current preview (or
+   *        the previously displayed one) can affect
+   */
+  void ClassificationWindow::redrawPreview() {
+
+    // Pixels in blocks touched by the previous preview have to revert to the
+    // committed table unless the new preview touches them again
+    std::vector<unsigned int> dirtyBlocks(displayedPreviewBlocks);
+    const std::vector<unsigned int> &touchedBlocks = preview.getTouchedBlocks();
+    dirtyBlocks.insert(dirtyBlocks.end(), touchedBlocks.begin(), touchedBlocks.end());
+
+    invalidateTableSnapshot();
+
+    std::vector<unsigned int> changedPixels;
+    if (!frame.empty()) {
+      if (!binIndexValid) {
+        binIndex.build(frame.getPixels(), frame.getNumPixels());
+        binIndexValid = true;
       }
+      binIndex.relabel(dirtyBlocks, preview, &segImage[0], changedPixels);
+    }
+    displayedPreviewBlocks = touchedBlocks;
+
+    // The bag's coverage can change even if none of the frame's pixels did
+    updateCoverage();
+    if (changedPixels.empty())
+      return;
+
+    // The big screen draws straight from segImage and only needs a repaint,
+    // while the thumbnail is sampled again
+    drawSegImage(ui.segImage);
+    if (imageSelected == SEG) {
+      drawSegImage(ui.bigImage);
     }
+    updateBlobOverlay();
 
   }
 
@@ -194,9 +360,10 @@ namespace color_table {
    */
   void ClassificationWindow::redrawImages(bool useTempColorTable) {
 
+    invalidateTableSnapshot();
     segmentImage(useTempColorTable);
-    
-    drawRgbImage(ui.rawImage);
+
+    // The raw thumbnail only changes with the frame, see showSegmentationResult()
     drawSegImage(ui.segImage);
 
     if (imageSelected == RGB) {
@@ -205,6 +372,55 @@ namespace color_table {
       drawSegImage(ui.bigImage);
     }
 
+    updateBlobOverlay();
+    updateCoverage();
+
+  }
+
+  namespace {
+    /**
+     * \brief  Formats coverage as "62.5% labeled (Orange 1.2%, Green 61.3%)"
+     */
+    std::string formatCoverage(const std::vector<uint64_t> &colorCounts, uint64_t numPixels,
+        const std::string *colorNames) {
+      std::stringstream ss;
+      ss.setf(std::ios::fixed);
+      ss.precision(1);
+      ss << 100.0 * (numPixels - colorCounts[UNDEFINED]) / numPixels << "% labeled";
+      std::string separator = " (";
+      for (unsigned int color = UNDEFINED + 1; color < NUM_COLORS; color++) {
+        if (colorCounts[color] > 0) {
+          ss << separator << colorNames[color] << " " << 100.0 * colorCounts[color] / numPixels << "%";
+          separator = ", ";
+        }
+      }
+      if (separator != " (") {
+        ss << ")";
+      }
+      return ss.str();
+    }
+  }
+
+  /**
+   * \brief Shows the coverage of the frame and bag in the status bar
+   */
+  void ClassificationWindow::updateCoverage() {
+
+    // A pass over the cells of the histograms, instead of the pixels
+    std::vector<uint64_t> colorCounts;
+    std::string text;
+    if (frameHistogram && frameHistogram->getNumPixels() > 0 && !frame.empty()) {
+      frameHistogram->getCoverage(preview, colorCounts);
+      text = "Frame: " + formatCoverage(colorCounts, frameHistogram->getNumPixels(), segColorNames);
+    }
+    if (bagHistogram && bagHistogram->getNumPixels() > 0) {
+      bagHistogram->getCoverage(preview, colorCounts);
+      if (!text.empty()) {
+        text += "  ";
+      }
+      text += "Bag: " + formatCoverage(colorCounts, bagHistogram->getNumPixels(), segColorNames);
+    }
+    coverageLabel->setText(QString(text.c_str()));
   }
 
   /**
@@ -215,18 +431,41 @@ namespace color_table {
     event->accept();
   }
 
+  /**
+   * \brief Commits the current preview, recording it in the edit history
+   */
+  void ClassificationWindow::commitPreview() {
+    history.record(preview);
+    preview.commit();
+    displayedPreviewBlocks.clear();
+    updateHistoryActions();
+  }
+
+  /**
+   * \brief Enables the undo and redo actions if there is something to undo/redo
+   */
+  void ClassificationWindow::updateHistoryActions() {
+    ui.actionUndo->setEnabled(history.canUndo());
+    ui.actionRedo->setEnabled(history.canRedo());
+  }
+
   /**
    * \brief Opens the color table specified by colorTableFilename
    */
   bool ClassificationWindow::openColorTable() {
-    FILE* f = fopen(colorTableFilename.c_str(), "rb");
-    if (!f || ferror(f)) {
+    std::string error;
+    ColorTable table;
+    if (!table.load(colorTableFilename, &error)) {
+      std::cerr << error << std::endl;
       return false;
     }
-    size_t bytesRead = fread(tempColorTable, 128*128*128, 1, f);
-    fclose(f);
-    memcpy(colorTable, tempColorTable, 128*128*128);
-    return bytesRead;
+    // The editor works on rgb values
+    table.convert(COLOR_SPACE_RGB);
+    preview.discard();
+    colorTable.fromColorTable(table);
+    history.clear();
+    updateHistoryActions();
+    return true;
   }
 
   /**
@@ -250,33 +489,48 @@ namespace color_table {
     switch (button) {
 
       case Qt::LeftButton: {
-        memcpy(tempColorTable, colorTable, 128 * 128 * 128);
+        if (x < 0 || y < 0 || x >= (int)frame.getWidth() || y >= (int)frame.getHeight())
+          break;
+        if (ui.actionCollect_Samples->isChecked()) {
+          addSamples(x, y);
+          break;
+        }
+        if (ui.actionRegion_Color->isChecked() || ui.actionRegion_Labels->isChecked()) {
+          paintRegion(x, y);
+          break;
+        }
+        preview.discard();
         int sen = ui.sensitivityDial->value();
-        Rgb rgb = rgbImage[y][x];
+        Rgb rgb = frame.at(x, y);
         if (clickMode == ADD) {
-          for (int r = std::max((int)rgb.r - sen * 5, 0); r <=std::min((int)rgb.r + sen * 5, 255); r+=2) {
-            for (int g = std::max((int)rgb.g - sen * 5, 0); g <=std::min((int)rgb.g + sen * 5, 255); g+=2) {
-              for (int b = std::max((int)rgb.b - sen * 5, 0); b <=std::min((int)rgb.b + sen * 5, 255); b+=2) {
-                tempColorTable[r/2][g/2][b/2] = currentColor;
+          for (int r = std::max((int)rgb.r - sen * 5, 0); r <=std::min((int)rgb.r + sen * 5, 255); r += Resolution::CELL_WIDTH) {
+            for (int g = std::max((int)rgb.g - sen * 5, 0); g <=std::min((int)rgb.g + sen * 5, 255); g += Resolution::CELL_WIDTH) {
+              for (int b = std::max((int)rgb.b - sen * 5, 0); b <=std::min((int)rgb.b + sen * 5, 255); b += Resolution::CELL_WIDTH) {
+                preview.set(Resolution::toCell(r), Resolution::toCell(g), Resolution::toCell(b), currentColor);
               }
             }
           }
         } else {
-          for (int r = std::max((int)rgb.r - sen * 5, 0); r <=std::min((int)rgb.r + sen * 5, 255); r+=2) {
-            for (int g = std::max((int)rgb.g - sen * 5, 0); g <=std::min((int)rgb.g + sen * 5, 255); g+=2) {
-              for (int b = std::max((int)rgb.b - sen * 5, 0); b <=std::min((int)rgb.b + sen * 5, 255); b+=2) {
-                tempColorTable[r/2][g/2][b/2] = (tempColorTable[r/2][g/2][b/2] == currentColor) ? (uint8_t)UNDEFINED : tempColorTable[r/2][g/2][b/2];
+          for (int r = std::max((int)rgb.r - sen * 5, 0); r <=std::min((int)rgb.r + sen * 5, 255); r += Resolution::CELL_WIDTH) {
+            for (int g = std::max((int)rgb.g - sen * 5, 0); g <=std::min((int)rgb.g + sen * 5, 255); g += Resolution::CELL_WIDTH) {
+              for (int b = std::max((int)rgb.b - sen * 5, 0); b <=std::min((int)rgb.b + sen * 5, 255); b += Resolution::CELL_WIDTH) {
+                if (preview.get(Resolution::toCell(r), Resolution::toCell(g), Resolution::toCell(b)) == currentColor) {
+                  preview.set(Resolution::toCell(r), Resolution::toCell(g), Resolution::toCell(b), UNDEFINED);
+                }
               }
             }
           }
         }
-        redrawImages(true);
+        redrawPreview();
         break;
       }
 
       case Qt::RightButton: {
-        memcpy(colorTable, tempColorTable, 128 * 128 * 128);
-        redrawImages();
+        // The displayed labels may not include the preview (redrawImages()
+        // segments with the committed table), so the pixels it can affect
+        // are relabeled before committing
+        redrawPreview();
+        commitPreview();
         break;
       }
 
@@ -337,8 +591,11 @@ namespace color_table {
 
   void ClassificationWindow::on_actionNew_triggered() {
     colorTableFilename.empty();
-    memset(colorTable, UNDEFINED, 128 * 128 * 128);
-    memset(tempColorTable, UNDEFINED, 128 * 128 * 128);
+    preview.discard();
+    colorTable.clear();
+    history.clear();
+    updateHistoryActions();
+    redrawImages();
   }
 
   void ClassificationWindow::on_actionOpen_triggered() {
@@ -369,10 +626,9 @@ namespace color_table {
       ui.actionSave_As->trigger();
     }
 
-    FILE* f = fopen(colorTableFilename.c_str(), "wb");
-    size_t bytesWritten = fwrite(colorTable, 128*128*128, 1, f);
-    fclose(f);
-    if (!bytesWritten) {
+    ColorTable table;
+    colorTable.toColorTable(table);
+    if (!table.save(colorTableFilename)) {
       ui.statusBar->showMessage("Error writing color table!!");
       return;
     }
@@ -395,4 +651,185 @@ namespace color_table {
 
   }
 
+  void ClassificationWindow::on_actionUndo_triggered() {
+    // An uncommitted edit is simply dropped
+    if (!preview.empty()) {
+      preview.discard();
+      redrawPreview();
+      return;
+    }
+    // Otherwise the old labels are written into the preview, so that only the
+    // affected pixels need to be relabeled before committing
+    if (!history.undo(preview))
+      return;
+    redrawPreview();
+    preview.commit();
+    displayedPreviewBlocks.clear();
+    updateHistoryActions();
+    ui.statusBar->showMessage("Undo");
+  }
+
+  void ClassificationWindow::on_actionRedo_triggered() {
+    preview.discard();
+    redrawPreview();
+    if (!history.redo(preview))
+      return;
+    redrawPreview();
+    preview.commit();
+    displayedPreviewBlocks.clear();
+    updateHistoryActions();
+    ui.statusBar->showMessage("Redo");
+  }
+
+  void ClassificationWindow::on_actionShow_Blobs_toggled(bool checked) {
+    updateBlobOverlay();
+    if (checked) {
+      std::stringstream ss;
+      ss << displayedBlobs.size() << " blobs with at least " << MIN_BLOB_AREA << " pixels";
+      ui.statusBar->showMessage(QString(ss.str().c_str()));
+    }
+  }
+
+  /**
+   * \brief Selects the region around a point of the frame
+   */
+  size_t ClassificationWindow::selectRegion(int x, int y) {
+    RegionFill::Criterion criterion;
+    if (ui.actionRegion_Color->isChecked()) {
+      criterion = RegionFill::SIMILAR_COLOR;
+    } else if (ui.actionRegion_Labels->isChecked()) {
+      criterion = RegionFill::SAME_LABEL;
+    } else {
+      return 0;
+    }
+    return regionFill.fill(frame.getPixels(), &segImage[0], frame.getWidth(), frame.getHeight(),
+        x, y, criterion, ui.sensitivityDial->value() * REGION_TOLERANCE_STEP);
+  }
+
+  /**
+   * \brief Writes the table cells of the region around a point into the preview
+   */
+  void ClassificationWindow::paintRegion(int x, int y) {
+
+    size_t numPixels = selectRegion(x, y);
+    regionFill.getCells(frame.getPixels(), std::max(numPixels / REGION_BIN_FRACTION, (size_t) 1), regionCells);
+
+    preview.discard();
+    if (clickMode == ADD) {
+      preview.setCells(regionCells, currentColor);
+    } else {
+      preview.setCells(regionCells, UNDEFINED, currentColor);
+    }
+    redrawPreview();
+
+    std::stringstream ss;
+    ss << "Region of " << numPixels << " pixels in " << regionCells.size() << " cells";
+    ui.statusBar->showMessage(QString(ss.str().c_str()));
+  }
+
+  /**
+   * \brief Adds the pixels around a point of the frame to the training samples
+   */
+  void ClassificationWindow::addSamples(int x, int y) {
+
+    uint8_t color = (clickMode == ADD) ? currentColor : UNDEFINED;
+    if (selectRegion(x, y) > 0) {
+      const std::vector<uint32_t> &region = regionFill.getRegion();
+      for (size_t i = 0; i < region.size(); i++) {
+        trainingSamples.add(frame.getPixels()[region[i]], color);
+      }
+      updateStatus();
+      return;
+    }
+
+    // The dial sets the half width of the square of pixels sampled
+    int sen = ui.sensitivityDial->value();
+    for (int py = std::max(y - sen, 0); py <= std::min(y + sen, (int)frame.getHeight() - 1); py++) {
+      for (int px = std::max(x - sen, 0); px <= std::min(x + sen, (int)frame.getWidth() - 1); px++) {
+        trainingSamples.add(frame.at(px, py), color);
+      }
+    }
+    updateStatus();
+  }
+
+  /**
+   * \brief Replaces the table with one compiled from the training samples
+   */
+  void ClassificationWindow::compileSamples(CompileMethod method) {
+
+    if (trainingSamples.getNumSamples() == 0) {
+      ui.statusBar->showMessage("No samples collected (see Training > Collect Samples)");
+      return;
+    }
+
+    CompileOptions options;
+    options.method = method;
+    if (method == COMPILE_NEAREST_NEIGHBORS) {
+      options.radius = NEAREST_NEIGHBORS_RADIUS;
+    }
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    QTime timer;
+    timer.start();
+    ColorTable table;
+    compileTable(trainingSamples, options, table);
+
+    // Only the cells that change go through the preview, so that the
+    // compiled table can be undone like any other edit
+    preview.discard();
+    unsigned int numChanged = 0;
+    for (unsigned int r = 0; r < Resolution::SIZE; r++) {
+      for (unsigned int g = 0; g < Resolution::SIZE; g++) {
+        for (unsigned int b = 0; b < Resolution::SIZE; b++) {
+          if (colorTable.get(r, g, b) != table.cell(r, g, b)) {
+            preview.set(r, g, b, table.cell(r, g, b));
+            numChanged++;
+          }
+        }
+      }
+    }
+    redrawPreview();
+    commitPreview();
+    QApplication::restoreOverrideCursor();
+
+    std::stringstream ss;
+    ss << "Compiled table from " << trainingSamples.getNumSamples() << " samples in "
+       << timer.elapsed() << " ms, " << numChanged << " cells changed";
+    ui.statusBar->showMessage(QString(ss.str().c_str()));
+  }
+
+  void ClassificationWindow::on_actionRegion_Color_toggled(bool checked) {
+    // The two region brushes are exclusive, but both can be off
+    if (checked) {
+      ui.actionRegion_Labels->setChecked(false);
+    }
+  }
+
+  void ClassificationWindow::on_actionRegion_Labels_toggled(bool checked) {
+    if (checked) {
+      ui.actionRegion_Color->setChecked(false);
+    }
+  }
+
+  void ClassificationWindow::on_actionCollect_Samples_toggled(bool checked) {
+    updateStatus();
+  }
+
+  void ClassificationWindow::on_actionClear_Samples_triggered() {
+    trainingSamples.clear();
+    updateStatus();
+  }
+
+  void ClassificationWindow::on_actionCompile_Majority_triggered() {
+    compileSamples(COMPILE_MAJORITY);
+  }
+
+  void ClassificationWindow::on_actionCompile_Gaussian_triggered() {
+    compileSamples(COMPILE_GAUSSIAN);
+  }
+
+  void ClassificationWindow::on_actionCompile_Nearest_Neighbors_triggered() {
+    compileSamples(COMPILE_NEAREST_NEIGHBORS);
+  }
+
 }  // namespace color_table
@@ -0,0 +1,187 @@
+/**
+ * \file  filmstrip_widget.cpp
+ * \brief Definitions for the FilmstripWidget class
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 09/08/2011 02:15:48 PM piyushk $
+ */
+
+#include <QtGui>
+#include <algorithm>
+#include <set>
+
+#include <color_table/filmstrip_widget.h>
+
+namespace color_table {
+
+  namespace {
+    /** How often the loader is polled for new thumbnails */
+    const int POLL_MS = 100;
+
+    /** How long the table has to stay unchanged before the sparkline is redone */
+    const int TABLE_SETTLE_MS = 300;
+
+    const int SPARKLINE_GAP = 4;
+    const int SPARKLINE_HEIGHT = 24;
+
+    /** Stride of the first, coarsest pass of requests over the columns */
+    const int COARSEST_STRIDE = 64;
+  }
+
+  FilmstripWidget::FilmstripWidget(QWidget *parent) : QWidget(parent), loader(NULL),
+      numFrames(0), currentFrame(0) {
+    connect(&pollTimer, SIGNAL(timeout()), this, SLOT(pollLoader()));
+    tableTimer.setSingleShot(true);
+    connect(&tableTimer, SIGNAL(timeout()), this, SLOT(applyColorTable()));
+  }
+
+  void FilmstripWidget::setLoader(ThumbnailLoader *loader) {
+    this->loader = loader;
+    if (loader) {
+      loader->setColorTable(table);
+    }
+    requestThumbnails();
+  }
+
+  void FilmstripWidget::setNumFrames(size_t numFrames) {
+    this->numFrames = numFrames;
+    currentFrame = std::min(currentFrame, numFrames > 0 ? numFrames - 1 : 0);
+    if (numFrames == 0) {
+      pollTimer.stop();
+    }
+    requestThumbnails();
+    update();
+  }
+
+  void FilmstripWidget::setCurrentFrame(size_t frame) {
+    currentFrame = frame;
+    update();
+  }
+
+  void FilmstripWidget::setColorTable(const boost::shared_ptr<const BlockColorTable> &table) {
+    // Previews change the table on every mouse move, and every new table
+    // has the workers segment hundreds of thumbnails again
+    nextTable = table;
+    tableTimer.start(TABLE_SETTLE_MS);
+  }
+
+  void FilmstripWidget::applyColorTable() {
+    table = nextTable;
+    nextTable.reset();
+    if (loader) {
+      loader->setColorTable(table);
+      if (numFrames > 0) {
+        pollTimer.start(POLL_MS);
+      }
+    }
+    update();
+  }
+
+  size_t FilmstripWidget::getFrame(int x) const {
+    if (numFrames <= 1 || width() <= 1)
+      return 0;
+    x = std::max(0, std::min(x, width() - 1));
+    return (size_t)x * (numFrames - 1) / (width() - 1);
+  }
+
+  /**
+   * \brief Requests the thumbnails of all frames on screen again
+   */
+  void FilmstripWidget::requestThumbnails() {
+
+    if (!loader || numFrames == 0)
+      return;
+
+    std::vector<size_t> order;
+    std::set<size_t> requested;
+
+    // The thumbnails shown come first, then the sparkline
+    for (int x = 0; x < width(); x += Thumbnail::WIDTH) {
+      size_t frame = getFrame(std::min(x + (int) Thumbnail::WIDTH / 2, width() - 1));
+      if (requested.insert(frame).second) {
+        order.push_back(frame);
+      }
+    }
+    for (int stride = COARSEST_STRIDE; stride >= 1; stride /= 2) {
+      for (int x = 0; x < width(); x += stride) {
+        size_t frame = getFrame(x);
+        if (requested.insert(frame).second) {
+          order.push_back(frame);
+        }
+      }
+    }
+
+    loader->request(order);
+    pollTimer.start(POLL_MS);
+  }
+
+  void FilmstripWidget::pollLoader() {
+    // Checked before taking the changes, so that the last thumbnails are
+    // not missed when the timer is stopped
+    bool busy = loader && loader->isBusy();
+    if (loader && loader->takeChanged()) {
+      update();
+    }
+    if (!busy) {
+      pollTimer.stop();
+    }
+  }
+
+  void FilmstripWidget::paintEvent(QPaintEvent *event) {
+    QPainter painter;
+    painter.begin(this);
+    painter.fillRect(rect(), Qt::black);
+
+    if (!loader || numFrames == 0) {
+      painter.end();
+      return;
+    }
+
+    for (int x = 0; x < width(); x += Thumbnail::WIDTH) {
+      size_t frame = getFrame(std::min(x + (int) Thumbnail::WIDTH / 2, width() - 1));
+      boost::shared_ptr<const Thumbnail> thumbnail = loader->getThumbnail(frame);
+      if (thumbnail) {
+        QImage img(reinterpret_cast<const uchar*>(thumbnail->pixels), Thumbnail::WIDTH, Thumbnail::HEIGHT,
+            3 * Thumbnail::WIDTH, QImage::Format_RGB888);
+        painter.drawImage(QPoint(x, 0), img);
+      } else {
+        painter.fillRect(x + 1, 1, Thumbnail::WIDTH - 2, Thumbnail::HEIGHT - 2, Qt::darkGray);
+      }
+    }
+
+    if (table) {
+      int bottom = Thumbnail::HEIGHT + SPARKLINE_GAP + SPARKLINE_HEIGHT;
+      for (int x = 0; x < width(); x++) {
+        float c = loader->getCoverage(getFrame(x));
+        if (c < 0)
+          continue;
+        int barHeight = std::max(1, (int)(c * SPARKLINE_HEIGHT + 0.5f));
+        painter.fillRect(x, bottom - barHeight, 1, barHeight, Qt::green);
+      }
+    }
+
+    int markerX = (numFrames > 1) ? (int)(currentFrame * (width() - 1) / (numFrames - 1)) : 0;
+    painter.setPen(Qt::red);
+    painter.drawLine(markerX, 0, markerX, height() - 1);
+    painter.end();
+  }
+
+  void FilmstripWidget::resizeEvent(QResizeEvent *event) {
+    requestThumbnails();
+  }
+
+  void FilmstripWidget::mousePressEvent(QMouseEvent *event) {
+    if (event->button() != Qt::LeftButton || numFrames == 0) return;
+    emit frameSelected((int) getFrame(event->x()));
+  }
+
+  void FilmstripWidget::mouseMoveEvent(QMouseEvent *event) {
+    if (!(event->buttons() & Qt::LeftButton) || numFrames == 0) return;
+    emit frameSelected((int) getFrame(event->x()));
+  }
+
+}
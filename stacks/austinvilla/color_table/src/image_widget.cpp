@@ -14,6 +14,7 @@
  */
 
 #include <QtGui>
+#include <algorithm>
 #include <iostream>
 
 #include <color_table/image_widget.h>
@@ -21,34 +22,204 @@
 
 namespace color_table {
 
-  ImageWidget::ImageWidget(QWidget *parent) : QWidget(parent) {
-    img = new QImage(IMAGE_WIDTH,IMAGE_HEIGHT,QImage::Format_RGB32);
-    img->fill(Qt::black);
+  namespace {
+
+    /**
+     * \brief  Source range covered by target pixel i when n pixels are
+     *         reduced to m
+     */
+    inline void getSourceRange(unsigned int i, unsigned int n, unsigned int m, unsigned int &begin, unsigned int &end) {
+      begin = (unsigned int)((size_t)i * n / m);
+      end = std::max(begin + 1, (unsigned int)((size_t)(i + 1) * n / m));
+    }
+  }
+
+  ImageWidget::ImageWidget(QWidget *parent) : QWidget(parent), rgbPixels(NULL), labels(NULL), thumbnail(false),
+      imageWidth(IMAGE_WIDTH), imageHeight(IMAGE_HEIGHT), boxColor(0) {}
+
+  void ImageWidget::setThumbnail(bool thumbnail) {
+    this->thumbnail = thumbnail;
+  }
+
+  void ImageWidget::showRgb(const Rgb *pixels, unsigned int width, unsigned int height) {
+
+    imageWidth = width;
+    imageHeight = height;
+    rgbPixels = pixels;
+    labels = NULL;
+    if (width == 0 || height == 0) {
+      rgbPixels = NULL;
+      img = QImage();
+      update();
+      return;
+    }
+
+    if (!thumbnail) {
+      // The non-const constructor, so that the image never detaches (copies)
+      // the buffer. Nothing writes through it.
+      img = QImage(reinterpret_cast<uchar*>(const_cast<Rgb*>(pixels)), width, height, 3 * width, QImage::Format_RGB888);
+      update();
+      return;
+    }
+    downsampleRgb();
+  }
+
+  /**
+   * \brief Box filters the rgb buffer down to the size of the widget
+   */
+  void ImageWidget::downsampleRgb() {
+
+    const Rgb *pixels = rgbPixels;
+    unsigned int width = imageWidth;
+    unsigned int height = imageHeight;
+    unsigned int thumbWidth = std::min(width, (unsigned int)this->width());
+    unsigned int thumbHeight = std::min(height, (unsigned int)this->height());
+    if (img.width() != (int)thumbWidth || img.height() != (int)thumbHeight || img.format() != QImage::Format_RGB32) {
+      img = QImage(thumbWidth, thumbHeight, QImage::Format_RGB32);
+    }
+    std::vector<unsigned int> columnStarts(thumbWidth + 1);
+    for (unsigned int tx = 0; tx < thumbWidth; tx++) {
+      unsigned int end;
+      getSourceRange(tx, width, thumbWidth, columnStarts[tx], end);
+    }
+    columnStarts[thumbWidth] = width;
+    std::vector<unsigned int> sums(3 * thumbWidth);
+    for (unsigned int ty = 0; ty < thumbHeight; ty++) {
+      unsigned int yBegin, yEnd;
+      getSourceRange(ty, height, thumbHeight, yBegin, yEnd);
+      std::fill(sums.begin(), sums.end(), 0);
+      for (unsigned int y = yBegin; y < yEnd; y++) {
+        const Rgb *row = pixels + (size_t)y * width;
+        for (unsigned int tx = 0; tx < thumbWidth; tx++) {
+          for (unsigned int x = columnStarts[tx]; x < columnStarts[tx + 1]; x++) {
+            sums[3 * tx + 0] += row[x].r;
+            sums[3 * tx + 1] += row[x].g;
+            sums[3 * tx + 2] += row[x].b;
+          }
+        }
+      }
+      QRgb *line = reinterpret_cast<QRgb*>(img.scanLine(ty));
+      for (unsigned int tx = 0; tx < thumbWidth; tx++) {
+        unsigned int count = (yEnd - yBegin) * (columnStarts[tx + 1] - columnStarts[tx]);
+        line[tx] = qRgb(sums[3 * tx] / count, sums[3 * tx + 1] / count, sums[3 * tx + 2] / count);
+      }
+    }
+    update();
   }
 
-  void ImageWidget::reduceImageSize(int factor){
-    img = new QImage(IMAGE_WIDTH/factor,IMAGE_HEIGHT/factor,QImage::Format_RGB32);
-    img->fill(Qt::black);
+  void ImageWidget::showLabels(const uint8_t *labels, unsigned int width, unsigned int height, const QVector<QRgb> &palette) {
+
+    imageWidth = width;
+    imageHeight = height;
+    rgbPixels = NULL;
+    this->labels = labels;
+    this->palette = palette;
+    if (width == 0 || height == 0 || !labels) {
+      this->labels = NULL;
+      img = QImage();
+      update();
+      return;
+    }
+
+    if (!thumbnail) {
+      // See showRgb(): setColorTable() would copy a read only buffer
+      img = QImage(const_cast<uchar*>(labels), width, height, width, QImage::Format_Indexed8);
+      img.setColorTable(palette);
+      update();
+      return;
+    }
+    downsampleLabels();
+  }
+
+  /**
+   * \brief Reduces the label buffer to the size of the widget. Averaging
+   *        labels makes no sense, so the thumbnail samples the label at the
+   *        center of each box instead.
+   */
+  void ImageWidget::downsampleLabels() {
+
+    unsigned int width = imageWidth;
+    unsigned int height = imageHeight;
+    unsigned int thumbWidth = std::min(width, (unsigned int)this->width());
+    unsigned int thumbHeight = std::min(height, (unsigned int)this->height());
+    if (img.width() != (int)thumbWidth || img.height() != (int)thumbHeight || img.format() != QImage::Format_Indexed8) {
+      img = QImage(thumbWidth, thumbHeight, QImage::Format_Indexed8);
+    }
+    img.setColorTable(palette);
+    std::vector<unsigned int> columns(thumbWidth);
+    for (unsigned int tx = 0; tx < thumbWidth; tx++) {
+      unsigned int begin, end;
+      getSourceRange(tx, width, thumbWidth, begin, end);
+      columns[tx] = (begin + end) / 2;
+    }
+    for (unsigned int ty = 0; ty < thumbHeight; ty++) {
+      unsigned int begin, end;
+      getSourceRange(ty, height, thumbHeight, begin, end);
+      const uint8_t *row = labels + (size_t)((begin + end) / 2) * width;
+      uchar *line = img.scanLine(ty);
+      for (unsigned int tx = 0; tx < thumbWidth; tx++) {
+        line[tx] = row[columns[tx]];
+      }
+    }
+    update();
   }
-   
+
+  void ImageWidget::setBoxes(const std::vector<QRect> &boxes, QRgb color) {
+    if (boxes.empty() && this->boxes.empty())
+      return;
+    this->boxes = boxes;
+    boxColor = color;
+    update();
+  }
+
+  /**
+   * \brief Rebuilds the thumbnail at the new size, instead of stretching
+   *        the one built for the old size
+   */
+  void ImageWidget::resizeEvent(QResizeEvent *event) {
+    if (!thumbnail)
+      return;
+    if (rgbPixels) {
+      downsampleRgb();
+    } else if (labels) {
+      downsampleLabels();
+    }
+  }
+
   void ImageWidget::paintEvent(QPaintEvent *event) {
     QPainter painter;
     painter.begin(this);
 
-    painter.drawImage(event->rect(), *img);
+    if (img.isNull()) {
+      painter.fillRect(rect(), Qt::black);
+      painter.end();
+      return;
+    }
+    painter.drawImage(rect(), img);
+
+    if (!boxes.empty()) {
+      painter.scale((qreal)width() / imageWidth, (qreal)height() / imageHeight);
+      QPen pen(QColor(boxColor));
+      pen.setCosmetic(true);
+      painter.setPen(pen);
+      painter.setBrush(Qt::NoBrush);
+      for (unsigned int i = 0; i < boxes.size(); i++) {
+        painter.drawRect(boxes[i]);
+      }
+    }
     painter.end();
   }
 
   void ImageWidget::mousePressEvent(QMouseEvent *event) {
     if (event->button() != Qt::LeftButton && event->button() != Qt::RightButton) return;
-    float x=(float)event->x()/(float)width()*IMAGE_WIDTH;
-    float y=(float)event->y()/(float)height()*IMAGE_HEIGHT;
+    float x=(float)event->x()/(float)width()*imageWidth;
+    float y=(float)event->y()/(float)height()*imageHeight;
     emit clicked((int)x,(int)y, (int) event->button());
   }
 
   void ImageWidget::mouseMoveEvent(QMouseEvent *event) {
-    float x=(float)event->x()/(float)width()*IMAGE_WIDTH;
-    float y=(float)event->y()/(float)height()*IMAGE_HEIGHT;
+    float x=(float)event->x()/(float)width()*imageWidth;
+    float y=(float)event->y()/(float)height()*imageHeight;
     emit mouseXY((int)x,(int)y);
   }
 
@@ -0,0 +1,183 @@
+/**
+ * \file  blob_detector.cpp
+ * \brief Definitions for the BlobDetector class
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 08/26/2011 11:02:33 AM piyushk $
+ */
+
+#include <algorithm>
+
+#include <color_table/blob_detector.h>
+
+namespace color_table {
+
+  namespace {
+
+    /**
+     * \brief  Blob statistics accumulated over the runs of a component
+     */
+    struct BlobAccumulator {
+      uint8_t color;
+      unsigned int area;
+      double sumX, sumY;
+      uint16_t xMin, xMax, yMin, yMax;
+      unsigned int numRuns;
+    };
+  }
+
+  BlobDetector::BlobDetector(unsigned int minArea) : minArea(minArea) {}
+
+  /**
+   * \brief   Finds the blobs in a label image
+   */
+  void BlobDetector::detect(const uint8_t *labels, unsigned int width, unsigned int height, size_t labelStep) {
+    encodeRuns(labels, width, height, labelStep);
+    mergeRuns();
+    collectBlobs();
+  }
+
+  /**
+   * \brief   Run length encodes every row, skipping UNDEFINED pixels
+   */
+  void BlobDetector::encodeRuns(const uint8_t *labels, unsigned int width, unsigned int height, size_t labelStep) {
+    runs.clear();
+    rowStarts.resize(height + 1);
+    for (unsigned int y = 0; y < height; y++) {
+      rowStarts[y] = runs.size();
+      const uint8_t *row = labels + y * labelStep;
+      unsigned int x = 0;
+      while (x < width) {
+        uint8_t color = row[x];
+        unsigned int start = x;
+        while (x < width && row[x] == color) {
+          x++;
+        }
+        if (color != UNDEFINED) {
+          Run run;
+          run.y = y;
+          run.xStart = start;
+          run.xEnd = x;
+          run.color = color;
+          run.parent = runs.size();
+          runs.push_back(run);
+        }
+      }
+    }
+    rowStarts[height] = runs.size();
+  }
+
+  /**
+   * \brief   Unions runs of the same color that overlap in consecutive rows
+   */
+  void BlobDetector::mergeRuns() {
+    for (unsigned int y = 1; y + 1 < rowStarts.size(); y++) {
+      unsigned int above = rowStarts[y - 1], aboveEnd = rowStarts[y];
+      unsigned int current = rowStarts[y], currentEnd = rowStarts[y + 1];
+      // Both rows are sorted by x, so walk them together
+      while (above < aboveEnd && current < currentEnd) {
+        const Run &a = runs[above];
+        const Run &c = runs[current];
+        if (a.xStart < c.xEnd && c.xStart < a.xEnd && a.color == c.color) {
+          unsigned int rootA = findRoot(above);
+          unsigned int rootC = findRoot(current);
+          if (rootA != rootC) {
+            // Keep the earlier run as the root so that roots come first
+            runs[std::max(rootA, rootC)].parent = std::min(rootA, rootC);
+          }
+        }
+        if (a.xEnd < c.xEnd) {
+          above++;
+        } else {
+          current++;
+        }
+      }
+    }
+  }
+
+  /**
+   * \brief   Gathers the statistics of each component
+   */
+  void BlobDetector::collectBlobs() {
+
+    std::vector<BlobAccumulator> components;
+    std::vector<int> componentOfRun(runs.size());
+    for (unsigned int i = 0; i < runs.size(); i++) {
+      const Run &run = runs[i];
+      unsigned int root = findRoot(i);
+      if (root == i) {
+        // Roots are the first run of their component (see mergeRuns())
+        componentOfRun[i] = components.size();
+        BlobAccumulator component = {run.color, 0, 0, 0, run.xStart, (uint16_t)(run.xEnd - 1), run.y, run.y, 0};
+        components.push_back(component);
+      } else {
+        componentOfRun[i] = componentOfRun[root];
+      }
+      BlobAccumulator &component = components[componentOfRun[i]];
+      unsigned int length = run.xEnd - run.xStart;
+      component.area += length;
+      component.sumX += length * (run.xStart + run.xEnd - 1) / 2.0;
+      component.sumY += (double)length * run.y;
+      component.xMin = std::min(component.xMin, run.xStart);
+      component.xMax = std::max(component.xMax, (uint16_t)(run.xEnd - 1));
+      component.yMax = run.y;
+      component.numRuns++;
+    }
+
+    blobs.clear();
+    std::vector<int> blobOfComponent(components.size(), -1);
+    for (unsigned int i = 0; i < components.size(); i++) {
+      const BlobAccumulator &component = components[i];
+      if (component.area < minArea)
+        continue;
+      Blob blob;
+      blob.area = component.area;
+      blob.xMin = component.xMin;
+      blob.xMax = component.xMax;
+      blob.yMin = component.yMin;
+      blob.yMax = component.yMax;
+      blob.centroidX = component.sumX / component.area;
+      blob.centroidY = component.sumY / component.area;
+      blob.numRuns = component.numRuns;
+      blob.color = component.color;
+      blobOfComponent[i] = blobs.size();
+      blobs.push_back(blob);
+    }
+
+    // Sort largest first, keeping track of where each blob went
+    std::vector<std::pair<unsigned int, unsigned int> > order(blobs.size());
+    for (unsigned int i = 0; i < blobs.size(); i++) {
+      order[i] = std::make_pair(~blobs[i].area, i);
+    }
+    std::sort(order.begin(), order.end());
+    std::vector<Blob> sorted(blobs.size());
+    std::vector<int> newIndex(blobs.size());
+    for (unsigned int i = 0; i < order.size(); i++) {
+      sorted[i] = blobs[order[i].second];
+      newIndex[order[i].second] = i;
+    }
+    blobs.swap(sorted);
+
+    blobOfRun.resize(runs.size());
+    for (unsigned int i = 0; i < runs.size(); i++) {
+      int blob = blobOfComponent[componentOfRun[i]];
+      blobOfRun[i] = (blob >= 0) ? newIndex[blob] : -1;
+    }
+  }
+
+  /**
+   * \brief   Root of the component a run belongs to, with path halving
+   */
+  unsigned int BlobDetector::findRoot(unsigned int run) {
+    while (runs[run].parent != run) {
+      runs[run].parent = runs[runs[run].parent].parent;
+      run = runs[run].parent;
+    }
+    return run;
+  }
+
+}
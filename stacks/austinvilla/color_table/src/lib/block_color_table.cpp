@@ -0,0 +1,340 @@
+/**
+ * \file  block_color_table.cpp
+ * \brief Definitions for the BlockColorTable and ColorTablePreview classes
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 08/19/2011 11:47:58 AM piyushk $
+ */
+
+#include <cstring>
+#include <boost/checked_delete.hpp>
+
+#include <color_table/block_color_table.h>
+
+namespace color_table {
+
+  namespace {
+
+    /**
+     * \brief   Number of stale blocks past which a shared flat table is
+     *          copied and brought up to date, instead of marking more blocks
+     */
+    const unsigned int MAX_STALE_BLOCKS = BlockColorTable::NUM_BLOCKS / 8;
+
+    BlockColorTable::BlockPtr allocateBlock() {
+      return BlockColorTable::BlockPtr(new uint8_t[BlockColorTable::BLOCK_CELLS],
+          boost::checked_array_deleter<uint8_t>());
+    }
+
+    /**
+     * \brief   Copies the cells of a block into a flat table
+     */
+    void copyBlock(unsigned int block, const uint8_t *cells, ColorTable &table) {
+      const unsigned int perAxis = BlockColorTable::BLOCKS_PER_AXIS;
+      const unsigned int size = BlockColorTable::BLOCK_SIZE;
+      unsigned int r0 = (block / (perAxis * perAxis)) * size;
+      unsigned int g0 = ((block / perAxis) % perAxis) * size;
+      unsigned int b0 = (block % perAxis) * size;
+      for (unsigned int r = 0; r < size; r++) {
+        for (unsigned int g = 0; g < size; g++) {
+          memcpy(&table.getArray()[r0 + r][g0 + g][b0], cells + (r * size + g) * size, size);
+        }
+      }
+    }
+
+    /**
+     * \brief   Segments packed pixels with the shared kernel. Pixels hold
+     *          whatever channels the table is indexed by, in Rgb order.
+     */
+    inline void segmentFlat(const ColorTable &table, const Rgb *pixels, size_t numPixels, uint8_t *labels) {
+      if (numPixels == 0)
+        return;
+      table.segment(reinterpret_cast<const uint8_t*>(pixels), numPixels, 1, numPixels * sizeof(Rgb),
+          RGB8_LAYOUT, labels, numPixels);
+    }
+  }
+
+  /**
+   * \brief   Constructs a table with every cell set to UNDEFINED
+   */
+  BlockColorTable::BlockColorTable() {
+    undefinedBlock = allocateBlock();
+    memset(undefinedBlock.get(), UNDEFINED, BLOCK_CELLS);
+    blocks.assign(NUM_BLOCKS, undefinedBlock);
+    isStale.assign(NUM_BLOCKS, 0);
+  }
+
+  /**
+   * \brief   Copies share the flat table of the source, which is built here
+   *          if needed so that later copies do not each build their own
+   */
+  BlockColorTable::BlockColorTable(const BlockColorTable &other) :
+      blocks(other.blocks), undefinedBlock(other.undefinedBlock), flatTable(other.getFlatTable()),
+      isStale(other.isStale), staleBlocks(other.staleBlocks) {}
+
+  BlockColorTable& BlockColorTable::operator=(const BlockColorTable &other) {
+    if (this != &other) {
+      blocks = other.blocks;
+      undefinedBlock = other.undefinedBlock;
+      flatTable = other.getFlatTable();
+      isStale = other.isStale;
+      staleBlocks = other.staleBlocks;
+    }
+    return *this;
+  }
+
+  /**
+   * \brief   Sets every cell to UNDEFINED
+   */
+  void BlockColorTable::clear() {
+    blocks.assign(NUM_BLOCKS, undefinedBlock);
+    for (unsigned int i = 0; i < staleBlocks.size(); i++) {
+      isStale[staleBlocks[i]] = 0;
+    }
+    staleBlocks.clear();
+    if (flatTable && flatTable.unique()) {
+      flatTable->clear();
+    } else {
+      flatTable.reset();
+    }
+  }
+
+  /**
+   * \brief   Returns a new, unshared copy of a block
+   */
+  BlockColorTable::BlockPtr BlockColorTable::cloneBlock(const BlockPtr &block) {
+    BlockPtr copy = allocateBlock();
+    memcpy(copy.get(), block.get(), BLOCK_CELLS);
+    return copy;
+  }
+
+  /**
+   * \brief   Copies a flat table into this one
+   */
+  void BlockColorTable::fromColorTable(const ColorTable &table) {
+    uint8_t cells[BLOCK_CELLS];
+    for (unsigned int block = 0; block < NUM_BLOCKS; block++) {
+      unsigned int r0 = (block / (BLOCKS_PER_AXIS * BLOCKS_PER_AXIS)) * BLOCK_SIZE;
+      unsigned int g0 = ((block / BLOCKS_PER_AXIS) % BLOCKS_PER_AXIS) * BLOCK_SIZE;
+      unsigned int b0 = (block % BLOCKS_PER_AXIS) * BLOCK_SIZE;
+      bool undefined = true;
+      for (unsigned int r = 0; r < BLOCK_SIZE; r++) {
+        for (unsigned int g = 0; g < BLOCK_SIZE; g++) {
+          uint8_t *row = cells + (r * BLOCK_SIZE + g) * BLOCK_SIZE;
+          memcpy(row, &table.getArray()[r0 + r][g0 + g][b0], BLOCK_SIZE);
+          for (unsigned int b = 0; b < BLOCK_SIZE; b++) {
+            undefined &= (row[b] == UNDEFINED);
+          }
+        }
+      }
+      if (undefined) {
+        blocks[block] = undefinedBlock;
+      } else {
+        blocks[block] = allocateBlock();
+        memcpy(blocks[block].get(), cells, BLOCK_CELLS);
+      }
+    }
+
+    // The flat table is a plain copy of the source
+    for (unsigned int i = 0; i < staleBlocks.size(); i++) {
+      isStale[staleBlocks[i]] = 0;
+    }
+    staleBlocks.clear();
+    flatTable.reset(new ColorTable(table));
+  }
+
+  /**
+   * \brief   Copies this table into a flat table
+   */
+  void BlockColorTable::toColorTable(ColorTable &table) const {
+    for (unsigned int block = 0; block < NUM_BLOCKS; block++) {
+      copyBlock(block, blocks[block].get(), table);
+    }
+  }
+
+  /**
+   * \brief   Sets a single cell, copying its block first if it is shared
+   */
+  void BlockColorTable::set(unsigned int r, unsigned int g, unsigned int b, uint8_t color) {
+    BlockPtr &block = blocks[getBlockIndex(r, g, b)];
+    if (!block.unique()) {
+      block = cloneBlock(block);
+    }
+    block.get()[getCellIndex(r, g, b)] = color;
+    markStale(getBlockIndex(r, g, b));
+  }
+
+  /**
+   * \brief   Flat copy of the table, built on first use
+   */
+  boost::shared_ptr<ColorTable> BlockColorTable::getFlatTable() const {
+    boost::mutex::scoped_lock lock(flatMutex);
+    if (!flatTable) {
+      // Nothing is stale while there is no flat table
+      boost::shared_ptr<ColorTable> table(new ColorTable);
+      toColorTable(*table);
+      flatTable = table;
+    }
+    return flatTable;
+  }
+
+  /**
+   * \brief   Brings the flat table up to date with a changed block
+   */
+  void BlockColorTable::markStale(unsigned int block) {
+    if (!flatTable)
+      return;
+
+    if (flatTable.unique()) {
+      flushStale();
+      copyBlock(block, blocks[block].get(), *flatTable);
+      return;
+    }
+
+    if (!isStale[block]) {
+      isStale[block] = 1;
+      staleBlocks.push_back(block);
+    }
+    if (staleBlocks.size() > MAX_STALE_BLOCKS) {
+      // Copies keep the old flat table, this one gets its own
+      flatTable.reset(new ColorTable(*flatTable));
+      flushStale();
+    }
+  }
+
+  /**
+   * \brief   Copies the stale blocks into the flat table
+   */
+  void BlockColorTable::flushStale() {
+    for (unsigned int i = 0; i < staleBlocks.size(); i++) {
+      copyBlock(staleBlocks[i], blocks[staleBlocks[i]].get(), *flatTable);
+      isStale[staleBlocks[i]] = 0;
+    }
+    staleBlocks.clear();
+  }
+
+  /**
+   * \brief   Segments a packed array of pixels
+   */
+  void BlockColorTable::segment(const Rgb *pixels, size_t numPixels, uint8_t *labels) const {
+    segment(pixels, numPixels, labels, NULL);
+  }
+
+  /**
+   * \brief   Segments pixels, taking the blocks of overlay in place of the
+   *          table's own wherever they are set
+   */
+  void BlockColorTable::segment(const Rgb *pixels, size_t numPixels, uint8_t *labels,
+      const std::vector<BlockPtr> *overlay) const {
+
+    segmentFlat(*getFlatTable(), pixels, numPixels, labels);
+    if (staleBlocks.empty() && !overlay)
+      return;
+
+    // Relabel the pixels whose block differs from the flat table
+    for (size_t i = 0; i < numPixels; i++) {
+      unsigned int r = Resolution::toCell(pixels[i].r);
+      unsigned int g = Resolution::toCell(pixels[i].g);
+      unsigned int b = Resolution::toCell(pixels[i].b);
+      unsigned int block = getBlockIndex(r, g, b);
+      const uint8_t *cells = NULL;
+      if (overlay && (*overlay)[block]) {
+        cells = (*overlay)[block].get();
+      } else if (isStale[block]) {
+        cells = blocks[block].get();
+      }
+      if (cells) {
+        labels[i] = cells[getCellIndex(r, g, b)];
+      }
+    }
+  }
+
+  ColorTablePreview::ColorTablePreview(BlockColorTable &base) :
+      base(&base), overlay(BlockColorTable::NUM_BLOCKS) {}
+
+  /**
+   * \brief   Sets a cell in the preview, leaving the base table untouched
+   */
+  void ColorTablePreview::set(unsigned int r, unsigned int g, unsigned int b, uint8_t color) {
+    unsigned int block = BlockColorTable::getBlockIndex(r, g, b);
+    if (!overlay[block]) {
+      overlay[block] = BlockColorTable::cloneBlock(base->getBlock(block));
+      touchedBlocks.push_back(block);
+    }
+    overlay[block].get()[BlockColorTable::getCellIndex(r, g, b)] = color;
+  }
+
+  /**
+   * \brief   Sets many cells in one pass
+   */
+  void ColorTablePreview::setCells(const std::vector<uint32_t> &keys, uint8_t color, uint8_t onlyColor) {
+
+    const unsigned int cellBits = 3 * BlockColorTable::BLOCK_BITS;
+    const uint32_t cellMask = BlockColorTable::BLOCK_CELLS - 1;
+
+    size_t first = 0;
+    while (first < keys.size()) {
+      unsigned int block = keys[first] >> cellBits;
+      size_t last = first + 1;
+      while (last < keys.size() && (keys[last] >> cellBits) == block) {
+        last++;
+      }
+
+      // Looking before writing keeps untouched blocks shared
+      const uint8_t *cells = getBlock(block).get();
+      bool changes = false;
+      for (size_t i = first; i < last && !changes; i++) {
+        uint8_t current = cells[keys[i] & cellMask];
+        changes = (current != color) && (onlyColor == NUM_COLORS || current == onlyColor);
+      }
+
+      if (changes) {
+        if (!overlay[block]) {
+          overlay[block] = BlockColorTable::cloneBlock(base->getBlock(block));
+          touchedBlocks.push_back(block);
+        }
+        uint8_t *writable = overlay[block].get();
+        for (size_t i = first; i < last; i++) {
+          uint8_t &cell = writable[keys[i] & cellMask];
+          if (onlyColor == NUM_COLORS || cell == onlyColor) {
+            cell = color;
+          }
+        }
+      }
+      first = last;
+    }
+  }
+
+  /**
+   * \brief   Segments a packed array of pixels as if the edits were committed
+   */
+  void ColorTablePreview::segment(const Rgb *pixels, size_t numPixels, uint8_t *labels) const {
+    base->segment(pixels, numPixels, labels, touchedBlocks.empty() ? NULL : &overlay);
+  }
+
+  /**
+   * \brief   Applies the edits to the base table and empties the preview
+   */
+  void ColorTablePreview::commit() {
+    for (unsigned int i = 0; i < touchedBlocks.size(); i++) {
+      base->swapBlock(touchedBlocks[i], overlay[touchedBlocks[i]]);
+      overlay[touchedBlocks[i]].reset();
+    }
+    touchedBlocks.clear();
+  }
+
+  /**
+   * \brief   Drops all edits
+   */
+  void ColorTablePreview::discard() {
+    for (unsigned int i = 0; i < touchedBlocks.size(); i++) {
+      overlay[touchedBlocks[i]].reset();
+    }
+    touchedBlocks.clear();
+  }
+
+}
@@ -0,0 +1,86 @@
+/**
+ * \file  color_histogram.cpp
+ * \brief Definitions for the ColorHistogram class
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 09/07/2011 11:04:52 AM piyushk $
+ */
+
+#include <algorithm>
+
+#include <color_table/color_histogram.h>
+
+namespace color_table {
+
+  ColorHistogram::ColorHistogram() : numPixels(0) {}
+
+  /**
+   * \brief   Replaces the histogram with that of a buffer of pixels
+   */
+  void ColorHistogram::build(const Rgb *pixels, size_t numPixels) {
+
+    std::vector<uint32_t> pixelKeys(numPixels);
+    for (size_t i = 0; i < numPixels; i++) {
+      pixelKeys[i] = BlockColorTable::getCellKey(Resolution::toCell(pixels[i].r),
+          Resolution::toCell(pixels[i].g), Resolution::toCell(pixels[i].b));
+    }
+    std::sort(pixelKeys.begin(), pixelKeys.end());
+
+    keys.clear();
+    counts.clear();
+    size_t first = 0;
+    while (first < numPixels) {
+      size_t last = first + 1;
+      while (last < numPixels && pixelKeys[last] == pixelKeys[first]) {
+        last++;
+      }
+      keys.push_back(pixelKeys[first]);
+      counts.push_back(last - first);
+      first = last;
+    }
+    this->numPixels = numPixels;
+  }
+
+  /**
+   * \brief   Adds the counts of another histogram to this one
+   */
+  void ColorHistogram::add(const ColorHistogram &other) {
+
+    // Both key lists are sorted, so they are merged in one pass
+    std::vector<uint32_t> mergedKeys;
+    std::vector<uint64_t> mergedCounts;
+    mergedKeys.reserve(keys.size() + other.keys.size());
+    mergedCounts.reserve(keys.size() + other.keys.size());
+    size_t i = 0, j = 0;
+    while (i < keys.size() || j < other.keys.size()) {
+      if (j == other.keys.size() || (i < keys.size() && keys[i] < other.keys[j])) {
+        mergedKeys.push_back(keys[i]);
+        mergedCounts.push_back(counts[i]);
+        i++;
+      } else if (i == keys.size() || other.keys[j] < keys[i]) {
+        mergedKeys.push_back(other.keys[j]);
+        mergedCounts.push_back(other.counts[j]);
+        j++;
+      } else {
+        mergedKeys.push_back(keys[i]);
+        mergedCounts.push_back(counts[i] + other.counts[j]);
+        i++;
+        j++;
+      }
+    }
+    keys.swap(mergedKeys);
+    counts.swap(mergedCounts);
+    numPixels += other.numPixels;
+  }
+
+  void ColorHistogram::clear() {
+    keys.clear();
+    counts.clear();
+    numPixels = 0;
+  }
+
+}
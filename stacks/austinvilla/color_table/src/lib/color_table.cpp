@@ -0,0 +1,397 @@
+/**
+ * \file  color_table.cpp
+ * \brief Definitions for the ColorTable class
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 08/17/2011 10:22:13 AM piyushk $
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+
+#include <boost/checked_delete.hpp>
+#include <boost/lexical_cast.hpp>
+#include <sensor_msgs/image_encodings.h>
+
+#include <color_table/color_table.h>
+
+namespace color_table {
+
+  namespace {
+    inline void setError(std::string *error, const std::string &message) {
+      if (error) {
+        *error = message;
+      }
+    }
+
+    /**
+     * \brief   Whether every row of a message lies within its data buffer
+     * \param   rowBytes Bytes read from each row
+     */
+    inline bool hasRows(const std::vector<uint8_t> &data, unsigned int height, size_t step, size_t rowBytes) {
+      return step >= rowBytes && data.size() >= (size_t)(height - 1) * step + rowBytes;
+    }
+
+    /**
+     * \brief   Reads a whole file into memory
+     */
+    bool readFile(const std::string &filename, std::vector<uint8_t> &data, std::string *error) {
+      FILE* f = fopen(filename.c_str(), "rb");
+      if (!f) {
+        setError(error, "Unable to open " + filename + ": " + strerror(errno));
+        return false;
+      }
+      long size = -1;
+      if (fseek(f, 0, SEEK_END) == 0) {
+        size = ftell(f);
+      }
+      bool success = size > 0 && fseek(f, 0, SEEK_SET) == 0;
+      if (success) {
+        data.resize(size);
+        success = fread(&data[0], 1, size, f) == (size_t)size;
+      }
+      fclose(f);
+      if (!success) {
+        setError(error, "Unable to read " + filename);
+      }
+      return success;
+    }
+  }
+
+  /**
+   * \brief   Constructs a table with every cell set to UNDEFINED
+   */
+  ColorTable::ColorTable() : colorSpace(COLOR_SPACE_RGB) {
+    allocate();
+    clear();
+  }
+
+  ColorTable::ColorTable(const ColorTable &other) : colorSpace(other.colorSpace) {
+    allocate();
+    memcpy(table, other.table, NUM_CELLS);
+  }
+
+  ColorTable& ColorTable::operator=(const ColorTable &other) {
+    if (this != &other) {
+      memcpy(table, other.table, NUM_CELLS);
+      colorSpace = other.colorSpace;
+    }
+    return *this;
+  }
+
+  /**
+   * \brief   Replaces the storage with a fresh heap allocation
+   */
+  void ColorTable::allocate() {
+    boost::shared_ptr<uint8_t> cells(new uint8_t[NUM_CELLS], boost::checked_array_deleter<uint8_t>());
+    storage = cells;
+    table = reinterpret_cast<ColorTableArray*>(cells.get());
+  }
+
+  /**
+   * \brief   Loads the table from file
+   */
+  bool ColorTable::load(const std::string &filename, std::string *error, unsigned int callerBits) {
+
+    // A mismatch means the caller and the library disagree on the size of
+    // the table, and the caller's inline lookups would read out of bounds
+    if (callerBits != Resolution::BITS_PER_CHANNEL) {
+      setError(error, "color_table_runtime was built with COLOR_TABLE_BITS=" +
+          boost::lexical_cast<std::string>(Resolution::BITS_PER_CHANNEL) + ", but the caller with " +
+          boost::lexical_cast<std::string>(callerBits));
+      return false;
+    }
+
+    std::vector<uint8_t> file;
+    if (!readFile(filename, file, error)) {
+      return false;
+    }
+
+    boost::shared_ptr<void> newStorage;
+    uint8_t *cells = NULL;
+    unsigned int fileBits = 0;
+    ColorSpace fileColorSpace = COLOR_SPACE_RGB;
+    TableFileHeader header;
+    if (readTableFileHeader(&file[0], file.size(), header)) {
+      fileBits = header.bitsPerChannel;
+      fileColorSpace = static_cast<ColorSpace>(header.colorSpace);
+      if (fileBits < 5 || fileBits > 8) {
+        setError(error, filename + ": unsupported color table resolution");
+        return false;
+      }
+      boost::shared_ptr<uint8_t> decoded(new uint8_t[(size_t)1 << (3 * fileBits)], boost::checked_array_deleter<uint8_t>());
+      std::string decodeError;
+      if (!decodeTableFile(&file[0], file.size(), decoded.get(), &decodeError)) {
+        setError(error, filename + ": " + decodeError);
+        return false;
+      }
+      newStorage = decoded;
+      cells = decoded.get();
+    } else if ((fileBits = getRawTableBits(file.size())) != 0) {
+      // Legacy raw table
+      boost::shared_ptr<uint8_t> raw(new uint8_t[file.size()], boost::checked_array_deleter<uint8_t>());
+      memcpy(raw.get(), &file[0], file.size());
+      newStorage = raw;
+      cells = raw.get();
+    } else {
+      setError(error, filename + " is not a valid color table (wrong size)");
+      return false;
+    }
+
+    const unsigned int numFileCells = 1 << (3 * fileBits);
+    for (unsigned int i = 0; i < numFileCells; i++) {
+      if (cells[i] >= NUM_COLORS) {
+        setError(error, filename + " is not a valid color table (invalid color)");
+        return false;
+      }
+    }
+
+    // Tables saved at a different resolution are converted to the one this
+    // package was built with
+    if (fileBits != Resolution::BITS_PER_CHANNEL) {
+      boost::shared_ptr<uint8_t> resampled(new uint8_t[NUM_CELLS], boost::checked_array_deleter<uint8_t>());
+      resampleTable(cells, fileBits, resampled.get(), Resolution::BITS_PER_CHANNEL);
+      newStorage = resampled;
+      cells = resampled.get();
+    }
+
+    storage = newStorage;
+    table = reinterpret_cast<ColorTableArray*>(cells);
+    colorSpace = fileColorSpace;
+    return true;
+  }
+
+  /**
+   * \brief   Saves the table to file
+   */
+  bool ColorTable::save(const std::string &filename, std::string *error, TableFileFormat format) const {
+
+    const uint8_t *data = &(*table)[0][0][0];
+    size_t size = NUM_CELLS;
+    std::vector<uint8_t> encoded;
+    if (format == FORMAT_RAW && colorSpace != COLOR_SPACE_RGB) {
+      setError(error, "Only rgb tables can be saved in the raw format");
+      return false;
+    }
+    if (format == FORMAT_V2) {
+      encodeTableFile(data, Resolution::BITS_PER_CHANNEL, colorSpace, encoded);
+      data = &encoded[0];
+      size = encoded.size();
+    }
+
+    // Write to a temporary file and rename it over the original, so that a
+    // process loading filename at the same time never sees a partial table
+    std::string tempFilename = filename + ".tmp";
+    FILE* f = fopen(tempFilename.c_str(), "wb");
+    if (!f) {
+      setError(error, "Unable to open " + tempFilename + ": " + strerror(errno));
+      return false;
+    }
+
+    size_t bytesWritten = fwrite(data, 1, size, f);
+    bool closed = (fclose(f) == 0);
+    if (bytesWritten != size || !closed || rename(tempFilename.c_str(), filename.c_str()) != 0) {
+      remove(tempFilename.c_str());
+      setError(error, "Error writing " + filename);
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * \brief   Checks that every cell holds a valid color
+   */
+  bool ColorTable::isValid() const {
+    const uint8_t *cells = &(*table)[0][0][0];
+    for (unsigned int i = 0; i < NUM_CELLS; i++) {
+      if (cells[i] >= NUM_COLORS) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * \brief   Sets every cell to UNDEFINED
+   */
+  void ColorTable::clear() {
+    memset(table, UNDEFINED, NUM_CELLS);
+  }
+
+  /**
+   * \brief   Re-indexes the table by another color space
+   */
+  void ColorTable::convert(ColorSpace space) {
+
+    if (space == colorSpace)
+      return;
+
+    ColorTable converted;
+    converted.colorSpace = space;
+    const unsigned int center = Resolution::CELL_WIDTH / 2;
+    for (unsigned int i = 0; i < Resolution::SIZE; i++) {
+      for (unsigned int j = 0; j < Resolution::SIZE; j++) {
+        for (unsigned int k = 0; k < Resolution::SIZE; k++) {
+          uint8_t a = Resolution::toValue(i) + center;
+          uint8_t b = Resolution::toValue(j) + center;
+          uint8_t c = Resolution::toValue(k) + center;
+          if (space == COLOR_SPACE_YUV) {
+            Yuv yuv = {a, b, c};
+            Rgb rgb = yuvToRgb(yuv);
+            converted.cell(i, j, k) = classify(rgb.r, rgb.g, rgb.b);
+          } else {
+            Rgb rgb = {a, b, c};
+            Yuv yuv = rgbToYuv(rgb);
+            converted.cell(i, j, k) = classify(yuv.y, yuv.u, yuv.v);
+          }
+        }
+      }
+    }
+
+    storage = converted.storage;
+    table = converted.table;
+    colorSpace = space;
+  }
+
+  /**
+   * \brief   Segments an image message
+   */
+  bool ColorTable::segmentImage(const sensor_msgs::Image &image, std::vector<uint8_t> &labels) const {
+
+    namespace enc = sensor_msgs::image_encodings;
+
+    if (colorSpace == COLOR_SPACE_YUV) {
+      Yuv422Layout yuvLayout;
+      if (image.encoding == enc::YUV422) {
+        yuvLayout = UYVY_LAYOUT;
+      } else if (image.encoding == "yuyv") {
+        yuvLayout = YUYV_LAYOUT;
+      } else {
+        return false;
+      }
+      labels.resize(image.width * image.height);
+      if (labels.empty())
+        return true;
+      if (!hasRows(image.data, image.height, image.step, (size_t)(image.width + 1) / 2 * 4))
+        return false;
+      segmentYuv422(&image.data[0], image.width, image.height, image.step, yuvLayout, &labels[0], image.width);
+      return true;
+    }
+
+    PixelLayout layout;
+    if (image.encoding == enc::RGB8) {
+      layout = RGB8_LAYOUT;
+    } else if (image.encoding == enc::BGR8) {
+      layout = BGR8_LAYOUT;
+    } else if (image.encoding == enc::RGBA8) {
+      layout = RGBA8_LAYOUT;
+    } else if (image.encoding == enc::BGRA8) {
+      layout = BGRA8_LAYOUT;
+    } else {
+      return false;
+    }
+
+    labels.resize(image.width * image.height);
+    if (labels.empty())
+      return true;
+    if (!hasRows(image.data, image.height, image.step, (size_t) image.width * layout.pixelStride))
+      return false;
+    segment(&image.data[0], image.width, image.height, image.step, layout, &labels[0], image.width);
+    return true;
+  }
+
+  /**
+   * \brief   Segments a point cloud message straight from its data buffer
+   */
+  bool ColorTable::segmentPointCloud(const sensor_msgs::PointCloud2 &cloud, std::vector<uint8_t> &labels) const {
+
+    int rgbOffset = -1;
+    for (unsigned int i = 0; i < cloud.fields.size(); i++) {
+      const sensor_msgs::PointField &field = cloud.fields[i];
+      if ((field.name == "rgb" || field.name == "rgba") &&
+          (field.datatype == sensor_msgs::PointField::FLOAT32 || field.datatype == sensor_msgs::PointField::UINT32)) {
+        rgbOffset = field.offset;
+        break;
+      }
+    }
+    if (rgbOffset < 0 || cloud.is_bigendian || colorSpace != COLOR_SPACE_RGB)
+      return false;
+
+    // The rgb field is 4 bytes, and has to fit in every point
+    if (rgbOffset + 4 > (int) cloud.point_step)
+      return false;
+
+    labels.resize(cloud.width * cloud.height);
+    if (labels.empty())
+      return true;
+    if (!hasRows(cloud.data, cloud.height, cloud.row_step, (size_t) cloud.width * cloud.point_step))
+      return false;
+    segment(&cloud.data[0], cloud.width, cloud.height, cloud.row_step,
+        getPackedRgbLayout(cloud.point_step, rgbOffset), &labels[0], cloud.width);
+    return true;
+  }
+
+  /**
+   * \brief   Computes per color statistics over the table cells
+   */
+  void ColorTable::getStatistics(std::vector<ColorStatistics> &stats) const {
+
+    std::vector<double> sumR(NUM_COLORS, 0), sumG(NUM_COLORS, 0), sumB(NUM_COLORS, 0);
+    ColorStatistics empty;
+    memset(&empty, 0, sizeof(empty));
+    empty.minRgb.r = empty.minRgb.g = empty.minRgb.b = 255;
+    stats.assign(NUM_COLORS, empty);
+
+    const unsigned int top = Resolution::CELL_WIDTH - 1;
+    for (unsigned int r = 0; r < Resolution::SIZE; r++) {
+      for (unsigned int g = 0; g < Resolution::SIZE; g++) {
+        for (unsigned int b = 0; b < Resolution::SIZE; b++) {
+          uint8_t color = (*table)[r][g][b];
+          if (color >= NUM_COLORS)
+            continue;
+          ColorStatistics &stat = stats[color];
+          Rgb low = {Resolution::toValue(r), Resolution::toValue(g), Resolution::toValue(b)};
+          stat.numCells++;
+          stat.minRgb.r = std::min(stat.minRgb.r, low.r);
+          stat.minRgb.g = std::min(stat.minRgb.g, low.g);
+          stat.minRgb.b = std::min(stat.minRgb.b, low.b);
+          stat.maxRgb.r = std::max(stat.maxRgb.r, (uint8_t)(low.r + top));
+          stat.maxRgb.g = std::max(stat.maxRgb.g, (uint8_t)(low.g + top));
+          stat.maxRgb.b = std::max(stat.maxRgb.b, (uint8_t)(low.b + top));
+          sumR[color] += low.r + top / 2.0;
+          sumG[color] += low.g + top / 2.0;
+          sumB[color] += low.b + top / 2.0;
+        }
+      }
+    }
+
+    for (unsigned int i = 0; i < NUM_COLORS; i++) {
+      if (stats[i].numCells == 0) {
+        stats[i].minRgb = stats[i].maxRgb;
+        continue;
+      }
+      stats[i].meanR = sumR[i] / stats[i].numCells;
+      stats[i].meanG = sumG[i] / stats[i].numCells;
+      stats[i].meanB = sumB[i] / stats[i].numCells;
+    }
+  }
+
+  /**
+   * \brief   Counts the number of occurences of each color in a label buffer
+   */
+  void ColorTable::countLabels(const uint8_t *labels, size_t numLabels, std::vector<unsigned int> &counts) {
+    counts.assign(NUM_COLORS, 0);
+    for (size_t i = 0; i < numLabels; i++) {
+      if (labels[i] < NUM_COLORS) {
+        counts[labels[i]]++;
+      }
+    }
+  }
+
+}
@@ -0,0 +1,143 @@
+/**
+ * \file  edit_history.cpp
+ * \brief Definitions for the EditHistory class
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 08/23/2011 03:12:40 PM piyushk $
+ */
+
+#include <color_table/edit_history.h>
+
+namespace color_table {
+
+  namespace {
+    /**
+     * \brief  Converts a block index and cell index inside it to cell coordinates
+     */
+    inline void getCellCoordinates(unsigned int block, unsigned int cell,
+        unsigned int &r, unsigned int &g, unsigned int &b) {
+      const unsigned int bits = BlockColorTable::BLOCK_BITS;
+      const unsigned int mask = BlockColorTable::BLOCK_SIZE - 1;
+      const unsigned int perAxis = BlockColorTable::BLOCKS_PER_AXIS;
+      r = ((block / (perAxis * perAxis)) << bits) | (cell >> (2 * bits));
+      g = (((block / perAxis) % perAxis) << bits) | ((cell >> bits) & mask);
+      b = ((block % perAxis) << bits) | (cell & mask);
+    }
+  }
+
+  EditHistory::EditHistory(size_t memoryBudget) :
+      memoryBudget(memoryBudget), memoryUsage(0) {}
+
+  /**
+   * \brief   Records the edits in a preview
+   */
+  bool EditHistory::record(const ColorTablePreview &preview) {
+
+    Edit edit;
+    const std::vector<unsigned int> &blocks = preview.getTouchedBlocks();
+    for (unsigned int i = 0; i < blocks.size(); i++) {
+      const uint8_t *oldCells = preview.getBase().getBlock(blocks[i]).get();
+      const uint8_t *newCells = preview.getBlock(blocks[i]).get();
+      for (unsigned int cell = 0; cell < BlockColorTable::BLOCK_CELLS; ) {
+        if (oldCells[cell] == newCells[cell]) {
+          cell++;
+          continue;
+        }
+        CellRun run;
+        run.block = blocks[i];
+        run.firstCell = cell;
+        run.labelOffset = edit.oldLabels.size();
+        while (cell < BlockColorTable::BLOCK_CELLS && oldCells[cell] != newCells[cell]) {
+          edit.oldLabels.push_back(oldCells[cell]);
+          edit.newLabels.push_back(newCells[cell]);
+          cell++;
+        }
+        run.numCells = cell - run.firstCell;
+        edit.runs.push_back(run);
+      }
+    }
+
+    if (edit.runs.empty())
+      return false;
+
+    for (unsigned int i = 0; i < redoEdits.size(); i++) {
+      memoryUsage -= redoEdits[i].getMemoryUsage();
+    }
+    redoEdits.clear();
+
+    undoEdits.push_back(Edit());
+    undoEdits.back().runs.swap(edit.runs);
+    undoEdits.back().oldLabels.swap(edit.oldLabels);
+    undoEdits.back().newLabels.swap(edit.newLabels);
+    memoryUsage += undoEdits.back().getMemoryUsage();
+    enforceBudget();
+    return true;
+  }
+
+  /**
+   * \brief   Writes the cells changed by the last edit back to their old labels
+   */
+  bool EditHistory::undo(ColorTablePreview &preview) {
+    if (undoEdits.empty())
+      return false;
+    apply(undoEdits.back(), false, preview);
+    redoEdits.push_back(Edit());
+    redoEdits.back().runs.swap(undoEdits.back().runs);
+    redoEdits.back().oldLabels.swap(undoEdits.back().oldLabels);
+    redoEdits.back().newLabels.swap(undoEdits.back().newLabels);
+    undoEdits.pop_back();
+    return true;
+  }
+
+  /**
+   * \brief   Writes the cells of the last undone edit to their new labels
+   */
+  bool EditHistory::redo(ColorTablePreview &preview) {
+    if (redoEdits.empty())
+      return false;
+    apply(redoEdits.back(), true, preview);
+    undoEdits.push_back(Edit());
+    undoEdits.back().runs.swap(redoEdits.back().runs);
+    undoEdits.back().oldLabels.swap(redoEdits.back().oldLabels);
+    undoEdits.back().newLabels.swap(redoEdits.back().newLabels);
+    redoEdits.pop_back();
+    return true;
+  }
+
+  /**
+   * \brief   Forgets all edits
+   */
+  void EditHistory::clear() {
+    undoEdits.clear();
+    redoEdits.clear();
+    memoryUsage = 0;
+  }
+
+  void EditHistory::apply(const Edit &edit, bool useNewLabels, ColorTablePreview &preview) {
+    const std::vector<uint8_t> &labels = useNewLabels ? edit.newLabels : edit.oldLabels;
+    for (unsigned int i = 0; i < edit.runs.size(); i++) {
+      const CellRun &run = edit.runs[i];
+      for (unsigned int j = 0; j < run.numCells; j++) {
+        unsigned int r, g, b;
+        getCellCoordinates(run.block, run.firstCell + j, r, g, b);
+        preview.set(r, g, b, labels[run.labelOffset + j]);
+      }
+    }
+  }
+
+  /**
+   * \brief   Drops the oldest edits until the journal fits in its budget. The
+   *          most recent edit is always kept.
+   */
+  void EditHistory::enforceBudget() {
+    while (memoryUsage > memoryBudget && undoEdits.size() > 1) {
+      memoryUsage -= undoEdits.front().getMemoryUsage();
+      undoEdits.pop_front();
+    }
+  }
+
+}
@@ -0,0 +1,82 @@
+/**
+ * \file  frame_bin_index.cpp
+ * \brief Definitions for the FrameBinIndex class
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 08/22/2011 10:51:03 AM piyushk $
+ */
+
+#include <color_table/frame_bin_index.h>
+
+namespace color_table {
+
+  /**
+   * \brief   Builds the index for a new frame
+   */
+  void FrameBinIndex::build(const Rgb *rgb, size_t numPixels) {
+
+    const unsigned int cellBits = 3 * BlockColorTable::BLOCK_BITS;
+    const unsigned int numCells = BlockColorTable::BLOCK_CELLS;
+    const unsigned int numBlocks = BlockColorTable::NUM_BLOCKS;
+
+    // Key of a pixel, which orders pixels by block and then by cell
+    keys.resize(numPixels);
+    for (size_t i = 0; i < numPixels; i++) {
+      unsigned int r = Resolution::toCell(rgb[i].r);
+      unsigned int g = Resolution::toCell(rgb[i].g);
+      unsigned int b = Resolution::toCell(rgb[i].b);
+      keys[i] = BlockColorTable::getCellKey(r, g, b);
+    }
+
+    // Two pass radix sort of the pixel indices, by cell and then (stably) by block
+    std::vector<unsigned int> cellCounts(numCells + 1, 0);
+    for (size_t i = 0; i < numPixels; i++) {
+      cellCounts[(keys[i] & (numCells - 1)) + 1]++;
+    }
+    for (unsigned int i = 0; i < numCells; i++) {
+      cellCounts[i + 1] += cellCounts[i];
+    }
+    scratch.resize(numPixels);
+    for (size_t i = 0; i < numPixels; i++) {
+      scratch[cellCounts[keys[i] & (numCells - 1)]++] = i;
+    }
+
+    blockStarts.assign(numBlocks + 1, 0);
+    std::vector<unsigned int> blockCounts(numBlocks + 1, 0);
+    for (size_t i = 0; i < numPixels; i++) {
+      blockCounts[(keys[i] >> cellBits) + 1]++;
+    }
+    for (unsigned int i = 0; i < numBlocks; i++) {
+      blockCounts[i + 1] += blockCounts[i];
+    }
+    pixels.resize(numPixels);
+    for (size_t i = 0; i < numPixels; i++) {
+      unsigned int pixel = scratch[i];
+      pixels[blockCounts[keys[pixel] >> cellBits]++] = pixel;
+    }
+
+    // Split the sorted pixels into bins
+    binStarts.clear();
+    binCells.clear();
+    unsigned int previousKey = ~0u;
+    for (size_t i = 0; i < numPixels; i++) {
+      unsigned int key = keys[pixels[i]];
+      if (key != previousKey) {
+        unsigned int block = key >> cellBits;
+        blockStarts[block + 1]++;
+        binStarts.push_back(i);
+        binCells.push_back(key & (numCells - 1));
+        previousKey = key;
+      }
+    }
+    binStarts.push_back(numPixels);
+    for (unsigned int i = 0; i < numBlocks; i++) {
+      blockStarts[i + 1] += blockStarts[i];
+    }
+  }
+
+}
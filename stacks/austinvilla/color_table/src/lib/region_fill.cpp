@@ -0,0 +1,110 @@
+/**
+ * \file  region_fill.cpp
+ * \brief Definitions for the RegionFill class
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 09/06/2011 02:58:12 PM piyushk $
+ */
+
+#include <algorithm>
+#include <cstdlib>
+
+#include <color_table/block_color_table.h>
+#include <color_table/region_fill.h>
+
+namespace color_table {
+
+  namespace {
+    inline unsigned int getDifference(const Rgb &a, const Rgb &b) {
+      return std::max(std::max(abs(a.r - b.r), abs(a.g - b.g)), abs(a.b - b.b));
+    }
+  }
+
+  /**
+   * \brief   Selects the region around pixel (x, y)
+   */
+  size_t RegionFill::fill(const Rgb *pixels, const uint8_t *labels, unsigned int width, unsigned int height,
+      unsigned int x, unsigned int y, Criterion criterion, unsigned int tolerance) {
+
+    region.clear();
+    stack.clear();
+    if (x >= width || y >= height)
+      return 0;
+
+    visited.assign((size_t) width * height, 0);
+    const uint32_t seed = y * width + x;
+    const Rgb seedColor = pixels[seed];
+    const uint8_t seedLabel = labels ? labels[seed] : (uint8_t) UNDEFINED;
+    const unsigned int seedTolerance = 2 * tolerance;
+
+    visited[seed] = 1;
+    stack.push_back(seed);
+    while (!stack.empty()) {
+      uint32_t pixel = stack.back();
+      stack.pop_back();
+      region.push_back(pixel);
+
+      unsigned int px = pixel % width;
+      unsigned int py = pixel / width;
+      uint32_t neighbors[4];
+      unsigned int numNeighbors = 0;
+      if (px > 0) neighbors[numNeighbors++] = pixel - 1;
+      if (px + 1 < width) neighbors[numNeighbors++] = pixel + 1;
+      if (py > 0) neighbors[numNeighbors++] = pixel - width;
+      if (py + 1 < height) neighbors[numNeighbors++] = pixel + width;
+
+      for (unsigned int i = 0; i < numNeighbors; i++) {
+        uint32_t neighbor = neighbors[i];
+        if (visited[neighbor])
+          continue;
+        bool joins;
+        if (criterion == SAME_LABEL) {
+          joins = (labels[neighbor] == seedLabel);
+        } else {
+          // A pixel rejected here may still be reached from a closer neighbor,
+          // so it is only marked once it joins
+          joins = getDifference(pixels[neighbor], pixels[pixel]) <= tolerance &&
+                  getDifference(pixels[neighbor], seedColor) <= seedTolerance;
+        }
+        if (joins) {
+          visited[neighbor] = 1;
+          stack.push_back(neighbor);
+        }
+      }
+    }
+
+    return region.size();
+  }
+
+  /**
+   * \brief   Histogram of the table cells of the last region
+   */
+  void RegionFill::getCells(const Rgb *pixels, unsigned int minCount, std::vector<uint32_t> &cellKeys) {
+
+    cellKeys.clear();
+    keys.resize(region.size());
+    for (size_t i = 0; i < region.size(); i++) {
+      const Rgb &pixel = pixels[region[i]];
+      keys[i] = BlockColorTable::getCellKey(Resolution::toCell(pixel.r),
+          Resolution::toCell(pixel.g), Resolution::toCell(pixel.b));
+    }
+    std::sort(keys.begin(), keys.end());
+
+    size_t first = 0;
+    while (first < keys.size()) {
+      size_t last = first + 1;
+      while (last < keys.size() && keys[last] == keys[first]) {
+        last++;
+      }
+      if (last - first >= minCount) {
+        cellKeys.push_back(keys[first]);
+      }
+      first = last;
+    }
+  }
+
+}
@@ -0,0 +1,243 @@
+/**
+ * \file  rgb_frame.cpp
+ * \brief Definitions for the RgbFrame class, and the conversion kernels for
+ * each supported encoding
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 08/31/2011 10:31:09 AM piyushk $
+ */
+
+#include <algorithm>
+#include <boost/static_assert.hpp>
+#include <sensor_msgs/image_encodings.h>
+
+#include <color_table/color_space.h>
+#include <color_table/rgb_frame.h>
+
+namespace color_table {
+
+  // Packed rgb8 data is reinterpreted as an array of Rgb
+  BOOST_STATIC_ASSERT(sizeof(Rgb) == 3);
+
+  namespace {
+
+    inline void setError(std::string *error, const std::string &message) {
+      if (error) {
+        *error = message;
+      }
+    }
+
+    /**
+     * Kernels convert one row of an image. They get the whole image, so that
+     * bayer kernels can read the neighboring row.
+     */
+    template <unsigned int STRIDE, unsigned int R, unsigned int G, unsigned int B>
+    struct PackedKernel {
+      static inline void convertRow(const uint8_t *image, size_t step, unsigned int y, unsigned int width, Rgb *dst) {
+        const uint8_t *src = image + y * step;
+        for (unsigned int x = 0; x < width; x++, src += STRIDE) {
+          dst[x].r = src[R];
+          dst[x].g = src[G];
+          dst[x].b = src[B];
+        }
+      }
+    };
+
+    struct Mono8Kernel {
+      static inline void convertRow(const uint8_t *image, size_t step, unsigned int y, unsigned int width, Rgb *dst) {
+        const uint8_t *src = image + y * step;
+        for (unsigned int x = 0; x < width; x++) {
+          dst[x].r = dst[x].g = dst[x].b = src[x];
+        }
+      }
+    };
+
+    template <unsigned int Y0, unsigned int Y1, unsigned int U, unsigned int V>
+    struct Yuv422Kernel {
+      static inline void convertRow(const uint8_t *image, size_t step, unsigned int y, unsigned int width, Rgb *dst) {
+        const uint8_t *src = image + y * step;
+        for (unsigned int x = 0; x < width; x += 2, src += 4) {
+          Yuv yuv = {src[Y0], src[U], src[V]};
+          dst[x] = yuvToRgb(yuv);
+          if (x + 1 < width) {
+            yuv.y = src[Y1];
+            dst[x + 1] = yuvToRgb(yuv);
+          }
+        }
+      }
+    };
+
+    /**
+     * Demosaics at half resolution: every 2x2 cell of the mosaic gives one
+     * color (with the 2 greens averaged), shared by its 4 pixels. The
+     * position of the red and blue samples inside the cell is given by
+     * (RX, RY) and (BX, BY); the greens are on the other diagonal.
+     */
+    template <unsigned int RX, unsigned int RY, unsigned int BX, unsigned int BY>
+    struct BayerKernel {
+      static inline void convertRow(const uint8_t *image, size_t step, unsigned int y, unsigned int width, Rgb *dst) {
+        const uint8_t *rows[2];
+        rows[0] = image + (y & ~1u) * step;
+        rows[1] = rows[0] + step;
+        for (unsigned int x = 0; x < width; x += 2) {
+          Rgb rgb;
+          rgb.r = rows[RY][x + RX];
+          rgb.g = (rows[RY][x + 1 - RX] + rows[1 - RY][x + RX] + 1) >> 1;
+          rgb.b = rows[BY][x + BX];
+          dst[x] = dst[x + 1] = rgb;
+        }
+      }
+    };
+
+    /**
+     * Converts a whole image. When WIDTH and HEIGHT are not 0, they replace
+     * the runtime size, so that the compiler can unroll and vectorize the
+     * loops for that size.
+     */
+    template <typename Kernel, unsigned int WIDTH, unsigned int HEIGHT>
+    void convertImage(const uint8_t *image, size_t step, unsigned int width, unsigned int height, Rgb *dst) {
+      if (WIDTH != 0) {
+        width = WIDTH;
+        height = HEIGHT;
+      }
+      for (unsigned int y = 0; y < height; y++) {
+        Kernel::convertRow(image, step, y, width, dst + (size_t)y * width);
+      }
+    }
+
+    template <typename Kernel>
+    void convert(const uint8_t *image, size_t step, unsigned int width, unsigned int height, Rgb *dst) {
+      if (width == 640 && height == 480) {
+        convertImage<Kernel, 640, 480>(image, step, width, height, dst);
+      } else if (width == 320 && height == 240) {
+        convertImage<Kernel, 320, 240>(image, step, width, height, dst);
+      } else if (width == 1280 && height == 1024) {
+        convertImage<Kernel, 1280, 1024>(image, step, width, height, dst);
+      } else {
+        convertImage<Kernel, 0, 0>(image, step, width, height, dst);
+      }
+    }
+
+    typedef void (*ConvertFunction)(const uint8_t *image, size_t step, unsigned int width, unsigned int height, Rgb *dst);
+
+    /**
+     * \struct Encoding
+     * \brief  How to read and convert an image encoding
+     */
+    struct Encoding {
+      ConvertFunction convert;
+      unsigned int groupWidth;      ///< Number of pixels that share a group of bytes (2 for yuv 4:2:2)
+      unsigned int groupBytes;      ///< Number of bytes in such a group
+      bool evenSize;                ///< Whether the width and height have to be even
+    };
+
+    const Encoding RGB8_ENCODING = {&convert<PackedKernel<3, 0, 1, 2> >, 1, 3, false};
+    const Encoding BGR8_ENCODING = {&convert<PackedKernel<3, 2, 1, 0> >, 1, 3, false};
+    const Encoding RGBA8_ENCODING = {&convert<PackedKernel<4, 0, 1, 2> >, 1, 4, false};
+    const Encoding BGRA8_ENCODING = {&convert<PackedKernel<4, 2, 1, 0> >, 1, 4, false};
+    const Encoding MONO8_ENCODING = {&convert<Mono8Kernel>, 1, 1, false};
+    const Encoding UYVY_ENCODING = {&convert<Yuv422Kernel<1, 3, 0, 2> >, 2, 4, false};
+    const Encoding YUYV_ENCODING = {&convert<Yuv422Kernel<0, 2, 1, 3> >, 2, 4, false};
+    const Encoding BAYER_RGGB8_ENCODING = {&convert<BayerKernel<0, 0, 1, 1> >, 1, 1, true};
+    const Encoding BAYER_BGGR8_ENCODING = {&convert<BayerKernel<1, 1, 0, 0> >, 1, 1, true};
+    const Encoding BAYER_GBRG8_ENCODING = {&convert<BayerKernel<0, 1, 1, 0> >, 1, 1, true};
+    const Encoding BAYER_GRBG8_ENCODING = {&convert<BayerKernel<1, 0, 0, 1> >, 1, 1, true};
+
+    const Encoding* findEncoding(const std::string &encoding) {
+      namespace enc = sensor_msgs::image_encodings;
+      if (encoding == enc::RGB8) return &RGB8_ENCODING;
+      if (encoding == enc::BGR8) return &BGR8_ENCODING;
+      if (encoding == enc::RGBA8) return &RGBA8_ENCODING;
+      if (encoding == enc::BGRA8) return &BGRA8_ENCODING;
+      if (encoding == enc::MONO8) return &MONO8_ENCODING;
+      if (encoding == enc::YUV422) return &UYVY_ENCODING;
+      if (encoding == "yuyv") return &YUYV_ENCODING;
+      if (encoding == enc::BAYER_RGGB8) return &BAYER_RGGB8_ENCODING;
+      if (encoding == enc::BAYER_BGGR8) return &BAYER_BGGR8_ENCODING;
+      if (encoding == enc::BAYER_GBRG8) return &BAYER_GBRG8_ENCODING;
+      if (encoding == enc::BAYER_GRBG8) return &BAYER_GRBG8_ENCODING;
+      return NULL;
+    }
+  }
+
+  RgbFrame::RgbFrame() : pixels(NULL), width(0), height(0) {}
+
+  /**
+   * \brief   Makes this frame show an image message
+   */
+  bool RgbFrame::assign(const sensor_msgs::ImageConstPtr &newImage, std::string *error) {
+
+    clear();
+    if (!newImage) {
+      setError(error, "No image");
+      return false;
+    }
+
+    const sensor_msgs::Image &msg = *newImage;
+    const Encoding *encoding = findEncoding(msg.encoding);
+    if (!encoding) {
+      setError(error, "Unsupported image encoding: " + msg.encoding);
+      return false;
+    }
+    if (encoding->evenSize && (msg.width % 2 != 0 || msg.height % 2 != 0)) {
+      setError(error, msg.encoding + " images need an even width and height");
+      return false;
+    }
+
+    // Make sure every row lies within the buffer before reading anything
+    size_t rowBytes = (size_t)(msg.width + encoding->groupWidth - 1) / encoding->groupWidth * encoding->groupBytes;
+    if (msg.width != 0 && msg.height != 0 &&
+        (msg.step < rowBytes || msg.data.size() < (size_t)(msg.height - 1) * msg.step + rowBytes)) {
+      setError(error, "Image data is smaller than its size and step require");
+      return false;
+    }
+
+    image = newImage;
+    width = msg.width;
+    height = msg.height;
+    if (empty())
+      return true;
+
+    if (encoding == &RGB8_ENCODING && msg.step == rowBytes) {
+      pixels = reinterpret_cast<const Rgb*>(&msg.data[0]);
+    } else {
+      buffer.resize(getNumPixels());
+      encoding->convert(&msg.data[0], msg.step, width, height, &buffer[0]);
+      pixels = &buffer[0];
+    }
+    return true;
+  }
+
+  /**
+   * \brief   Empties the frame, releasing the message
+   */
+  void RgbFrame::clear() {
+    image.reset();
+    pixels = NULL;
+    width = height = 0;
+  }
+
+  /**
+   * \brief   Exchanges the contents of 2 frames
+   */
+  void RgbFrame::swap(RgbFrame &other) {
+    // Swapping the vectors keeps their data where it is, so pixels stays valid
+    image.swap(other.image);
+    buffer.swap(other.buffer);
+    std::swap(pixels, other.pixels);
+    std::swap(width, other.width);
+    std::swap(height, other.height);
+  }
+
+  /**
+   * \brief   Whether assign() can handle a given encoding
+   */
+  bool RgbFrame::isSupportedEncoding(const std::string &encoding) {
+    return findEncoding(encoding) != NULL;
+  }
+
+}
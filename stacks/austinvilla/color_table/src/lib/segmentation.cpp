@@ -0,0 +1,148 @@
+/**
+ * \file  segmentation.cpp
+ * \brief Runtime cpu detection and dispatch for the segmentation kernel
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 08/16/2011 10:55:41 AM piyushk $
+ */
+
+#include "segmentation_impl.h"
+
+#ifdef COLOR_TABLE_SIMD
+#include <cpuid.h>
+#endif
+
+namespace color_table {
+
+  namespace {
+
+    /**
+     * \brief  Best instruction set supported by both the cpu and the os
+     */
+    SimdLevel detectSimdLevel() {
+#ifdef COLOR_TABLE_SIMD
+      unsigned int eax, ebx, ecx, edx;
+      if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return SIMD_NONE;
+      }
+      bool sse2 = edx & bit_SSE2;
+      bool ssse3 = ecx & bit_SSSE3;
+      bool osxsave = ecx & bit_OSXSAVE;
+      bool avx = ecx & bit_AVX;
+
+      // AVX2 requires the os to save the ymm registers on a context switch
+      bool avx2 = false;
+      if (avx && osxsave && __get_cpuid_max(0, NULL) >= 7) {
+        unsigned int xcr0Low, xcr0High;
+        __asm__ ("xgetbv" : "=a" (xcr0Low), "=d" (xcr0High) : "c" (0));
+        if ((xcr0Low & 0x6) == 0x6) {
+          __cpuid_count(7, 0, eax, ebx, ecx, edx);
+          avx2 = ebx & (1 << 5);
+        }
+      }
+
+      if (avx2) return SIMD_AVX2;
+      if (ssse3) return SIMD_SSSE3;
+      if (sse2) return SIMD_SSE2;
+#endif
+      return SIMD_NONE;
+    }
+
+    SimdLevel supportedLevel = detectSimdLevel();
+    SimdLevel currentLevel = supportedLevel;
+  }
+
+  /**
+   * \brief   Returns the instruction set used by segmentPixels()
+   */
+  SimdLevel getSimdLevel() {
+    return currentLevel;
+  }
+
+  /**
+   * \brief   Restricts the kernel to a given instruction set
+   */
+  void setSimdLevel(SimdLevel level) {
+    currentLevel = std::min(level, supportedLevel);
+  }
+
+  /**
+   * \brief   Human readable name of a SimdLevel
+   */
+  const char* getSimdLevelName(SimdLevel level) {
+    switch (level) {
+      case SIMD_SSE2:
+        return "SSE2";
+      case SIMD_SSSE3:
+        return "SSSE3";
+      case SIMD_AVX2:
+        return "AVX2";
+      default:
+        return "scalar";
+    }
+  }
+
+  /**
+   * \brief   Segments a buffer of pixels using the specified color table
+   */
+  void segmentPixels(const ColorTableArray &table, const uint8_t *src,
+      unsigned int width, unsigned int height, size_t srcStep,
+      const PixelLayout &layout, uint8_t *labels, size_t labelStep) {
+
+    const uint8_t *flatTable = &table[0][0][0];
+
+    // Pick the row kernel once for the whole buffer
+    void (*segmentRow)(const uint8_t*, const uint8_t*, unsigned int, const PixelLayout&, uint8_t*) = NULL;
+#ifdef COLOR_TABLE_SIMD
+    switch (currentLevel) {
+      case SIMD_AVX2:
+        segmentRow = &detail::segmentRowAvx2;
+        break;
+      case SIMD_SSSE3:
+        segmentRow = &detail::segmentRowSsse3;
+        break;
+      case SIMD_SSE2:
+        segmentRow = &detail::segmentRowSse2;
+        break;
+      default:;
+    }
+#endif
+
+    for (unsigned int y = 0; y < height; y++) {
+      const uint8_t *srcRow = src + y * srcStep;
+      uint8_t *labelRow = labels + y * labelStep;
+      if (segmentRow) {
+        segmentRow(flatTable, srcRow, width, layout, labelRow);
+      } else {
+        detail::segmentRowScalar(flatTable, srcRow, 0, width, layout, labelRow);
+      }
+    }
+  }
+
+  /**
+   * \brief   Segments a YUV 4:2:2 buffer using a YUV indexed color table
+   */
+  void segmentYuv422Pixels(const ColorTableArray &table, const uint8_t *src,
+      unsigned int width, unsigned int height, size_t srcStep,
+      const Yuv422Layout &layout, uint8_t *labels, size_t labelStep) {
+
+    const uint8_t *flatTable = &table[0][0][0];
+    for (unsigned int y = 0; y < height; y++) {
+      const uint8_t *srcRow = src + y * srcStep;
+      uint8_t *labelRow = labels + y * labelStep;
+#ifdef COLOR_TABLE_SIMD
+      // There is no AVX2 version, the SSSE3 kernel is used for both levels
+      if (currentLevel >= SIMD_SSSE3) {
+        detail::segmentRowYuv422Ssse3(flatTable, srcRow, width, layout, labelRow);
+        continue;
+      }
+#endif
+      detail::segmentRowYuv422Scalar(flatTable, srcRow, 0, width, layout, labelRow);
+    }
+  }
+
+}
@@ -0,0 +1,94 @@
+/**
+ * \file  segmentation_avx2.cpp
+ * \brief AVX2 implementation of the segmentation kernel. Compiled with -mavx2.
+ *
+ * Works on 8 pixels at a time. The lookups themselves are plain loads: the
+ * AVX2 gather instruction is microcoded and turns out slower than 8 scalar
+ * loads on every cpu we have tried, especially with the microcode updates
+ * that mitigate gather data sampling.
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 08/16/2011 02:31:56 PM piyushk $
+ */
+
+#include <cstring>
+#include <immintrin.h>
+
+#include "segmentation_impl.h"
+
+namespace color_table {
+namespace detail {
+
+  namespace {
+    inline int loadWord(const uint8_t *src) {
+      int word;
+      memcpy(&word, src, sizeof(word));
+      return word;
+    }
+  }
+
+  void segmentRowAvx2(const uint8_t *table, const uint8_t *src, unsigned int width,
+      const PixelLayout &layout, uint8_t *labels) {
+
+    const unsigned int stride = layout.pixelStride;
+    const unsigned int wordOffset = getWordOffset(layout);
+    const uint8_t *words = src + wordOffset;
+
+    const __m128i rShift = _mm_cvtsi32_si128(getWordShift(layout.rOffset, wordOffset));
+    const __m128i gShift = _mm_cvtsi32_si128(getWordShift(layout.gOffset, wordOffset));
+    const __m128i bShift = _mm_cvtsi32_si128(getWordShift(layout.bOffset, wordOffset));
+    const __m256i mask = _mm256_set1_epi32(Resolution::SIZE - 1);
+    const __m256i spread = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                            0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+
+    const bool packed3 = (stride == 3 && wordOffset == 0);
+    const bool packed4 = (stride == 4 && wordOffset == 0);
+
+    // Leave enough pixels at the end of the row to the scalar loop that none
+    // of the loads below read past the row
+    unsigned int x = 0;
+    uint32_t index[8] __attribute__((aligned(32)));
+    for (; x + 10 < width; x += 8) {
+      __m256i pixels;
+      if (packed3) {
+        const uint8_t *pixel = src + 3 * x;
+        pixels = _mm256_inserti128_si256(_mm256_castsi128_si256(
+              _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixel))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixel + 12)), 1);
+        pixels = _mm256_shuffle_epi8(pixels, spread);
+      } else if (packed4) {
+        pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 4 * x));
+      } else {
+        const uint8_t *pixel = words + x * stride;
+        pixels = _mm256_setr_epi32(loadWord(pixel), loadWord(pixel + stride),
+            loadWord(pixel + 2 * stride), loadWord(pixel + 3 * stride),
+            loadWord(pixel + 4 * stride), loadWord(pixel + 5 * stride),
+            loadWord(pixel + 6 * stride), loadWord(pixel + 7 * stride));
+      }
+
+      __m256i r = _mm256_and_si256(_mm256_srl_epi32(pixels, rShift), mask);
+      __m256i g = _mm256_and_si256(_mm256_srl_epi32(pixels, gShift), mask);
+      __m256i b = _mm256_and_si256(_mm256_srl_epi32(pixels, bShift), mask);
+      __m256i idx = _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(r, 2 * Resolution::BITS_PER_CHANNEL),
+            _mm256_slli_epi32(g, Resolution::BITS_PER_CHANNEL)), b);
+      _mm256_store_si256(reinterpret_cast<__m256i*>(index), idx);
+
+      labels[x + 0] = table[index[0]];
+      labels[x + 1] = table[index[1]];
+      labels[x + 2] = table[index[2]];
+      labels[x + 3] = table[index[3]];
+      labels[x + 4] = table[index[4]];
+      labels[x + 5] = table[index[5]];
+      labels[x + 6] = table[index[6]];
+      labels[x + 7] = table[index[7]];
+    }
+
+    segmentRowScalar(table, src, x, width, layout, labels);
+  }
+
+}
+}
@@ -0,0 +1,95 @@
+/**
+ * \file  segmentation_impl.h
+ * \brief Private declarations for the different implementations of the
+ * segmentation kernel. Each implementation lives in its own translation unit
+ * so that it can be compiled with the matching instruction set flags.
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 08/16/2011 10:40:02 AM piyushk $
+ */
+
+#ifndef SEGMENTATION_IMPL_J8D2LW0C
+#define SEGMENTATION_IMPL_J8D2LW0C
+
+#include <algorithm>
+#include <color_table/segmentation.h>
+
+namespace color_table {
+namespace detail {
+
+  /**
+   * \brief  Index of the cell an rgb value falls in, in the flat table
+   */
+  inline uint32_t getTableIndex(uint8_t r, uint8_t g, uint8_t b) {
+    return Resolution::getIndex(r, g, b);
+  }
+
+  /**
+   * \brief  Offset of the first channel byte inside a pixel. The vectorized
+   *         paths load 4 bytes starting here for every pixel.
+   */
+  inline unsigned int getWordOffset(const PixelLayout &layout) {
+    return std::min(layout.rOffset, std::min(layout.gOffset, layout.bOffset));
+  }
+
+  /**
+   * \brief  Number of bits that a loaded pixel word needs to be shifted right
+   *         by to get the top COLOR_TABLE_BITS bits of the channel at the
+   *         given offset
+   */
+  inline unsigned int getWordShift(unsigned int offset, unsigned int wordOffset) {
+    return 8 * (offset - wordOffset) + Resolution::SHIFT;
+  }
+
+  /**
+   * \brief  Classifies pixels [start, width) of a single row
+   */
+  inline void segmentRowScalar(const uint8_t *table, const uint8_t *src,
+      unsigned int start, unsigned int width, const PixelLayout &layout,
+      uint8_t *labels) {
+    const uint8_t *pixel = src + start * layout.pixelStride;
+    for (unsigned int i = start; i < width; i++, pixel += layout.pixelStride) {
+      labels[i] = table[getTableIndex(pixel[layout.rOffset], pixel[layout.gOffset], pixel[layout.bOffset])];
+    }
+  }
+
+  /**
+   * \brief  Classifies pixels [start, width) of a single YUV 4:2:2 row. start
+   *         has to be even.
+   */
+  inline void segmentRowYuv422Scalar(const uint8_t *table, const uint8_t *src,
+      unsigned int start, unsigned int width, const Yuv422Layout &layout,
+      uint8_t *labels) {
+    const unsigned int bits = Resolution::BITS_PER_CHANNEL;
+    const uint8_t *macropixel = src + 2 * start;
+    for (unsigned int i = start; i < width; i += 2, macropixel += 4) {
+      uint32_t uv = (Resolution::toCell(macropixel[layout.uOffset]) << bits) | Resolution::toCell(macropixel[layout.vOffset]);
+      labels[i] = table[(Resolution::toCell(macropixel[layout.y0Offset]) << (2 * bits)) | uv];
+      if (i + 1 < width) {
+        labels[i + 1] = table[(Resolution::toCell(macropixel[layout.y1Offset]) << (2 * bits)) | uv];
+      }
+    }
+  }
+
+  /* Row kernels for each instruction set. Each one classifies an entire row */
+
+  void segmentRowSse2(const uint8_t *table, const uint8_t *src, unsigned int width,
+      const PixelLayout &layout, uint8_t *labels);
+
+  void segmentRowSsse3(const uint8_t *table, const uint8_t *src, unsigned int width,
+      const PixelLayout &layout, uint8_t *labels);
+
+  void segmentRowAvx2(const uint8_t *table, const uint8_t *src, unsigned int width,
+      const PixelLayout &layout, uint8_t *labels);
+
+  void segmentRowYuv422Ssse3(const uint8_t *table, const uint8_t *src, unsigned int width,
+      const Yuv422Layout &layout, uint8_t *labels);
+
+}
+}
+
+#endif /* end of include guard: SEGMENTATION_IMPL_J8D2LW0C */
@@ -0,0 +1,85 @@
+/**
+ * \file  segmentation_sse.h
+ * \brief Private helpers shared by the SSE implementations of the
+ * segmentation kernel. Only included from translation units compiled with
+ * at least -msse2.
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 08/16/2011 11:12:50 AM piyushk $
+ */
+
+#ifndef SEGMENTATION_SSE_T5NA9E1R
+#define SEGMENTATION_SSE_T5NA9E1R
+
+#include <cstring>
+#include <emmintrin.h>
+
+#include "segmentation_impl.h"
+
+namespace color_table {
+namespace detail {
+
+  /**
+   * \class WordToIndex
+   * \brief Converts 32 bit pixel words (as loaded by the vectorized paths)
+   *        into color table indices, 4 pixels at a time
+   */
+  class WordToIndex {
+    public:
+      WordToIndex(const PixelLayout &layout) {
+        unsigned int wordOffset = getWordOffset(layout);
+        rShift = _mm_cvtsi32_si128(getWordShift(layout.rOffset, wordOffset));
+        gShift = _mm_cvtsi32_si128(getWordShift(layout.gOffset, wordOffset));
+        bShift = _mm_cvtsi32_si128(getWordShift(layout.bOffset, wordOffset));
+        mask = _mm_set1_epi32(Resolution::SIZE - 1);
+      }
+
+      inline __m128i operator()(__m128i words) const {
+        __m128i r = _mm_and_si128(_mm_srl_epi32(words, rShift), mask);
+        __m128i g = _mm_and_si128(_mm_srl_epi32(words, gShift), mask);
+        __m128i b = _mm_and_si128(_mm_srl_epi32(words, bShift), mask);
+        return _mm_or_si128(_mm_or_si128(_mm_slli_epi32(r, 2 * Resolution::BITS_PER_CHANNEL),
+              _mm_slli_epi32(g, Resolution::BITS_PER_CHANNEL)), b);
+      }
+
+    private:
+      __m128i rShift, gShift, bShift, mask;
+  };
+
+  /**
+   * \brief  Looks up 4 table indices and writes the labels
+   */
+  inline void lookup4(const uint8_t *table, __m128i idx, uint8_t *labels) {
+    uint32_t index[4] __attribute__((aligned(16)));
+    _mm_store_si128(reinterpret_cast<__m128i*>(index), idx);
+    labels[0] = table[index[0]];
+    labels[1] = table[index[1]];
+    labels[2] = table[index[2]];
+    labels[3] = table[index[3]];
+  }
+
+  /**
+   * \brief  Unaligned 4 byte load
+   */
+  inline int loadWord(const uint8_t *src) {
+    int word;
+    memcpy(&word, src, sizeof(word));
+    return word;
+  }
+
+  /**
+   * \brief  Loads the pixel words of 4 pixels that are stride bytes apart
+   */
+  inline __m128i loadStridedWords(const uint8_t *src, unsigned int stride) {
+    return _mm_set_epi32(loadWord(src + 3 * stride), loadWord(src + 2 * stride),
+        loadWord(src + stride), loadWord(src));
+  }
+
+}
+}
+
+#endif /* end of include guard: SEGMENTATION_SSE_T5NA9E1R */
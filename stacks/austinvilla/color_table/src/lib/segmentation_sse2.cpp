@@ -0,0 +1,40 @@
+/**
+ * \file  segmentation_sse2.cpp
+ * \brief SSE2 implementation of the segmentation kernel. Compiled with -msse2.
+ *
+ * SSE2 has no gather or byte shuffle, so the pixel words are loaded one at a
+ * time. The table index math for 4 pixels is then done in parallel and the
+ * lookups are issued back to back, which lets the cpu overlap the cache misses.
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 08/16/2011 11:20:18 AM piyushk $
+ */
+
+#include "segmentation_sse.h"
+
+namespace color_table {
+namespace detail {
+
+  void segmentRowSse2(const uint8_t *table, const uint8_t *src, unsigned int width,
+      const PixelLayout &layout, uint8_t *labels) {
+
+    const unsigned int stride = layout.pixelStride;
+    const uint8_t *words = src + getWordOffset(layout);
+    WordToIndex toIndex(layout);
+
+    // Loading 4 bytes per pixel may read past the last channel byte, so always
+    // leave the last pixel of the row to the scalar loop
+    unsigned int x = 0;
+    for (; x + 4 < width; x += 4) {
+      lookup4(table, toIndex(loadStridedWords(words + x * stride, stride)), labels + x);
+    }
+
+    segmentRowScalar(table, src, x, width, layout, labels);
+  }
+
+}
+}
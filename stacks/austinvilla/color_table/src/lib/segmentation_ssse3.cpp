@@ -0,0 +1,81 @@
+/**
+ * \file  segmentation_ssse3.cpp
+ * \brief SSSE3 implementation of the segmentation kernel. Compiled with -mssse3.
+ *
+ * Packed 3 and 4 byte pixels are loaded 16 bytes at a time and spread out into
+ * one 32 bit word per pixel with a single byte shuffle. Other layouts fall
+ * back to the SSE2 path.
+ *
+ * YUV 4:2:2 rows are handled the same way: the shuffle copies the shared u and
+ * v bytes of each macropixel next to the luma byte of both of its pixels.
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 08/16/2011 11:48:07 AM piyushk $
+ */
+
+#include <tmmintrin.h>
+
+#include "segmentation_sse.h"
+
+namespace color_table {
+namespace detail {
+
+  void segmentRowSsse3(const uint8_t *table, const uint8_t *src, unsigned int width,
+      const PixelLayout &layout, uint8_t *labels) {
+
+    const unsigned int stride = layout.pixelStride;
+    WordToIndex toIndex(layout);
+    unsigned int x = 0;
+
+    if (stride == 3 && getWordOffset(layout) == 0) {
+      // A 16 byte load at pixel x touches pixels x .. x+5
+      const __m128i spread = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+      for (; x + 10 < width; x += 8) {
+        const uint8_t *pixel = src + 3 * x;
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixel));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixel + 12));
+        lookup4(table, toIndex(_mm_shuffle_epi8(lo, spread)), labels + x);
+        lookup4(table, toIndex(_mm_shuffle_epi8(hi, spread)), labels + x + 4);
+      }
+    } else if (stride == 4 && getWordOffset(layout) == 0) {
+      for (; x + 8 <= width; x += 8) {
+        const __m128i *pixel = reinterpret_cast<const __m128i*>(src + 4 * x);
+        lookup4(table, toIndex(_mm_loadu_si128(pixel)), labels + x);
+        lookup4(table, toIndex(_mm_loadu_si128(pixel + 1)), labels + x + 4);
+      }
+    } else {
+      segmentRowSse2(table, src, width, layout, labels);
+      return;
+    }
+
+    segmentRowScalar(table, src, x, width, layout, labels);
+  }
+  void segmentRowYuv422Ssse3(const uint8_t *table, const uint8_t *src, unsigned int width,
+      const Yuv422Layout &layout, uint8_t *labels) {
+
+    // Each word holds y, u, v in bytes 0, 1 and 2
+    const PixelLayout wordLayout = {4, 0, 1, 2};
+    WordToIndex toIndex(wordLayout);
+    const __m128i spread = _mm_setr_epi8(
+        layout.y0Offset, layout.uOffset, layout.vOffset, -1,
+        layout.y1Offset, layout.uOffset, layout.vOffset, -1,
+        4 + layout.y0Offset, 4 + layout.uOffset, 4 + layout.vOffset, -1,
+        4 + layout.y1Offset, 4 + layout.uOffset, 4 + layout.vOffset, -1);
+
+    // 16 bytes hold 4 macropixels (8 pixels)
+    unsigned int x = 0;
+    for (; x + 8 <= width; x += 8) {
+      __m128i macropixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * x));
+      lookup4(table, toIndex(_mm_shuffle_epi8(macropixels, spread)), labels + x);
+      lookup4(table, toIndex(_mm_shuffle_epi8(_mm_srli_si128(macropixels, 8), spread)), labels + x + 4);
+    }
+
+    segmentRowYuv422Scalar(table, src, x, width, layout, labels);
+  }
+
+}
+}
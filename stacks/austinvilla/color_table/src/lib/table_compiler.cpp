@@ -0,0 +1,490 @@
+/**
+ * \file  table_compiler.cpp
+ * \brief Definitions for the TrainingSet class and the table compiler
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 09/05/2011 11:02:51 AM piyushk $
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+#include <color_table/block_color_table.h>
+#include <color_table/table_compiler.h>
+
+namespace color_table {
+
+  ColorMoments::ColorMoments() : count(0) {
+    memset(sum, 0, sizeof(sum));
+    memset(sumProducts, 0, sizeof(sumProducts));
+  }
+
+  void ColorMoments::add(const Rgb &rgb, unsigned int weight) {
+    double value[3] = {(double) rgb.r, (double) rgb.g, (double) rgb.b};
+    count += weight;
+    for (unsigned int i = 0; i < 3; i++) {
+      sum[i] += weight * value[i];
+      for (unsigned int j = 0; j < 3; j++) {
+        sumProducts[i][j] += weight * value[i] * value[j];
+      }
+    }
+  }
+
+  TrainingSet::TrainingSet() : numSamples(0) {}
+
+  /**
+   * \brief   Adds a sample
+   */
+  void TrainingSet::add(const Rgb &rgb, uint8_t color, unsigned int weight) {
+
+    uint32_t cell = Resolution::getIndex(rgb.r, rgb.g, rgb.b);
+    std::map<uint32_t, uint32_t>::iterator it = cellPositions.find(cell);
+    if (it == cellPositions.end()) {
+      CellVotes votes;
+      memset(&votes, 0, sizeof(votes));
+      votes.cell = cell;
+      it = cellPositions.insert(std::make_pair(cell, (uint32_t) cells.size())).first;
+      cells.push_back(votes);
+    }
+
+    CellVotes &votes = cells[it->second];
+    votes.votes[color] += weight;
+    votes.total += weight;
+    moments[color].add(rgb, weight);
+    numSamples += weight;
+  }
+
+  /**
+   * \brief   Removes all samples
+   */
+  void TrainingSet::clear() {
+    cells.clear();
+    cellPositions.clear();
+    for (unsigned int i = 0; i < NUM_COLORS; i++) {
+      moments[i] = ColorMoments();
+    }
+    numSamples = 0;
+  }
+
+  CompileOptions::CompileOptions() : method(COMPILE_MAJORITY), radius(1), minVotes(1),
+      k(5), maxSigma(2.5f), numThreads(0) {}
+
+  namespace {
+
+    const unsigned int BLOCK_SIZE = BlockColorTable::BLOCK_SIZE;
+    const unsigned int BLOCKS_PER_AXIS = BlockColorTable::BLOCKS_PER_AXIS;
+    const unsigned int BITS = Resolution::BITS_PER_CHANNEL;
+
+    /** Number of blocks a thread takes at a time */
+    const unsigned int BLOCKS_PER_TASK = 16;
+
+    inline void getCellCoordinates(uint32_t cell, int &r, int &g, int &b) {
+      r = cell >> (2 * BITS);
+      g = (cell >> BITS) & (Resolution::SIZE - 1);
+      b = cell & (Resolution::SIZE - 1);
+    }
+
+    /**
+     * \brief  Color with strictly more votes than any other, or UNDEFINED
+     *         if there is a tie or the winner has fewer than minVotes
+     */
+    template <typename T>
+    uint8_t pickWinner(const T *votes, T minVotes) {
+      uint8_t best = UNDEFINED;
+      T bestVotes = 0;
+      bool tie = false;
+      for (unsigned int color = 0; color < NUM_COLORS; color++) {
+        if (votes[color] > bestVotes) {
+          best = color;
+          bestVotes = votes[color];
+          tie = false;
+        } else if (votes[color] == bestVotes) {
+          tie = true;
+        }
+      }
+      if (tie || bestVotes == 0 || bestVotes < minVotes)
+        return UNDEFINED;
+      return best;
+    }
+
+    /**
+     * \struct Gaussian
+     * \brief  Normal distribution fit to the samples of one color
+     */
+    struct Gaussian {
+      bool valid;
+      double mean[3];
+      double inverse[3][3];         ///< Inverse of the covariance matrix
+
+      Gaussian() : valid(false) {}
+
+      void fit(const ColorMoments &moments) {
+        valid = false;
+        if (moments.count <= 0)
+          return;
+
+        double covariance[3][3];
+        for (unsigned int i = 0; i < 3; i++) {
+          mean[i] = moments.sum[i] / moments.count;
+        }
+        for (unsigned int i = 0; i < 3; i++) {
+          for (unsigned int j = 0; j < 3; j++) {
+            covariance[i][j] = moments.sumProducts[i][j] / moments.count - mean[i] * mean[j];
+          }
+          // Samples taken from a flat patch would otherwise give a singular
+          // matrix. The ridge is about the spread of values inside a cell.
+          covariance[i][i] += 1.0 + Resolution::CELL_WIDTH * Resolution::CELL_WIDTH / 12.0;
+        }
+
+        const double (&c)[3][3] = covariance;
+        double det = c[0][0] * (c[1][1] * c[2][2] - c[1][2] * c[2][1])
+                   - c[0][1] * (c[1][0] * c[2][2] - c[1][2] * c[2][0])
+                   + c[0][2] * (c[1][0] * c[2][1] - c[1][1] * c[2][0]);
+        if (det <= 0)
+          return;
+        inverse[0][0] = (c[1][1] * c[2][2] - c[1][2] * c[2][1]) / det;
+        inverse[0][1] = (c[0][2] * c[2][1] - c[0][1] * c[2][2]) / det;
+        inverse[0][2] = (c[0][1] * c[1][2] - c[0][2] * c[1][1]) / det;
+        inverse[1][0] = (c[1][2] * c[2][0] - c[1][0] * c[2][2]) / det;
+        inverse[1][1] = (c[0][0] * c[2][2] - c[0][2] * c[2][0]) / det;
+        inverse[1][2] = (c[0][2] * c[1][0] - c[0][0] * c[1][2]) / det;
+        inverse[2][0] = (c[1][0] * c[2][1] - c[1][1] * c[2][0]) / det;
+        inverse[2][1] = (c[0][1] * c[2][0] - c[0][0] * c[2][1]) / det;
+        inverse[2][2] = (c[0][0] * c[1][1] - c[0][1] * c[1][0]) / det;
+        valid = true;
+      }
+
+      /**
+       * \brief  Squared Mahalanobis distance of a value from the mean
+       */
+      inline double getDistance2(const double *value) const {
+        double d[3] = {value[0] - mean[0], value[1] - mean[1], value[2] - mean[2]};
+        double result = 0;
+        for (unsigned int i = 0; i < 3; i++) {
+          result += d[i] * (inverse[i][0] * d[0] + inverse[i][1] * d[1] + inverse[i][2] * d[2]);
+        }
+        return result;
+      }
+    };
+
+    /**
+     * \class TableCompiler
+     * \brief State shared by the threads compiling one table
+     */
+    class TableCompiler {
+
+      public:
+
+        TableCompiler(const TrainingSet &samples, const CompileOptions &options, ColorTable &table) :
+            samples(samples), options(options), table(table), nextBlock(0) {
+
+          radius = std::min(options.radius, BLOCK_SIZE);
+
+          // Samples grouped by block, so that a block only looks at the
+          // samples in and around it
+          const std::vector<CellVotes> &cells = samples.getCells();
+          std::vector<unsigned int> blockOfCell(cells.size());
+          blockStarts.assign(BlockColorTable::NUM_BLOCKS + 1, 0);
+          for (unsigned int i = 0; i < cells.size(); i++) {
+            int r, g, b;
+            getCellCoordinates(cells[i].cell, r, g, b);
+            blockOfCell[i] = BlockColorTable::getBlockIndex(r, g, b);
+            blockStarts[blockOfCell[i] + 1]++;
+          }
+          for (unsigned int i = 0; i < BlockColorTable::NUM_BLOCKS; i++) {
+            blockStarts[i + 1] += blockStarts[i];
+          }
+          std::vector<unsigned int> positions(blockStarts.begin(), blockStarts.end() - 1);
+          blockCells.resize(cells.size());
+          for (unsigned int i = 0; i < cells.size(); i++) {
+            blockCells[positions[blockOfCell[i]]++] = i;
+          }
+
+          if (options.method == COMPILE_GAUSSIAN) {
+            for (unsigned int color = 0; color < NUM_COLORS; color++) {
+              if (color != UNDEFINED) {
+                gaussians[color].fit(samples.getMoments(color));
+              }
+            }
+          }
+        }
+
+        /**
+         * \brief  Thread body. Compiles blocks until none are left.
+         */
+        void run() {
+          Scratch scratch;
+          unsigned int first = 0, last = 0;
+          while (takeBlocks(first, last)) {
+            for (unsigned int block = first; block < last; block++) {
+              compileBlock(block, scratch);
+            }
+          }
+        }
+
+      private:
+
+        /**
+         * \struct Scratch
+         * \brief  Buffers reused by one thread from block to block
+         */
+        struct Scratch {
+          std::vector<unsigned int> candidates;               ///< Samples that can vote in the block
+          std::vector<uint32_t> votes;                        ///< Majority: votes of each cell of the block
+          std::vector<std::pair<int, unsigned int> > neighbors;  ///< Nearest neighbors: distance and sample
+        };
+
+        bool takeBlocks(unsigned int &first, unsigned int &last) {
+          boost::mutex::scoped_lock lock(mutex);
+          if (nextBlock >= BlockColorTable::NUM_BLOCKS)
+            return false;
+          first = nextBlock;
+          last = std::min(first + BLOCKS_PER_TASK, (unsigned int) BlockColorTable::NUM_BLOCKS);
+          nextBlock = last;
+          return true;
+        }
+
+        /**
+         * \brief  Collects the samples within reach of a block
+         * \param  euclidean Whether reach is measured as a euclidean
+         *         distance (rather than a cube)
+         */
+        void findCandidates(int r0, int g0, int b0, int reach, bool euclidean, std::vector<unsigned int> &candidates) {
+
+          candidates.clear();
+          const std::vector<CellVotes> &cells = samples.getCells();
+          int blockReach = (reach + BLOCK_SIZE - 1) / BLOCK_SIZE;
+          int br0 = r0 / BLOCK_SIZE, bg0 = g0 / BLOCK_SIZE, bb0 = b0 / BLOCK_SIZE;
+          int last = BLOCK_SIZE - 1;
+
+          for (int br = std::max(br0 - blockReach, 0); br <= std::min(br0 + blockReach, (int) BLOCKS_PER_AXIS - 1); br++) {
+            for (int bg = std::max(bg0 - blockReach, 0); bg <= std::min(bg0 + blockReach, (int) BLOCKS_PER_AXIS - 1); bg++) {
+              for (int bb = std::max(bb0 - blockReach, 0); bb <= std::min(bb0 + blockReach, (int) BLOCKS_PER_AXIS - 1); bb++) {
+                unsigned int block = (br * BLOCKS_PER_AXIS + bg) * BLOCKS_PER_AXIS + bb;
+                for (unsigned int i = blockStarts[block]; i < blockStarts[block + 1]; i++) {
+                  int r, g, b;
+                  getCellCoordinates(cells[blockCells[i]].cell, r, g, b);
+                  // Distance from the sample to the closest cell of the block
+                  int dr = std::max(std::max(r0 - r, r - (r0 + last)), 0);
+                  int dg = std::max(std::max(g0 - g, g - (g0 + last)), 0);
+                  int db = std::max(std::max(b0 - b, b - (b0 + last)), 0);
+                  bool inReach = euclidean ? (dr * dr + dg * dg + db * db <= reach * reach)
+                                           : (std::max(std::max(dr, dg), db) <= reach);
+                  if (inReach) {
+                    candidates.push_back(blockCells[i]);
+                  }
+                }
+              }
+            }
+          }
+        }
+
+        void compileBlock(unsigned int block, Scratch &scratch) {
+
+          int r0 = (block / (BLOCKS_PER_AXIS * BLOCKS_PER_AXIS)) * BLOCK_SIZE;
+          int g0 = ((block / BLOCKS_PER_AXIS) % BLOCKS_PER_AXIS) * BLOCK_SIZE;
+          int b0 = (block % BLOCKS_PER_AXIS) * BLOCK_SIZE;
+
+          switch (options.method) {
+            case COMPILE_MAJORITY:
+              findCandidates(r0, g0, b0, radius, false, scratch.candidates);
+              compileMajority(r0, g0, b0, scratch);
+              break;
+            case COMPILE_NEAREST_NEIGHBORS:
+              findCandidates(r0, g0, b0, radius, true, scratch.candidates);
+              compileNearestNeighbors(r0, g0, b0, scratch);
+              break;
+            case COMPILE_GAUSSIAN:
+              // Only the samples inside a cell can veto it
+              findCandidates(r0, g0, b0, 0, false, scratch.candidates);
+              compileGaussian(r0, g0, b0, scratch);
+              break;
+          }
+        }
+
+        void fillBlock(int r0, int g0, int b0, uint8_t color) {
+          for (int r = r0; r < r0 + (int) BLOCK_SIZE; r++) {
+            for (int g = g0; g < g0 + (int) BLOCK_SIZE; g++) {
+              memset(&table.cell(r, g, b0), color, BLOCK_SIZE);
+            }
+          }
+        }
+
+        /**
+         * \brief  Adds the votes of every sample to all cells of the block
+         *         within the cube around the sample, then picks the winners
+         */
+        void compileMajority(int r0, int g0, int b0, Scratch &scratch) {
+
+          if (scratch.candidates.empty()) {
+            fillBlock(r0, g0, b0, UNDEFINED);
+            return;
+          }
+
+          const std::vector<CellVotes> &cells = samples.getCells();
+          const int last = BLOCK_SIZE - 1;
+          const int R = radius;
+          scratch.votes.assign(BlockColorTable::BLOCK_CELLS * NUM_COLORS, 0);
+          for (unsigned int i = 0; i < scratch.candidates.size(); i++) {
+            const CellVotes &sample = cells[scratch.candidates[i]];
+            int r, g, b;
+            getCellCoordinates(sample.cell, r, g, b);
+            for (int dr = std::max(r - R - r0, 0); dr <= std::min(r + R - r0, last); dr++) {
+              for (int dg = std::max(g - R - g0, 0); dg <= std::min(g + R - g0, last); dg++) {
+                for (int db = std::max(b - R - b0, 0); db <= std::min(b + R - b0, last); db++) {
+                  uint32_t *votes = &scratch.votes[BlockColorTable::getCellIndex(dr, dg, db) * NUM_COLORS];
+                  for (unsigned int color = 0; color < NUM_COLORS; color++) {
+                    votes[color] += sample.votes[color];
+                  }
+                }
+              }
+            }
+          }
+
+          for (int dr = 0; dr <= last; dr++) {
+            for (int dg = 0; dg <= last; dg++) {
+              uint8_t *row = &table.cell(r0 + dr, g0 + dg, b0);
+              for (int db = 0; db <= last; db++) {
+                row[db] = pickWinner(&scratch.votes[BlockColorTable::getCellIndex(dr, dg, db) * NUM_COLORS],
+                    (uint32_t) options.minVotes);
+              }
+            }
+          }
+        }
+
+        /**
+         * \brief  Lets the k samples closest to each cell vote. A sample
+         *         cell holding more votes than are still needed votes in
+         *         proportion.
+         */
+        void compileNearestNeighbors(int r0, int g0, int b0, Scratch &scratch) {
+
+          if (scratch.candidates.empty() || options.k == 0) {
+            fillBlock(r0, g0, b0, UNDEFINED);
+            return;
+          }
+
+          const std::vector<CellVotes> &cells = samples.getCells();
+          const int R2 = radius * radius;
+          for (int r = r0; r < r0 + (int) BLOCK_SIZE; r++) {
+            for (int g = g0; g < g0 + (int) BLOCK_SIZE; g++) {
+              uint8_t *row = &table.cell(r, g, b0);
+              for (int b = b0; b < b0 + (int) BLOCK_SIZE; b++) {
+
+                scratch.neighbors.clear();
+                for (unsigned int i = 0; i < scratch.candidates.size(); i++) {
+                  int sr, sg, sb;
+                  getCellCoordinates(cells[scratch.candidates[i]].cell, sr, sg, sb);
+                  int d2 = (sr - r) * (sr - r) + (sg - g) * (sg - g) + (sb - b) * (sb - b);
+                  if (d2 <= R2) {
+                    scratch.neighbors.push_back(std::make_pair(d2, scratch.candidates[i]));
+                  }
+                }
+                std::sort(scratch.neighbors.begin(), scratch.neighbors.end());
+
+                float votes[NUM_COLORS] = {0};
+                float needed = options.k;
+                for (unsigned int i = 0; i < scratch.neighbors.size() && needed > 0; i++) {
+                  const CellVotes &sample = cells[scratch.neighbors[i].second];
+                  float scale = std::min(1.0f, needed / sample.total);
+                  for (unsigned int color = 0; color < NUM_COLORS; color++) {
+                    votes[color] += scale * sample.votes[color];
+                  }
+                  needed -= scale * sample.total;
+                }
+                row[b - b0] = pickWinner(votes, 0.0f);
+              }
+            }
+          }
+        }
+
+        /**
+         * \brief  Assigns each cell to the color with the closest
+         *         distribution, unless the cell's own samples are mostly
+         *         UNDEFINED
+         */
+        void compileGaussian(int r0, int g0, int b0, Scratch &scratch) {
+
+          const std::vector<CellVotes> &cells = samples.getCells();
+          const double maxDistance2 = options.maxSigma * options.maxSigma;
+          const double center = (Resolution::CELL_WIDTH - 1) * 0.5;
+
+          for (int r = r0; r < r0 + (int) BLOCK_SIZE; r++) {
+            for (int g = g0; g < g0 + (int) BLOCK_SIZE; g++) {
+              uint8_t *row = &table.cell(r, g, b0);
+              for (int b = b0; b < b0 + (int) BLOCK_SIZE; b++) {
+                double value[3] = {Resolution::toValue(r) + center, Resolution::toValue(g) + center,
+                                   Resolution::toValue(b) + center};
+                uint8_t best = UNDEFINED;
+                double bestDistance2 = maxDistance2;
+                for (unsigned int color = 0; color < NUM_COLORS; color++) {
+                  if (!gaussians[color].valid)
+                    continue;
+                  double distance2 = gaussians[color].getDistance2(value);
+                  if (distance2 <= bestDistance2) {
+                    best = color;
+                    bestDistance2 = distance2;
+                  }
+                }
+                row[b - b0] = best;
+              }
+            }
+          }
+
+          for (unsigned int i = 0; i < scratch.candidates.size(); i++) {
+            const CellVotes &sample = cells[scratch.candidates[i]];
+            if (2 * sample.votes[UNDEFINED] > sample.total) {
+              int r, g, b;
+              getCellCoordinates(sample.cell, r, g, b);
+              table.cell(r, g, b) = UNDEFINED;
+            }
+          }
+        }
+
+        const TrainingSet &samples;
+        const CompileOptions &options;
+        ColorTable &table;
+        int radius;
+
+        std::vector<unsigned int> blockStarts;    ///< Start of each block's samples in blockCells
+        std::vector<unsigned int> blockCells;     ///< Positions in samples.getCells(), grouped by block
+        Gaussian gaussians[NUM_COLORS];
+
+        boost::mutex mutex;                       ///< Protects nextBlock
+        unsigned int nextBlock;
+
+    };
+
+  }
+
+  /**
+   * \brief   Computes the color of every cell of an rgb table from the samples
+   */
+  void compileTable(const TrainingSet &samples, const CompileOptions &options, ColorTable &table) {
+
+    if (table.getColorSpace() != COLOR_SPACE_RGB) {
+      table = ColorTable();
+    }
+
+    unsigned int numThreads = options.numThreads;
+    if (numThreads == 0) {
+      numThreads = std::max(boost::thread::hardware_concurrency(), 1u);
+    }
+
+    TableCompiler compiler(samples, options, table);
+    boost::thread_group threads;
+    for (unsigned int i = 1; i < numThreads; i++) {
+      threads.create_thread(boost::bind(&TableCompiler::run, &compiler));
+    }
+    compiler.run();
+    threads.join_all();
+  }
+
+}
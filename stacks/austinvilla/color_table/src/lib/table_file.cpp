@@ -0,0 +1,304 @@
+/**
+ * \file  table_file.cpp
+ * \brief Encoding and decoding of version 2 color table files
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 08/18/2011 01:52:09 PM piyushk $
+ */
+
+#include <cstring>
+#include <boost/crc.hpp>
+
+#include <color_table/table_file.h>
+
+namespace color_table {
+
+  namespace {
+
+    const unsigned int MIN_TABLE_BITS = 5;
+    const unsigned int MAX_TABLE_BITS = 8;
+    const unsigned int BLOCK_BITS = 3;
+    const unsigned int BLOCK_SIZE = 1 << BLOCK_BITS;
+    const unsigned int BLOCK_CELLS = BLOCK_SIZE * BLOCK_SIZE * BLOCK_SIZE;
+
+    inline void setError(std::string *error, const std::string &message) {
+      if (error) {
+        *error = message;
+      }
+    }
+
+    /**
+     * \struct TableGeometry
+     * \brief  Block layout of a table with a given number of bits per channel
+     */
+    struct TableGeometry {
+      TableGeometry(unsigned int bits) :
+          tableSize(1 << bits),
+          blocksPerAxis(tableSize / BLOCK_SIZE),
+          numBlocks(blocksPerAxis * blocksPerAxis * blocksPerAxis) {}
+
+      /**
+       * \brief  Offset of the first cell of the given row of a block
+       */
+      inline unsigned int getRowOffset(unsigned int block, unsigned int r, unsigned int g) const {
+        unsigned int br = block / (blocksPerAxis * blocksPerAxis);
+        unsigned int bg = (block / blocksPerAxis) % blocksPerAxis;
+        unsigned int bb = block % blocksPerAxis;
+        return ((br * BLOCK_SIZE + r) * tableSize + (bg * BLOCK_SIZE + g)) * tableSize + bb * BLOCK_SIZE;
+      }
+
+      unsigned int tableSize;
+      unsigned int blocksPerAxis;
+      unsigned int numBlocks;
+    };
+
+    void extractBlock(const TableGeometry &geometry, const uint8_t *cells, unsigned int block, uint8_t *blockCells) {
+      for (unsigned int r = 0; r < BLOCK_SIZE; r++) {
+        for (unsigned int g = 0; g < BLOCK_SIZE; g++) {
+          memcpy(blockCells + (r * BLOCK_SIZE + g) * BLOCK_SIZE, cells + geometry.getRowOffset(block, r, g), BLOCK_SIZE);
+        }
+      }
+    }
+
+    void insertBlock(const TableGeometry &geometry, uint8_t *cells, unsigned int block, const uint8_t *blockCells) {
+      for (unsigned int r = 0; r < BLOCK_SIZE; r++) {
+        for (unsigned int g = 0; g < BLOCK_SIZE; g++) {
+          memcpy(cells + geometry.getRowOffset(block, r, g), blockCells + (r * BLOCK_SIZE + g) * BLOCK_SIZE, BLOCK_SIZE);
+        }
+      }
+    }
+
+    uint32_t computeChecksum(const uint8_t *data, size_t size) {
+      boost::crc_32_type crc;
+      crc.process_bytes(data, size);
+      return crc.checksum();
+    }
+  }
+
+  /**
+   * \brief   Encodes a table into a complete version 2 file image
+   */
+  void encodeTableFile(const uint8_t *cells, unsigned int bitsPerChannel, ColorSpace colorSpace,
+      std::vector<uint8_t> &file) {
+
+    const TableGeometry geometry(bitsPerChannel);
+    file.resize(sizeof(TableFileHeader) + geometry.numBlocks);
+    std::vector<uint8_t> runs;
+    runs.reserve(2 * BLOCK_CELLS);
+    uint8_t blockCells[BLOCK_CELLS];
+
+    for (unsigned int block = 0; block < geometry.numBlocks; block++) {
+      extractBlock(geometry, cells, block, blockCells);
+
+      uint8_t &entry = file[sizeof(TableFileHeader) + block];
+      unsigned int numSame = 1;
+      while (numSame < BLOCK_CELLS && blockCells[numSame] == blockCells[0]) {
+        numSame++;
+      }
+      if (numSame == BLOCK_CELLS && blockCells[0] < BLOCK_RLE) {
+        entry = blockCells[0];
+        continue;
+      }
+
+      // Run length encode the block
+      runs.clear();
+      for (unsigned int i = 0; i < BLOCK_CELLS; ) {
+        unsigned int length = 1;
+        while (i + length < BLOCK_CELLS && length < 256 && blockCells[i + length] == blockCells[i]) {
+          length++;
+        }
+        runs.push_back(length - 1);
+        runs.push_back(blockCells[i]);
+        i += length;
+      }
+
+      if (runs.size() < BLOCK_CELLS) {
+        entry = BLOCK_RLE;
+        file.insert(file.end(), runs.begin(), runs.end());
+      } else {
+        entry = BLOCK_RAW;
+        file.insert(file.end(), blockCells, blockCells + BLOCK_CELLS);
+      }
+    }
+
+    TableFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TABLE_FILE_MAGIC, sizeof(header.magic));
+    header.version = TABLE_FILE_VERSION;
+    header.headerSize = sizeof(TableFileHeader);
+    header.bitsPerChannel = bitsPerChannel;
+    header.blockBits = BLOCK_BITS;
+    header.numColors = NUM_COLORS;
+    header.colorSpace = colorSpace;
+    header.payloadSize = file.size() - sizeof(TableFileHeader);
+    header.checksum = computeChecksum(&file[sizeof(TableFileHeader)], header.payloadSize);
+    memcpy(&file[0], &header, sizeof(header));
+  }
+
+  /**
+   * \brief   Checks whether a file image starts with a version 2 header
+   */
+  bool isTableFileV2(const uint8_t *data, size_t size) {
+    return size >= sizeof(TableFileHeader) && memcmp(data, TABLE_FILE_MAGIC, sizeof(TABLE_FILE_MAGIC)) == 0;
+  }
+
+  /**
+   * \brief   Reads the header of a version 2 file image
+   */
+  bool readTableFileHeader(const uint8_t *data, size_t size, TableFileHeader &header) {
+    if (!isTableFileV2(data, size))
+      return false;
+    memcpy(&header, data, sizeof(header));
+    return true;
+  }
+
+  /**
+   * \brief   Resolution of a legacy raw table, deduced from its size
+   */
+  unsigned int getRawTableBits(size_t size) {
+    for (unsigned int bits = MIN_TABLE_BITS; bits <= MAX_TABLE_BITS; bits++) {
+      if (size == (size_t)1 << (3 * bits))
+        return bits;
+    }
+    return 0;
+  }
+
+  /**
+   * \brief   Decodes a version 2 file image (header included)
+   */
+  bool decodeTableFile(const uint8_t *data, size_t size, uint8_t *cells, std::string *error) {
+
+    if (!isTableFileV2(data, size)) {
+      setError(error, "missing color table header");
+      return false;
+    }
+
+    TableFileHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (header.version != TABLE_FILE_VERSION || header.headerSize < sizeof(TableFileHeader)) {
+      setError(error, "unsupported color table version");
+      return false;
+    }
+    if (header.bitsPerChannel < MIN_TABLE_BITS || header.bitsPerChannel > MAX_TABLE_BITS ||
+        header.blockBits != BLOCK_BITS || header.colorSpace > COLOR_SPACE_YUV) {
+      setError(error, "unsupported color table resolution or color space");
+      return false;
+    }
+    if (header.headerSize + (size_t)header.payloadSize != size) {
+      setError(error, "truncated color table");
+      return false;
+    }
+
+    const uint8_t *payload = data + header.headerSize;
+    if (computeChecksum(payload, header.payloadSize) != header.checksum) {
+      setError(error, "color table checksum mismatch");
+      return false;
+    }
+    const TableGeometry geometry(header.bitsPerChannel);
+    if (header.payloadSize < geometry.numBlocks) {
+      setError(error, "truncated color table");
+      return false;
+    }
+
+    const uint8_t *directory = payload;
+    const uint8_t *stream = payload + geometry.numBlocks;
+    const uint8_t *end = payload + header.payloadSize;
+    uint8_t blockCells[BLOCK_CELLS];
+
+    for (unsigned int block = 0; block < geometry.numBlocks; block++) {
+      uint8_t entry = directory[block];
+      if (entry == BLOCK_RAW) {
+        if (end - stream < (ptrdiff_t)BLOCK_CELLS) {
+          setError(error, "truncated color table");
+          return false;
+        }
+        memcpy(blockCells, stream, BLOCK_CELLS);
+        stream += BLOCK_CELLS;
+      } else if (entry == BLOCK_RLE) {
+        unsigned int i = 0;
+        while (i < BLOCK_CELLS) {
+          if (end - stream < 2) {
+            setError(error, "truncated color table");
+            return false;
+          }
+          unsigned int length = stream[0] + 1;
+          if (i + length > BLOCK_CELLS) {
+            setError(error, "corrupt run in color table");
+            return false;
+          }
+          memset(blockCells + i, stream[1], length);
+          i += length;
+          stream += 2;
+        }
+      } else {
+        memset(blockCells, entry, BLOCK_CELLS);
+      }
+      insertBlock(geometry, cells, block, blockCells);
+    }
+
+    if (stream != end) {
+      setError(error, "trailing data in color table");
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * \brief   Converts a table to a different resolution
+   */
+  void resampleTable(const uint8_t *src, unsigned int srcBits, uint8_t *dst, unsigned int dstBits) {
+
+    const unsigned int dstSize = 1 << dstBits;
+    if (dstBits >= srcBits) {
+      // Every destination cell lies inside a single source cell
+      const unsigned int shift = dstBits - srcBits;
+      uint8_t *cell = dst;
+      for (unsigned int r = 0; r < dstSize; r++) {
+        for (unsigned int g = 0; g < dstSize; g++) {
+          const uint8_t *srcRow = src + ((((r >> shift) << srcBits) + (g >> shift)) << srcBits);
+          for (unsigned int b = 0; b < dstSize; b++) {
+            *cell++ = srcRow[b >> shift];
+          }
+        }
+      }
+      return;
+    }
+
+    // Each destination cell covers several source cells, and gets the color
+    // most of them agree on. UNDEFINED only wins if no other color is present.
+    const unsigned int shift = srcBits - dstBits;
+    const unsigned int span = 1 << shift;
+    unsigned int votes[256];
+    uint8_t *cell = dst;
+    for (unsigned int r = 0; r < dstSize; r++) {
+      for (unsigned int g = 0; g < dstSize; g++) {
+        for (unsigned int b = 0; b < dstSize; b++) {
+          memset(votes, 0, sizeof(votes));
+          for (unsigned int dr = 0; dr < span; dr++) {
+            for (unsigned int dg = 0; dg < span; dg++) {
+              const uint8_t *srcRow = src +
+                ((((((r << shift) + dr) << srcBits) + (g << shift) + dg) << srcBits) + (b << shift));
+              for (unsigned int db = 0; db < span; db++) {
+                votes[srcRow[db]]++;
+              }
+            }
+          }
+          uint8_t best = UNDEFINED;
+          unsigned int bestVotes = 0;
+          for (unsigned int color = 0; color < 256; color++) {
+            if (color != UNDEFINED && votes[color] > bestVotes) {
+              best = color;
+              bestVotes = votes[color];
+            }
+          }
+          *cell++ = best;
+        }
+      }
+    }
+  }
+
+}
@@ -0,0 +1,286 @@
+/**
+ * \file  table_merge.cpp
+ * \brief Definitions for comparing and merging color tables
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 09/09/2011 10:48:05 AM piyushk $
+ */
+
+#include <cstring>
+#include <sstream>
+
+#include <color_table/table_merge.h>
+
+#if defined(COLOR_TABLE_SIMD) && defined(__SSE2__)
+#define TABLE_MERGE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace color_table {
+
+  namespace {
+
+    /** Cells handled at a time by the vectorized paths */
+    const size_t CHUNK = 16;
+
+    inline const uint8_t* getCells(const ColorTable &table) {
+      return &table.getArray()[0][0][0];
+    }
+
+    /**
+     * \brief  Merges a single cell
+     */
+    inline uint8_t mergeCell(const std::vector<const uint8_t*> &cells, size_t i, MergePolicy policy,
+        MergeStatistics &stats) {
+
+      unsigned int counts[NUM_COLORS] = {0};
+      uint8_t first = UNDEFINED;
+      for (unsigned int t = 0; t < cells.size(); t++) {
+        uint8_t color = cells[t][i];
+        if (color == UNDEFINED || color >= NUM_COLORS)
+          continue;
+        counts[color]++;
+        if (first == UNDEFINED) {
+          first = color;
+        }
+      }
+      if (first == UNDEFINED)
+        return UNDEFINED;
+
+      unsigned int numColors = 0, bestCount = 0;
+      uint8_t best = UNDEFINED;
+      bool tie = false;
+      for (unsigned int color = 1; color < NUM_COLORS; color++) {
+        if (counts[color] == 0)
+          continue;
+        numColors++;
+        if (counts[color] > bestCount) {
+          bestCount = counts[color];
+          best = color;
+          tie = false;
+        } else if (counts[color] == bestCount) {
+          tie = true;
+        }
+      }
+
+      uint8_t result = first;
+      if (policy == MERGE_MAJORITY) {
+        result = tie ? (uint8_t) UNDEFINED : best;
+      } else if (policy == MERGE_KEEP_UNDEFINED && numColors > 1) {
+        result = UNDEFINED;
+      }
+
+      stats.numLabelled++;
+      if (numColors > 1) {
+        stats.numConflicts++;
+        if (result == UNDEFINED) {
+          stats.numDropped++;
+        }
+      }
+      return result;
+    }
+
+#ifdef TABLE_MERGE_SSE2
+
+    inline unsigned int countSet(__m128i mask) {
+      return __builtin_popcount(_mm_movemask_epi8(mask));
+    }
+
+    /**
+     * \brief  Merges CHUNK cells starting at i
+     */
+    inline void mergeChunk(const std::vector<const uint8_t*> &cells, size_t i, MergePolicy policy,
+        uint8_t *out, MergeStatistics &stats) {
+
+      const __m128i zero = _mm_setzero_si128();
+      const __m128i ones = _mm_cmpeq_epi8(zero, zero);
+
+      // Most chunks are the same in every table (usually all UNDEFINED)
+      __m128i firstCells = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cells[0] + i));
+      __m128i same = ones;
+      for (unsigned int t = 1; t < cells.size(); t++) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cells[t] + i));
+        same = _mm_and_si128(same, _mm_cmpeq_epi8(v, firstCells));
+      }
+      if (_mm_movemask_epi8(same) == 0xFFFF) {
+        // Values that are not a color become UNDEFINED, as in mergeCell()
+        __m128i valid = _mm_cmpeq_epi8(_mm_min_epu8(firstCells, _mm_set1_epi8(NUM_COLORS - 1)), firstCells);
+        __m128i result = _mm_and_si128(firstCells, valid);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), result);
+        stats.numLabelled += CHUNK - countSet(_mm_cmpeq_epi8(result, zero));
+        return;
+      }
+
+      // Votes per color, and the first color in priority order. cmpeq gives
+      // 0xFF (-1) for a match, so subtracting it counts the match.
+      __m128i counts[NUM_COLORS];
+      for (unsigned int color = 1; color < NUM_COLORS; color++) {
+        counts[color] = zero;
+      }
+      __m128i first = zero;
+      for (unsigned int t = 0; t < cells.size(); t++) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cells[t] + i));
+        for (unsigned int color = 1; color < NUM_COLORS; color++) {
+          counts[color] = _mm_sub_epi8(counts[color], _mm_cmpeq_epi8(v, _mm_set1_epi8(color)));
+        }
+        __m128i unset = _mm_cmpeq_epi8(first, zero);
+        __m128i valid = _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(NUM_COLORS - 1)), v);
+        first = _mm_or_si128(first, _mm_and_si128(_mm_and_si128(unset, valid), v));
+      }
+
+      __m128i numColors = zero;
+      __m128i best = zero, bestColor = zero, tie = zero;
+      for (unsigned int color = 1; color < NUM_COLORS; color++) {
+        __m128i voted = _mm_andnot_si128(_mm_cmpeq_epi8(counts[color], zero), ones);
+        numColors = _mm_sub_epi8(numColors, voted);
+        // Unsigned count > best, and ties with a non zero best
+        __m128i greater = _mm_andnot_si128(_mm_cmpeq_epi8(_mm_max_epu8(counts[color], best), best), ones);
+        __m128i equal = _mm_and_si128(_mm_cmpeq_epi8(counts[color], best), voted);
+        best = _mm_max_epu8(best, counts[color]);
+        bestColor = _mm_or_si128(_mm_and_si128(greater, _mm_set1_epi8(color)), _mm_andnot_si128(greater, bestColor));
+        tie = _mm_or_si128(_mm_andnot_si128(greater, tie), equal);
+      }
+      __m128i conflict = _mm_cmpgt_epi8(numColors, _mm_set1_epi8(1));
+
+      __m128i result;
+      if (policy == MERGE_MAJORITY) {
+        result = _mm_andnot_si128(tie, bestColor);
+      } else if (policy == MERGE_PRIORITY) {
+        result = first;
+      } else {
+        result = _mm_andnot_si128(conflict, first);
+      }
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out), result);
+
+      stats.numLabelled += CHUNK - countSet(_mm_cmpeq_epi8(first, zero));
+      stats.numConflicts += countSet(conflict);
+      stats.numDropped += countSet(_mm_and_si128(conflict, _mm_cmpeq_epi8(result, zero)));
+    }
+
+#endif
+
+    inline bool isChunkEqual(const uint8_t *a, const uint8_t *b) {
+#ifdef TABLE_MERGE_SSE2
+      __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+      __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+      return _mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) == 0xFFFF;
+#else
+      return memcmp(a, b, CHUNK) == 0;
+#endif
+    }
+
+  }
+
+  unsigned int TableDiff::getGained(unsigned int color) const {
+    unsigned int result = 0;
+    for (unsigned int from = 0; from < NUM_COLORS; from++) {
+      result += changes[from][color];
+    }
+    return result;
+  }
+
+  unsigned int TableDiff::getLost(unsigned int color) const {
+    unsigned int result = 0;
+    for (unsigned int to = 0; to < NUM_COLORS; to++) {
+      result += changes[color][to];
+    }
+    return result;
+  }
+
+  unsigned int TableDiff::getNumChanged() const {
+    unsigned int result = 0;
+    for (unsigned int color = 0; color < NUM_COLORS; color++) {
+      result += getLost(color);
+    }
+    return result;
+  }
+
+  unsigned int TableDiff::getNumConflicts() const {
+    unsigned int result = 0;
+    for (unsigned int from = 1; from < NUM_COLORS; from++) {
+      for (unsigned int to = 1; to < NUM_COLORS; to++) {
+        result += changes[from][to];
+      }
+    }
+    return result;
+  }
+
+  /**
+   * \brief   Compares two tables cell by cell
+   */
+  bool diffTables(const ColorTable &a, const ColorTable &b, TableDiff &diff, std::string *error) {
+
+    if (a.getColorSpace() != b.getColorSpace()) {
+      if (error) *error = "Tables are indexed by different color spaces";
+      return false;
+    }
+
+    memset(diff.changes, 0, sizeof(diff.changes));
+    const uint8_t *cellsA = getCells(a);
+    const uint8_t *cellsB = getCells(b);
+    for (size_t i = 0; i < ColorTable::NUM_CELLS; i += CHUNK) {
+      if (isChunkEqual(cellsA + i, cellsB + i))
+        continue;
+      for (size_t j = i; j < i + CHUNK; j++) {
+        if (cellsA[j] != cellsB[j] && cellsA[j] < NUM_COLORS && cellsB[j] < NUM_COLORS) {
+          diff.changes[cellsA[j]][cellsB[j]]++;
+        }
+      }
+    }
+    return true;
+  }
+
+  /**
+   * \brief   Merges any number of tables into one
+   */
+  bool mergeTables(const std::vector<const ColorTable*> &tables, MergePolicy policy, ColorTable &result,
+      MergeStatistics *stats, std::string *error) {
+
+    if (tables.empty() || tables.size() > MAX_MERGE_TABLES) {
+      if (error) {
+        std::stringstream ss;
+        ss << "Between 1 and " << MAX_MERGE_TABLES << " tables can be merged at once";
+        *error = ss.str();
+      }
+      return false;
+    }
+    std::vector<const uint8_t*> cells(tables.size());
+    for (unsigned int t = 0; t < tables.size(); t++) {
+      if (tables[t]->getColorSpace() != tables[0]->getColorSpace()) {
+        if (error) *error = "Tables are indexed by different color spaces";
+        return false;
+      }
+      cells[t] = getCells(*tables[t]);
+    }
+
+    // Written to a copy, since result may be one of the tables
+    ColorTable merged(*tables[0]);
+    uint8_t *out = &merged.getArray()[0][0][0];
+    MergeStatistics counts;
+    memset(&counts, 0, sizeof(counts));
+
+#ifdef TABLE_MERGE_SSE2
+    if (getSimdLevel() >= SIMD_SSE2) {
+      for (size_t i = 0; i < ColorTable::NUM_CELLS; i += CHUNK) {
+        mergeChunk(cells, i, policy, out + i, counts);
+      }
+    } else
+#endif
+    {
+      for (size_t i = 0; i < ColorTable::NUM_CELLS; i++) {
+        out[i] = mergeCell(cells, i, policy, counts);
+      }
+    }
+
+    result = merged;
+    if (stats) {
+      *stats = counts;
+    }
+    return true;
+  }
+
+}
@@ -0,0 +1,128 @@
+/**
+ * \file  live_camera_source.cpp
+ * \brief Definitions for the LiveCameraSource class
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 09/01/2011 10:40:07 AM piyushk $
+ */
+
+#include <boost/bind.hpp>
+
+#include <color_table/live_camera_source.h>
+
+namespace color_table {
+
+  LiveCameraSource::LiveCameraSource(QObject *parent) : QObject(parent),
+      notified(false), stopping(false), numReceived(0), numDropped(0) {}
+
+  LiveCameraSource::~LiveCameraSource() {
+    stop();
+  }
+
+  /**
+   * \brief   Subscribes to a camera topic
+   */
+  bool LiveCameraSource::start(const std::string &topic, std::string *error) {
+
+    stop();
+
+    if (!ros::master::check()) {
+      if (error) {
+        *error = "Unable to contact the ROS master";
+      }
+      return false;
+    }
+
+    {
+      boost::mutex::scoped_lock lock(mutex);
+      pendingImage.reset();
+      notified = false;
+      stopping = false;
+      numReceived = numDropped = 0;
+    }
+
+    nodeHandle.reset(new ros::NodeHandle);
+    nodeHandle->setCallbackQueue(&callbackQueue);
+    image_transport::ImageTransport it(*nodeHandle);
+    // A queue of 1 already drops frames that arrive while the callback runs
+    subscriber = it.subscribe(topic, 1, &LiveCameraSource::imageCallback, this);
+
+    spinThread.reset(new boost::thread(boost::bind(&LiveCameraSource::spin, this)));
+    return true;
+  }
+
+  /**
+   * \brief   Unsubscribes and stops the subscriber thread
+   */
+  void LiveCameraSource::stop() {
+
+    if (!spinThread)
+      return;
+
+    {
+      boost::mutex::scoped_lock lock(mutex);
+      stopping = true;
+    }
+    spinThread->join();
+    spinThread.reset();
+
+    subscriber.shutdown();
+    callbackQueue.clear();
+    nodeHandle.reset();
+
+    boost::mutex::scoped_lock lock(mutex);
+    pendingImage.reset();
+  }
+
+  /**
+   * \brief   Takes the newest frame
+   */
+  sensor_msgs::ImageConstPtr LiveCameraSource::takeImage() {
+    boost::mutex::scoped_lock lock(mutex);
+    notified = false;
+    sensor_msgs::ImageConstPtr image;
+    image.swap(pendingImage);
+    return image;
+  }
+
+  void LiveCameraSource::getCounts(size_t &numReceived, size_t &numDropped) {
+    boost::mutex::scoped_lock lock(mutex);
+    numReceived = this->numReceived;
+    numDropped = this->numDropped;
+  }
+
+  void LiveCameraSource::imageCallback(const sensor_msgs::ImageConstPtr &image) {
+    bool notify = false;
+    {
+      boost::mutex::scoped_lock lock(mutex);
+      numReceived++;
+      if (pendingImage) {
+        numDropped++;
+      }
+      pendingImage = image;
+      if (!notified) {
+        notified = notify = true;
+      }
+    }
+    // Emitted from this thread, so the gui receives it as a queued signal
+    if (notify) {
+      emit imageReady();
+    }
+  }
+
+  void LiveCameraSource::spin() {
+    while (true) {
+      {
+        boost::mutex::scoped_lock lock(mutex);
+        if (stopping)
+          return;
+      }
+      callbackQueue.callAvailable(ros::WallDuration(0.1));
+    }
+  }
+
+}
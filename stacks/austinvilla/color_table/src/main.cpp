@@ -13,10 +13,15 @@
 #include <QtGui>
 #include <QApplication>
 
+#include <ros/ros.h>
 #include <color_table/main_window.h>
 
 int main(int argc, char **argv) {
 
+  // Only the live camera mode talks to the master, and it connects when
+  // that mode is started
+  ros::init(argc, argv, "color_table", ros::init_options::AnonymousName | ros::init_options::NoSigintHandler);
+
   QApplication app(argc, argv);
   color_table::MainWindow main;
   main.show();
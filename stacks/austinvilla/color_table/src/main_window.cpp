@@ -11,14 +11,13 @@
  */
 
 #include <iostream>
+#include <sstream>
 #include <QtGui>
 #include <QMessageBox>
 
 #include <ros/package.h>
-#include <rosbag/bag.h>
-#include <rosbag/view.h>
 
-#include <boost/foreach.hpp>
+#include <boost/bind.hpp>
 #include <boost/lexical_cast.hpp>
 
 #include <color_table/main_window.h>
@@ -27,22 +26,34 @@ namespace color_table {
 
   using namespace Qt;
 
+  namespace {
+    /** How often the frame controls are updated while a bag is being indexed */
+    const int INDEX_POLL_MS = 100;
+
+    const char* DEFAULT_CAMERA_TOPIC = "/camera/rgb/image_color";
+  }
+
   /**
    * \brief  Constructor that initializes all elements + sets up the data 
    *         path for the classification window, as well as opens up the
    *         default color table
    */
-  MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
+  MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), firstFrameShown(false), lastLiveCount(0) {
     ui.setupUi(this); // Calling this incidentally connects all ui's triggers to on_...() callbacks in this class.
+    connect(&indexTimer, SIGNAL(timeout()), this, SLOT(updateIndexProgress()));
+    connect(&coverageTimer, SIGNAL(timeout()), this, SLOT(updateCoverageProgress()));
+    connect(&liveSource, SIGNAL(imageReady()), this, SLOT(showLiveFrame()));
+    connect(ui.filmstrip, SIGNAL(frameSelected(int)), ui.currentFrameSpin, SLOT(setValue(int)));
+    connect(&classWindow, SIGNAL(tableChanged()), this, SLOT(updateFilmstripTable()));
+    ui.filmstrip->setLoader(&thumbnails);
     initialize();
     classWindow.loadDataDirectory(getBaseDirectory() + "/data/");
     classWindow.openDefaultColorTable();
+    updateFilmstripTable();
   }
 
   void MainWindow::on_actionOpen_Bag_triggered() {
 
-    images.clear();
-
     QString fileName = QFileDialog::getOpenFileName(this, tr("Open Bag"),
         QString((getBaseDirectory() + "/data/").c_str()),
         tr("ROS Bag Files (*.bag)"));
@@ -51,37 +62,163 @@ namespace color_table {
       ui.statusBar->showMessage("User cancelled operation");
       return;
     }
-    rosbag::Bag bag;
-    try {
-      bag.open(fileName.toStdString(), rosbag::bagmode::Read);
-    } catch (rosbag::BagIOException e) {
-      ui.statusBar->showMessage("Error opening bag file!!");
+
+    // Only the message index is read up front. Frames are shown as soon as
+    // they have been indexed, and decoded when they are looked at.
+    indexTimer.stop();
+    initialize();
+    std::string error;
+    ui.actionLive_Camera->setChecked(false);
+    stopBagReaders();
+    if (!frames.open(fileName.toStdString(), DEFAULT_CAMERA_TOPIC, &error)) {
+      ui.statusBar->showMessage(("Error opening bag file: " + error).c_str());
       return;
     }
+    thumbnails.open(frames, fileName.toStdString(), DEFAULT_CAMERA_TOPIC);
+    firstFrameShown = false;
+    indexTimer.start(INDEX_POLL_MS);
+    updateIndexProgress();
+  }
+
+  void MainWindow::updateIndexProgress() {
 
-    std::vector<std::string> topics;
-    topics.push_back(std::string("/camera/rgb/image_color"));
+    bool indexing = frames.isIndexing();
+    size_t numFrames = frames.getNumFrames();
+    updateFrameRange(numFrames);
 
-    rosbag::View view(bag, rosbag::TopicQuery(topics));
-    BOOST_FOREACH(rosbag::MessageInstance const m, view) {
-      sensor_msgs::ImageConstPtr image = m.instantiate<sensor_msgs::Image>();
-      images.push_back(image);
+    if (!firstFrameShown && numFrames > 0) {
+      on_currentFrameSpin_valueChanged(0);
+      firstFrameShown = true;
     }
 
+    if (indexing) {
+      ui.statusBar->showMessage(("Indexing bag file... " + boost::lexical_cast<std::string>(numFrames) + " frames").c_str());
+    } else {
+      indexTimer.stop();
+      // Columns only map to frames once the length of the bag is known
+      ui.filmstrip->setNumFrames(numFrames);
+      ui.statusBar->showMessage(("Bag file with " + boost::lexical_cast<std::string>(numFrames) + " frames").c_str());
+    }
+  }
+
+  void MainWindow::updateFrameRange(size_t numFrames) {
+
+    if (numFrames == 0)
+      return;
+
     ui.frameSlider->setEnabled(true);
-    ui.frameSlider->setMaximum(images.size() - 1);
     ui.frameSlider->setMinimum(0);
+    ui.frameSlider->setMaximum(numFrames - 1);
 
     ui.currentFrameSpin->setEnabled(true);
-    ui.currentFrameSpin->setMaximum(images.size() - 1);
     ui.currentFrameSpin->setMinimum(0);
+    ui.currentFrameSpin->setMaximum(numFrames - 1);
+
+    ui.numFrameEdit->setText(QString((boost::lexical_cast<std::string>(numFrames - 1)).c_str()));
+  }
+
+  void MainWindow::on_actionLive_Camera_toggled(bool checked) {
 
-    ui.numFrameEdit->setText(QString((boost::lexical_cast<std::string>(images.size() - 1)).c_str()));
-    
-    classWindow.changeImage(images[0]); 
+    if (!checked) {
+      if (liveSource.isRunning()) {
+        liveSource.stop();
+        ui.statusBar->showMessage("Live camera stopped");
+      }
+      return;
+    }
+
+    bool ok;
+    QString topic = QInputDialog::getText(this, tr("Live Camera"), tr("Image topic:"),
+        QLineEdit::Normal, DEFAULT_CAMERA_TOPIC, &ok);
+    std::string error;
+    if (!ok || topic.isEmpty()) {
+      error = "User cancelled operation";
+    } else {
+      if (liveSource.start(topic.toStdString(), &error)) {
+        // Bag frames and live frames would fight over the display
+        indexTimer.stop();
+        stopBagReaders();
+        frames.close();
+        initialize();
+        lastLiveStatus = ros::WallTime::now();
+        lastLiveCount = 0;
+        ui.statusBar->showMessage(("Waiting for frames on " + topic.toStdString()).c_str());
+        return;
+      }
+    }
+    ui.actionLive_Camera->setChecked(false);
+    ui.statusBar->showMessage(error.c_str());
+  }
+
+  void MainWindow::showLiveFrame() {
+
+    sensor_msgs::ImageConstPtr image = liveSource.takeImage();
+    if (!image)
+      return;
+    // If the worker is still busy with the previous frame, that frame is
+    // dropped in favor of this one
+    classWindow.changeImage(image);
+
+    ros::WallTime now = ros::WallTime::now();
+    double elapsed = (now - lastLiveStatus).toSec();
+    if (elapsed >= 1.0) {
+      size_t numReceived, numDropped;
+      liveSource.getCounts(numReceived, numDropped);
+      size_t numShown = numReceived - numDropped;
+      std::stringstream ss;
+      ss.precision(3);
+      ss << "Live: " << (numShown - lastLiveCount) / elapsed << " fps shown, "
+         << numDropped << " of " << numReceived << " frames dropped";
+      ui.statusBar->showMessage(ss.str().c_str());
+      lastLiveStatus = now;
+      lastLiveCount = numShown;
+    }
+  }
+
+  void MainWindow::on_actionBag_Coverage_triggered() {
+
+    size_t numFrames = frames.getNumFrames();
+    if (numFrames == 0) {
+      ui.statusBar->showMessage("Open a bag file first");
+      return;
+    }
+    classWindow.setBagHistogram(boost::shared_ptr<const ColorHistogram>());
+    bagHistogram.start(frames, numFrames);
+    coverageTimer.start(INDEX_POLL_MS);
+    updateCoverageProgress();
+  }
+
+  void MainWindow::updateCoverageProgress() {
+
+    size_t numDone, numFrames;
+    bagHistogram.getProgress(numDone, numFrames);
+    if (bagHistogram.isRunning()) {
+      ui.statusBar->showMessage(("Building bag histogram... " + boost::lexical_cast<std::string>(numDone) +
+            " of " + boost::lexical_cast<std::string>(numFrames) + " frames").c_str());
+      return;
+    }
+
+    coverageTimer.stop();
+    classWindow.setBagHistogram(bagHistogram.getHistogram());
+    ui.statusBar->showMessage(("Bag coverage computed over " + boost::lexical_cast<std::string>(numFrames) +
+          " frames").c_str());
+  }
+
+  /**
+   * \brief  Stops everything that reads from the bag
+   */
+  void MainWindow::stopBagReaders() {
+    // A frame of the previous bag may still be loading on the worker
+    classWindow.cancelSegmentation();
+    coverageTimer.stop();
+    bagHistogram.stop();
+    classWindow.setBagHistogram(boost::shared_ptr<const ColorHistogram>());
+    ui.filmstrip->setNumFrames(0);
+    thumbnails.close();
+  }
 
-    ui.statusBar->showMessage(("Bag file with " + boost::lexical_cast<std::string>(images.size()) + " frames").c_str());
-    
+  void MainWindow::updateFilmstripTable() {
+    ui.filmstrip->setColorTable(classWindow.getTableSnapshot());
   }
 
   /**
@@ -93,7 +230,11 @@ namespace color_table {
 
   void MainWindow::on_currentFrameSpin_valueChanged(int value) {
     ui.frameSlider->setValue(value);
-    classWindow.changeImage(images[value]);
+    ui.filmstrip->setCurrentFrame(value);
+    frames.setCurrentFrame(value);
+    // Decoding happens on the segmentation worker, so dragging the slider
+    // only ever waits on the newest frame
+    classWindow.changeImage(boost::bind(&BagFrameSource::getFrame, &frames, (size_t) value));
   }
 
   void MainWindow::on_frameSlider_sliderMoved(int value) {
@@ -111,6 +252,8 @@ namespace color_table {
    *          program if this window is terminated
    */
   void MainWindow::closeEvent(QCloseEvent *event) {
+    liveSource.stop();
+    stopBagReaders();
     classWindow.close();
     //WriteSettings();
     event->accept();
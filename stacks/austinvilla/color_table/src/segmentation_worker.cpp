@@ -0,0 +1,222 @@
+/**
+ * \file  segmentation_worker.cpp
+ * \brief Definitions for the SegmentationWorker class
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 09/02/2011 10:26:14 AM piyushk $
+ */
+
+#include <algorithm>
+#include <boost/bind.hpp>
+
+#include <color_table/segmentation_worker.h>
+
+namespace color_table {
+
+  namespace {
+    /** Number of pixels segmented between checks for a newer request */
+    const size_t CHUNK_PIXELS = 32768;
+
+    /** Number of frame histograms kept */
+    const size_t HISTOGRAM_CACHE_SIZE = 64;
+  }
+
+  void SegmentationResult::swap(SegmentationResult &other) {
+    frame.swap(other.frame);
+    labels.swap(other.labels);
+    histogram.swap(other.histogram);
+    error.swap(other.error);
+    std::swap(loaded, other.loaded);
+    std::swap(generation, other.generation);
+  }
+
+  SegmentationWorker::SegmentationWorker(QObject *parent) : QObject(parent),
+      hasRequest(false), generation(0), busy(false), resultIsReady(false),
+      notified(false), stopping(false), numRequested(0), numTaken(0) {
+    thread.reset(new boost::thread(boost::bind(&SegmentationWorker::run, this)));
+  }
+
+  SegmentationWorker::~SegmentationWorker() {
+    {
+      boost::mutex::scoped_lock lock(mutex);
+      stopping = true;
+      generation++;
+      requestAvailable.notify_all();
+    }
+    thread->join();
+  }
+
+  /**
+   * \brief   Queues a frame to be loaded and segmented with a table
+   */
+  unsigned int SegmentationWorker::request(const ImageLoader &loader, const boost::shared_ptr<const BlockColorTable> &table) {
+    boost::mutex::scoped_lock lock(mutex);
+    pendingLoader = loader;
+    pendingTable = table;
+    hasRequest = true;
+    numRequested++;
+    resultIsReady = false;
+    requestAvailable.notify_one();
+    return ++generation;
+  }
+
+  /**
+   * \brief   Drops all requests, and waits for the running one to stop
+   */
+  void SegmentationWorker::cancel() {
+    boost::mutex::scoped_lock lock(mutex);
+    generation++;
+    hasRequest = false;
+    pendingLoader.clear();
+    pendingTable.reset();
+    resultIsReady = false;
+    while (busy) {
+      idle.wait(lock);
+    }
+  }
+
+  /**
+   * \brief   Exchanges the result of the newest request with the given buffers
+   */
+  bool SegmentationWorker::takeResult(SegmentationResult &result) {
+    boost::mutex::scoped_lock lock(mutex);
+    notified = false;
+    if (!resultIsReady)
+      return false;
+    ready.swap(result);
+    resultIsReady = false;
+    numTaken++;
+    return true;
+  }
+
+  void SegmentationWorker::getCounts(size_t &numRequested, size_t &numSuperseded) {
+    boost::mutex::scoped_lock lock(mutex);
+    numRequested = this->numRequested;
+    numSuperseded = this->numRequested - numTaken;
+    if (hasRequest || busy || resultIsReady) {
+      // The newest request has not been superseded, it just is not done yet
+      numSuperseded--;
+    }
+  }
+
+  bool SegmentationWorker::isStale(unsigned int requestGeneration) {
+    boost::mutex::scoped_lock lock(mutex);
+    return requestGeneration != generation;
+  }
+
+  /**
+   * \brief   Looks up the histogram of an image in the cache
+   */
+  boost::shared_ptr<const ColorHistogram> SegmentationWorker::getHistogram(const sensor_msgs::ImageConstPtr &image,
+      const RgbFrame &frame) {
+
+    std::list<CachedHistogram>::iterator it = histogramCache.begin();
+    while (it != histogramCache.end()) {
+      sensor_msgs::ImageConstPtr cached = it->image.lock();
+      if (!cached) {
+        // Nobody can ask for that image again
+        it = histogramCache.erase(it);
+      } else if (cached == image) {
+        histogramCache.splice(histogramCache.begin(), histogramCache, it);
+        return it->histogram;
+      } else {
+        ++it;
+      }
+    }
+
+    boost::shared_ptr<ColorHistogram> histogram(new ColorHistogram);
+    histogram->build(frame.getPixels(), frame.getNumPixels());
+    CachedHistogram entry;
+    entry.image = image;
+    entry.histogram = histogram;
+    histogramCache.push_front(entry);
+    if (histogramCache.size() > HISTOGRAM_CACHE_SIZE) {
+      histogramCache.pop_back();
+    }
+    return histogram;
+  }
+
+  /**
+   * \brief   Worker loop
+   */
+  void SegmentationWorker::run() {
+
+    // Buffers the worker fills. They are exchanged with the ready slot (and
+    // through it with the gui), so memory is only allocated when the frame
+    // size changes.
+    SegmentationResult working;
+
+    while (true) {
+      ImageLoader loader;
+      boost::shared_ptr<const BlockColorTable> table;
+      unsigned int requestGeneration;
+      {
+        boost::mutex::scoped_lock lock(mutex);
+        while (!hasRequest && !stopping) {
+          requestAvailable.wait(lock);
+        }
+        if (stopping)
+          return;
+        loader.swap(pendingLoader);
+        table.swap(pendingTable);
+        hasRequest = false;
+        requestGeneration = generation;
+        busy = true;
+      }
+
+      // Stale work is abandoned between the steps, and between chunks of
+      // the segmentation
+      bool completed = false;
+      sensor_msgs::ImageConstPtr image = loader();
+      if (!image) {
+        // Reported, so that the window stops asking for this frame
+        working.error = "Unable to read the frame";
+        working.loaded = false;
+        working.generation = requestGeneration;
+        working.histogram.reset();
+        completed = !isStale(requestGeneration);
+      } else if (!isStale(requestGeneration)) {
+        working.error.clear();
+        working.loaded = true;
+        working.generation = requestGeneration;
+        working.frame.assign(image, &working.error);
+        working.labels.resize(working.frame.getNumPixels());
+        const size_t numPixels = working.frame.getNumPixels();
+        size_t start = 0;
+        while (start < numPixels && !isStale(requestGeneration)) {
+          size_t count = std::min(CHUNK_PIXELS, numPixels - start);
+          table->segment(working.frame.getPixels() + start, count, &working.labels[start]);
+          start += count;
+        }
+        completed = (start == numPixels) && !isStale(requestGeneration);
+        if (completed) {
+          working.histogram = getHistogram(image, working.frame);
+        }
+      }
+      image.reset();
+
+      bool notify = false;
+      {
+        boost::mutex::scoped_lock lock(mutex);
+        if (completed && requestGeneration == generation) {
+          ready.swap(working);
+          resultIsReady = true;
+          if (!notified) {
+            notified = notify = true;
+          }
+        }
+        busy = false;
+        idle.notify_all();
+      }
+      // Emitted from this thread, so the gui receives it as a queued signal
+      if (notify) {
+        emit resultReady();
+      }
+    }
+  }
+
+}
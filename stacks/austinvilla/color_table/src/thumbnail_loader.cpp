@@ -0,0 +1,501 @@
+/**
+ * \file  thumbnail_loader.cpp
+ * \brief Definitions for the ThumbnailLoader class
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 09/08/2011 11:05:30 AM piyushk $
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sstream>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include <boost/bind.hpp>
+#include <boost/crc.hpp>
+#include <boost/functional/hash.hpp>
+
+#include <color_table/rgb_frame.h>
+#include <color_table/thumbnail_loader.h>
+
+namespace color_table {
+
+  namespace {
+
+    const char CACHE_EXTENSION[] = ".thumbs";
+
+    /**
+     * \struct RecordHeader
+     * \brief  Start of each record of a cache file. The pixels follow.
+     */
+    struct RecordHeader {
+      uint32_t index;                 ///< Frame of the thumbnail
+      uint32_t checksum;              ///< crc32 of the index and the pixels
+    };
+
+    const size_t PIXEL_BYTES = Thumbnail::NUM_PIXELS * sizeof(Rgb);
+    const size_t RECORD_SIZE = sizeof(RecordHeader) + PIXEL_BYTES;
+
+    uint32_t computeChecksum(uint32_t index, const Thumbnail &thumbnail) {
+      boost::crc_32_type crc;
+      crc.process_bytes(&index, sizeof(index));
+      crc.process_bytes(thumbnail.pixels, PIXEL_BYTES);
+      return crc.checksum();
+    }
+
+    /**
+     * \brief  Creates a directory and its missing parents
+     */
+    bool makeDirectories(const std::string &path) {
+      for (size_t slash = path.find('/', 1); ; slash = path.find('/', slash + 1)) {
+        std::string prefix = path.substr(0, slash);
+        if (mkdir(prefix.c_str(), 0755) != 0) {
+          struct stat info;
+          if (stat(prefix.c_str(), &info) != 0 || !S_ISDIR(info.st_mode))
+            return false;
+        }
+        if (slash == std::string::npos)
+          return true;
+      }
+    }
+
+    /**
+     * \brief  Directory holding the cache files, or an empty string if there
+     *         is nowhere to put it
+     */
+    std::string getCacheDirectory() {
+      if (const char *rosHome = getenv("ROS_HOME"))
+        return std::string(rosHome) + "/color_table/thumbnails";
+      if (const char *home = getenv("HOME"))
+        return std::string(home) + "/.ros/color_table/thumbnails";
+      return "";
+    }
+
+    /**
+     * \brief  Name of the cache file of a bag and topic, or an empty string
+     *         if the bag cannot be identified
+     */
+    std::string getBagCacheName(const std::string &bagFilename, const std::string &topic) {
+      // The same bag opened through another path shares the thumbnails,
+      // and a bag that was rewritten does not
+      char path[PATH_MAX];
+      struct stat info;
+      if (!realpath(bagFilename.c_str(), path) || stat(path, &info) != 0)
+        return "";
+      std::stringstream key;
+      key << path << '\n' << info.st_size << '\n' << info.st_mtime << '\n' << topic;
+      std::stringstream name;
+      name << std::hex << boost::hash<std::string>()(key.str()) << CACHE_EXTENSION;
+      return name.str();
+    }
+
+    /**
+     * \brief  Deletes the least recently used cache files (other than keep)
+     *         until all of them fit in maxBytes
+     */
+    void evictCacheFiles(const std::string &directory, const std::string &keep, uint64_t maxBytes) {
+
+      DIR *dir = opendir(directory.c_str());
+      if (!dir)
+        return;
+      std::vector<std::pair<time_t, std::string> > files;
+      uint64_t totalBytes = 0;
+      const size_t extensionSize = sizeof(CACHE_EXTENSION) - 1;
+      while (struct dirent *entry = readdir(dir)) {
+        std::string name(entry->d_name);
+        if (name.size() <= extensionSize ||
+            name.compare(name.size() - extensionSize, extensionSize, CACHE_EXTENSION) != 0)
+          continue;
+        struct stat info;
+        std::string path = directory + "/" + name;
+        if (stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode))
+          continue;
+        totalBytes += info.st_size;
+        if (name != keep) {
+          files.push_back(std::make_pair(info.st_mtime, path));
+        }
+      }
+      closedir(dir);
+
+      std::sort(files.begin(), files.end());
+      for (size_t i = 0; i < files.size() && totalBytes > maxBytes; i++) {
+        struct stat info;
+        if (stat(files[i].second.c_str(), &info) == 0 && unlink(files[i].second.c_str()) == 0) {
+          totalBytes -= std::min<uint64_t>(info.st_size, totalBytes);
+        }
+      }
+    }
+
+  }
+
+  ThumbnailLoader::ThumbnailLoader(size_t cacheSize, unsigned int numThreads, uint64_t maxDiskBytes) :
+      frames(NULL), numThreads(numThreads), maxDiskBytes(maxDiskBytes), cacheFile(-1),
+      cacheSize(cacheSize), tableGeneration(0), numCovering(0), changed(false), stopping(false) {
+    if (this->numThreads == 0) {
+      this->numThreads = std::max(boost::thread::hardware_concurrency(), 1u);
+    }
+  }
+
+  ThumbnailLoader::~ThumbnailLoader() {
+    close();
+  }
+
+  /**
+   * \brief   Starts the workers for a bag
+   */
+  void ThumbnailLoader::open(BagFrameSource &frames, const std::string &bagFilename, const std::string &topic) {
+
+    close();
+    this->frames = &frames;
+    openDiskCache(bagFilename, topic);
+
+    {
+      boost::mutex::scoped_lock lock(mutex);
+      stopping = false;
+    }
+    threads.reset(new boost::thread_group);
+    for (unsigned int i = 0; i < numThreads; i++) {
+      threads->create_thread(boost::bind(&ThumbnailLoader::run, this));
+    }
+  }
+
+  /**
+   * \brief   Stops the workers and empties the memory cache
+   */
+  void ThumbnailLoader::close() {
+    {
+      boost::mutex::scoped_lock lock(mutex);
+      stopping = true;
+      requestAvailable.notify_all();
+    }
+    if (threads) {
+      threads->join_all();
+      threads.reset();
+    }
+
+    closeDiskCache();
+
+    boost::mutex::scoped_lock lock(mutex);
+    pending.clear();
+    loading.clear();
+    requested.clear();
+    cache.clear();
+    cacheIndex.clear();
+    pendingCoverage.clear();
+    numCovering = 0;
+    coverage.clear();
+    changed = false;
+    frames = NULL;
+  }
+
+  /**
+   * \brief   Replaces the frames waiting to be loaded
+   */
+  void ThumbnailLoader::request(const std::vector<size_t> &indices) {
+    boost::mutex::scoped_lock lock(mutex);
+    pending.clear();
+    for (unsigned int i = 0; i < indices.size(); i++) {
+      if (!cacheIndex.count(indices[i])) {
+        pending.push_back(indices[i]);
+      }
+    }
+    requested = indices;
+    queueCoverage();
+    requestAvailable.notify_all();
+  }
+
+  /**
+   * \brief   Sets the table whose coverage of the thumbnails is worked out
+   */
+  void ThumbnailLoader::setColorTable(const boost::shared_ptr<const BlockColorTable> &table) {
+    boost::mutex::scoped_lock lock(mutex);
+    this->table = table;
+    tableGeneration++;
+    if (!table) {
+      coverage.clear();
+      changed = true;
+    }
+    queueCoverage();
+    requestAvailable.notify_all();
+  }
+
+  /**
+   * \brief   Queues the requested thumbnails that need their coverage
+   *          worked out again
+   */
+  void ThumbnailLoader::queueCoverage() {
+    pendingCoverage.clear();
+    if (!table)
+      return;
+    for (unsigned int i = 0; i < requested.size(); i++) {
+      if (!cacheIndex.count(requested[i]))
+        continue;
+      std::map<size_t, Coverage>::const_iterator entry = coverage.find(requested[i]);
+      if (entry == coverage.end() || entry->second.generation != tableGeneration) {
+        pendingCoverage.push_back(requested[i]);
+      }
+    }
+  }
+
+  float ThumbnailLoader::getCoverage(size_t index) {
+    boost::mutex::scoped_lock lock(mutex);
+    std::map<size_t, Coverage>::const_iterator entry = coverage.find(index);
+    if (entry == coverage.end())
+      return -1;
+    return entry->second.value;
+  }
+
+  float ThumbnailLoader::computeCoverage(const BlockColorTable &table, const Thumbnail &thumbnail,
+      std::vector<uint8_t> &labels) {
+    labels.resize(Thumbnail::NUM_PIXELS);
+    table.segment(thumbnail.pixels, Thumbnail::NUM_PIXELS, &labels[0]);
+    size_t numLabeled = Thumbnail::NUM_PIXELS - std::count(labels.begin(), labels.end(), (uint8_t) UNDEFINED);
+    return (float) numLabeled / Thumbnail::NUM_PIXELS;
+  }
+
+  boost::shared_ptr<const Thumbnail> ThumbnailLoader::getThumbnail(size_t index) {
+    boost::mutex::scoped_lock lock(mutex);
+    std::map<size_t, CacheList::iterator>::iterator entry = cacheIndex.find(index);
+    if (entry == cacheIndex.end())
+      return boost::shared_ptr<const Thumbnail>();
+    cache.splice(cache.begin(), cache, entry->second);
+    return entry->second->second;
+  }
+
+  bool ThumbnailLoader::takeChanged() {
+    boost::mutex::scoped_lock lock(mutex);
+    bool result = changed;
+    changed = false;
+    return result;
+  }
+
+  bool ThumbnailLoader::isBusy() {
+    boost::mutex::scoped_lock lock(mutex);
+    return !pending.empty() || !loading.empty() || !pendingCoverage.empty() || numCovering > 0;
+  }
+
+  /**
+   * \brief   Worker loop
+   */
+  void ThumbnailLoader::run() {
+
+    std::vector<uint8_t> labels;
+
+    while (true) {
+      size_t index;
+      boost::shared_ptr<const Thumbnail> cached;
+      boost::shared_ptr<const BlockColorTable> currentTable;
+      unsigned int generation;
+      {
+        boost::mutex::scoped_lock lock(mutex);
+        while (pending.empty() && pendingCoverage.empty() && !stopping) {
+          requestAvailable.wait(lock);
+        }
+        if (stopping)
+          return;
+
+        // Loading comes first, as thumbnails are drawn before the sparkline
+        if (!pending.empty()) {
+          index = pending.front();
+          pending.pop_front();
+          if (cacheIndex.count(index) || loading.count(index))
+            continue;
+          loading.insert(index);
+        } else {
+          index = pendingCoverage.front();
+          pendingCoverage.pop_front();
+          std::map<size_t, CacheList::iterator>::iterator entry = cacheIndex.find(index);
+          std::map<size_t, Coverage>::const_iterator done = coverage.find(index);
+          if (entry == cacheIndex.end() || (done != coverage.end() && done->second.generation == tableGeneration))
+            continue;
+          cached = entry->second->second;
+          numCovering++;
+        }
+        currentTable = table;
+        generation = tableGeneration;
+      }
+
+      if (cached) {
+        float value = computeCoverage(*currentTable, *cached, labels);
+        boost::mutex::scoped_lock lock(mutex);
+        numCovering--;
+        if (generation == tableGeneration && cacheIndex.count(index)) {
+          Coverage &entry = coverage[index];
+          entry.value = value;
+          entry.generation = generation;
+          changed = true;
+        }
+        continue;
+      }
+
+      boost::shared_ptr<Thumbnail> thumbnail(new Thumbnail);
+      bool loaded = loadFromDisk(index, *thumbnail);
+      if (!loaded) {
+        loaded = makeThumbnail(index, *thumbnail);
+        if (loaded) {
+          saveToDisk(index, *thumbnail);
+        }
+      }
+      float value = -1;
+      if (loaded && currentTable) {
+        value = computeCoverage(*currentTable, *thumbnail, labels);
+      }
+
+      boost::mutex::scoped_lock lock(mutex);
+      loading.erase(index);
+      if (!loaded)
+        continue;
+      cache.push_front(std::make_pair(index, boost::shared_ptr<const Thumbnail>(thumbnail)));
+      cacheIndex[index] = cache.begin();
+      if (currentTable && table) {
+        Coverage &entry = coverage[index];
+        entry.value = value;
+        entry.generation = generation;
+        if (generation != tableGeneration) {
+          // The table changed while loading, the value stays until redone
+          pendingCoverage.push_back(index);
+          requestAvailable.notify_one();
+        }
+      }
+      while (cache.size() > cacheSize) {
+        cacheIndex.erase(cache.back().first);
+        coverage.erase(cache.back().first);
+        cache.pop_back();
+      }
+      changed = true;
+    }
+  }
+
+  /**
+   * \brief   Decodes a frame and scales it down
+   */
+  bool ThumbnailLoader::makeThumbnail(size_t index, Thumbnail &thumbnail) {
+
+    // Read past the frame cache, so that the frames around the current one
+    // stay cached
+    sensor_msgs::ImageConstPtr image = frames->readFrame(index);
+    RgbFrame frame;
+    if (!image || !frame.assign(image))
+      return false;
+    if (frame.getWidth() == 0 || frame.getHeight() == 0)
+      return false;
+
+    // Each thumbnail pixel takes the frame pixel at its center
+    const unsigned int width = frame.getWidth();
+    const unsigned int height = frame.getHeight();
+    Rgb *out = thumbnail.pixels;
+    for (unsigned int y = 0; y < Thumbnail::HEIGHT; y++) {
+      unsigned int sy = (2 * y + 1) * height / (2 * Thumbnail::HEIGHT);
+      for (unsigned int x = 0; x < Thumbnail::WIDTH; x++) {
+        unsigned int sx = (2 * x + 1) * width / (2 * Thumbnail::WIDTH);
+        *out++ = frame.at(sx, sy);
+      }
+    }
+    return true;
+  }
+
+  /**
+   * \brief   Opens the cache file of a bag, and finds the frames it holds
+   */
+  void ThumbnailLoader::openDiskCache(const std::string &bagFilename, const std::string &topic) {
+
+    std::string directory = getCacheDirectory();
+    std::string name = getBagCacheName(bagFilename, topic);
+    if (directory.empty() || name.empty() || !makeDirectories(directory))
+      return;
+    evictCacheFiles(directory, name, maxDiskBytes);
+
+    std::string filename = directory + "/" + name;
+    int file = ::open(filename.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (file < 0)
+      return;
+    // Marks the bag as recently used
+    utime(filename.c_str(), NULL);
+
+    // A record cut short (by a full disk, or a crash) is dropped, so that
+    // new records start on a record boundary
+    struct stat info;
+    if (fstat(file, &info) != 0) {
+      ::close(file);
+      return;
+    }
+    uint64_t size = info.st_size - info.st_size % RECORD_SIZE;
+    if (size != (uint64_t) info.st_size && ftruncate(file, size) != 0) {
+      ::close(file);
+      return;
+    }
+
+    boost::mutex::scoped_lock lock(diskMutex);
+    cacheFile = file;
+    diskIndex.clear();
+    for (uint64_t offset = 0; offset < size; offset += RECORD_SIZE) {
+      RecordHeader header;
+      if (pread(file, &header, sizeof(header), offset) != (ssize_t) sizeof(header))
+        break;
+      diskIndex[header.index] = offset;
+    }
+  }
+
+  void ThumbnailLoader::closeDiskCache() {
+    boost::mutex::scoped_lock lock(diskMutex);
+    if (cacheFile >= 0) {
+      ::close(cacheFile);
+      cacheFile = -1;
+    }
+    diskIndex.clear();
+  }
+
+  bool ThumbnailLoader::loadFromDisk(size_t index, Thumbnail &thumbnail) {
+    boost::mutex::scoped_lock lock(diskMutex);
+    std::map<size_t, uint64_t>::const_iterator entry = diskIndex.find(index);
+    if (cacheFile < 0 || entry == diskIndex.end())
+      return false;
+    RecordHeader header;
+    if (pread(cacheFile, &header, sizeof(header), entry->second) != (ssize_t) sizeof(header) ||
+        pread(cacheFile, thumbnail.pixels, PIXEL_BYTES, entry->second + sizeof(header)) != (ssize_t) PIXEL_BYTES)
+      return false;
+    // Another instance may have written over the record
+    return header.index == index && header.checksum == computeChecksum(header.index, thumbnail);
+  }
+
+  void ThumbnailLoader::saveToDisk(size_t index, const Thumbnail &thumbnail) {
+    boost::mutex::scoped_lock lock(diskMutex);
+    if (cacheFile < 0)
+      return;
+    struct stat info;
+    if (fstat(cacheFile, &info) != 0 || (uint64_t) info.st_size + RECORD_SIZE > maxDiskBytes)
+      return;
+
+    // Written with a single call, so that the record lands in one piece at
+    // the end of the file
+    std::vector<uint8_t> record(RECORD_SIZE);
+    RecordHeader header;
+    header.index = index;
+    header.checksum = computeChecksum(header.index, thumbnail);
+    memcpy(&record[0], &header, sizeof(header));
+    memcpy(&record[sizeof(header)], thumbnail.pixels, PIXEL_BYTES);
+    ssize_t written = write(cacheFile, &record[0], RECORD_SIZE);
+    if (written != (ssize_t) RECORD_SIZE) {
+      // Drops whatever part of the record made it to the file
+      if (written > 0 && ftruncate(cacheFile, info.st_size) != 0) {
+        ::close(cacheFile);
+        cacheFile = -1;
+      }
+      return;
+    }
+    diskIndex[index] = info.st_size;
+  }
+
+}
@@ -0,0 +1,177 @@
+/**
+ * \file  merge_tables.cpp
+ * \brief Command line tool that compares two color tables, or merges
+ * tables labelled in separate sessions into one
+ *
+ * Usage: merge_tables diff old.col new.col
+ *        merge_tables merge -o output.col [-p majority|priority|undefined]
+ *                     [-s rgb|yuv] input.col...
+ *
+ * Merging a single table with -s converts it, for instance to a yuv indexed
+ * table that segments the robots' YUV 4:2:2 frames directly.
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 09/09/2011 02:31:19 PM piyushk $
+ */
+
+#include <iomanip>
+#include <iostream>
+
+#include <ros/time.h>
+#include <boost/shared_ptr.hpp>
+
+#include <color_table/table_merge.h>
+
+using namespace color_table;
+
+namespace {
+
+  const char* COLOR_NAMES[NUM_COLORS] = {"undefined", "orange", "pink", "blue", "green", "white", "yellow"};
+
+  void printUsage(const char *program) {
+    std::cerr << "Usage: " << program << " diff old.col new.col" << std::endl
+              << "       " << program << " merge -o output.col [-p policy] [-s space] input.col..." << std::endl
+              << "  -o output.col  Merged table" << std::endl
+              << "  -p policy      How cells the tables disagree on are merged:" << std::endl
+              << "                   majority   the color most tables have (default)" << std::endl
+              << "                   priority   the color of the first table listed that has one" << std::endl
+              << "                   undefined  left undefined" << std::endl
+              << "  -s space       Converts the tables to rgb or yuv indexing before merging" << std::endl
+              << "                 (default: keep the color space of the inputs)" << std::endl;
+  }
+
+  bool loadTable(const std::string &filename, ColorTable &table) {
+    std::string error;
+    if (!table.load(filename, &error)) {
+      std::cerr << "Unable to load " << filename << ": " << error << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  int diff(const std::vector<std::string> &files) {
+
+    ColorTable a, b;
+    if (!loadTable(files[0], a) || !loadTable(files[1], b))
+      return 1;
+
+    TableDiff diff;
+    std::string error;
+    if (!diffTables(a, b, diff, &error)) {
+      std::cerr << error << std::endl;
+      return 1;
+    }
+
+    std::vector<unsigned int> countsA, countsB;
+    ColorTable::countLabels(&a.getArray()[0][0][0], ColorTable::NUM_CELLS, countsA);
+    ColorTable::countLabels(&b.getArray()[0][0][0], ColorTable::NUM_CELLS, countsB);
+
+    std::cout << std::setw(10) << "color" << std::setw(10) << "old" << std::setw(10) << "new"
+              << std::setw(10) << "gained" << std::setw(10) << "lost" << std::endl;
+    for (unsigned int color = 0; color < NUM_COLORS; color++) {
+      std::cout << std::setw(10) << COLOR_NAMES[color] << std::setw(10) << countsA[color]
+                << std::setw(10) << countsB[color] << std::setw(10) << diff.getGained(color)
+                << std::setw(10) << diff.getLost(color) << std::endl;
+    }
+    std::cout << diff.getNumChanged() << " cells changed, " << diff.getNumConflicts()
+              << " of them labelled with a different color in both tables" << std::endl;
+    for (unsigned int from = 1; from < NUM_COLORS; from++) {
+      for (unsigned int to = 1; to < NUM_COLORS; to++) {
+        if (diff.changes[from][to] > 0) {
+          std::cout << "  " << COLOR_NAMES[from] << " -> " << COLOR_NAMES[to] << ": "
+                    << diff.changes[from][to] << std::endl;
+        }
+      }
+    }
+    return 0;
+  }
+
+  int merge(const std::vector<std::string> &files, const std::string &outputFile, MergePolicy policy,
+      const ColorSpace *space) {
+
+    std::vector<boost::shared_ptr<ColorTable> > loaded;
+    std::vector<const ColorTable*> tables;
+    for (unsigned int i = 0; i < files.size(); i++) {
+      loaded.push_back(boost::shared_ptr<ColorTable>(new ColorTable));
+      if (!loadTable(files[i], *loaded.back()))
+        return 1;
+      if (space) {
+        loaded.back()->convert(*space);
+      }
+      tables.push_back(loaded.back().get());
+    }
+
+    ros::WallTime start = ros::WallTime::now();
+    ColorTable result;
+    MergeStatistics stats;
+    std::string error;
+    if (!mergeTables(tables, policy, result, &stats, &error)) {
+      std::cerr << error << std::endl;
+      return 1;
+    }
+    double seconds = (ros::WallTime::now() - start).toSec();
+
+    if (!result.save(outputFile, &error)) {
+      std::cerr << "Unable to save " << outputFile << ": " << error << std::endl;
+      return 1;
+    }
+    std::cout << "Merged " << tables.size() << " tables in " << seconds * 1000 << " ms: "
+              << stats.numLabelled << " cells labelled, " << stats.numConflicts << " conflicts, "
+              << stats.numDropped << " of them left undefined" << std::endl;
+    return 0;
+  }
+}
+
+int main(int argc, char **argv) {
+
+  if (argc < 2) {
+    printUsage(argv[0]);
+    return 1;
+  }
+  std::string command = argv[1];
+  std::string outputFile;
+  MergePolicy policy = MERGE_MAJORITY;
+  ColorSpace space = COLOR_SPACE_RGB;
+  bool convert = false;
+
+  std::vector<std::string> positional;
+  for (int i = 2; i < argc; i++) {
+    std::string arg = argv[i];
+    if ((arg == "-o" || arg == "-p" || arg == "-s") && i + 1 < argc) {
+      std::string value = argv[++i];
+      if (arg == "-o") {
+        outputFile = value;
+      } else if (arg == "-s" && (value == "rgb" || value == "yuv")) {
+        space = (value == "yuv") ? COLOR_SPACE_YUV : COLOR_SPACE_RGB;
+        convert = true;
+      } else if (arg == "-s") {
+        printUsage(argv[0]);
+        return 1;
+      } else if (value == "majority") {
+        policy = MERGE_MAJORITY;
+      } else if (value == "priority") {
+        policy = MERGE_PRIORITY;
+      } else if (value == "undefined") {
+        policy = MERGE_KEEP_UNDEFINED;
+      } else {
+        printUsage(argv[0]);
+        return 1;
+      }
+    } else {
+      positional.push_back(arg);
+    }
+  }
+
+  if (command == "diff" && positional.size() == 2) {
+    return diff(positional);
+  }
+  if (command == "merge" && !positional.empty() && !outputFile.empty()) {
+    return merge(positional, outputFile, policy, convert ? &space : NULL);
+  }
+  printUsage(argv[0]);
+  return 1;
+}
@@ -0,0 +1,335 @@
+/**
+ * \file  segment_bag.cpp
+ * \brief Command line tool that applies a color table to every frame of a
+ * bag, using all cores, and writes out either a bag of label images or a
+ * csv file with per frame label statistics
+ *
+ * Usage: segment_bag table.col input.bag (-o output.bag | -c stats.csv)
+ *                    [-t topic] [-j threads]
+ *
+ * Frames are read from the bag by the main thread and handed to a pool of
+ * worker threads. Results are written back in frame order.
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 08/29/2011 02:14:37 PM piyushk $
+ */
+
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+
+#include <rosbag/bag.h>
+#include <rosbag/view.h>
+#include <sensor_msgs/Image.h>
+#include <sensor_msgs/image_encodings.h>
+
+#include <boost/foreach.hpp>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+
+#include <color_table/color_table.h>
+
+using namespace color_table;
+
+namespace {
+
+  const char* COLOR_NAMES[NUM_COLORS] = {"undefined", "orange", "pink", "blue", "green", "white", "yellow"};
+
+  /**
+   * \struct Frame
+   * \brief  A frame read from the bag, and the result of segmenting it
+   */
+  struct Frame {
+    size_t index;
+    ros::Time time;                         ///< Time the frame was recorded in the bag
+    ros::Time stamp;                        ///< Time stamp of the image itself
+    unsigned int width, height;
+    sensor_msgs::ImageConstPtr image;
+    sensor_msgs::ImagePtr labels;           ///< Only filled in when writing a bag
+    std::vector<unsigned int> counts;       ///< Number of pixels of each color
+    bool ok;
+  };
+
+  /**
+   * \class FrameQueue
+   * \brief Bounded queue of frames, shared between threads
+   */
+  class FrameQueue {
+    public:
+      FrameQueue(size_t capacity) : capacity(capacity), closed(false) {}
+
+      /**
+       * \brief  Adds a frame, waiting while the queue is full
+       */
+      void push(const Frame &frame) {
+        boost::mutex::scoped_lock lock(mutex);
+        while (frames.size() >= capacity) {
+          notFull.wait(lock);
+        }
+        frames.push_back(frame);
+        notEmpty.notify_one();
+      }
+
+      /**
+       * \brief  Removes a frame, waiting while the queue is empty
+       * \return false once the queue is closed and empty
+       */
+      bool pop(Frame &frame) {
+        boost::mutex::scoped_lock lock(mutex);
+        while (frames.empty() && !closed) {
+          notEmpty.wait(lock);
+        }
+        if (frames.empty())
+          return false;
+        frame = frames.front();
+        frames.pop_front();
+        notFull.notify_one();
+        return true;
+      }
+
+      /**
+       * \brief  Signals that no more frames will be pushed
+       */
+      void close() {
+        boost::mutex::scoped_lock lock(mutex);
+        closed = true;
+        notEmpty.notify_all();
+      }
+
+    private:
+      size_t capacity;
+      bool closed;
+      std::deque<Frame> frames;
+      boost::mutex mutex;
+      boost::condition_variable notEmpty, notFull;
+  };
+
+  /**
+   * \class ResultCollector
+   * \brief Gathers segmented frames from the workers and hands them back to
+   *        the writer in frame order
+   */
+  class ResultCollector {
+    public:
+      ResultCollector() : nextIndex(0) {}
+
+      void add(const Frame &frame) {
+        boost::mutex::scoped_lock lock(mutex);
+        pending[frame.index] = frame;
+        if (frame.index == nextIndex) {
+          ready.notify_one();
+        }
+      }
+
+      /**
+       * \brief  Waits for the next frame in order
+       */
+      void next(Frame &frame) {
+        boost::mutex::scoped_lock lock(mutex);
+        while (pending.empty() || pending.begin()->first != nextIndex) {
+          ready.wait(lock);
+        }
+        frame = pending.begin()->second;
+        pending.erase(pending.begin());
+        nextIndex++;
+      }
+
+    private:
+      size_t nextIndex;
+      std::map<size_t, Frame> pending;
+      boost::mutex mutex;
+      boost::condition_variable ready;
+  };
+
+  void segmentFrames(const ColorTable &table, bool makeLabelImages, FrameQueue &queue, ResultCollector &results) {
+    Frame frame;
+    std::vector<uint8_t> labels;
+    while (queue.pop(frame)) {
+      frame.ok = table.segmentImage(*frame.image, labels);
+      if (frame.ok) {
+        ColorTable::countLabels(labels.empty() ? NULL : &labels[0], labels.size(), frame.counts);
+        if (makeLabelImages) {
+          frame.labels.reset(new sensor_msgs::Image);
+          frame.labels->header = frame.image->header;
+          frame.labels->width = frame.image->width;
+          frame.labels->height = frame.image->height;
+          frame.labels->encoding = sensor_msgs::image_encodings::MONO8;
+          frame.labels->is_bigendian = false;
+          frame.labels->step = frame.image->width;
+          frame.labels->data.swap(labels);
+        }
+      }
+      frame.image.reset();
+      results.add(frame);
+    }
+  }
+
+  /**
+   * \class FrameWriter
+   * \brief Writes segmented frames to the output bag and/or csv file
+   */
+  class FrameWriter {
+    public:
+      FrameWriter(rosbag::Bag *bag, const std::string &labelTopic, std::ofstream *csv) :
+          bag(bag), labelTopic(labelTopic), csv(csv), numFailed(0) {}
+
+      void write(const Frame &frame) {
+        if (!frame.ok) {
+          numFailed++;
+          return;
+        }
+        if (bag) {
+          bag->write(labelTopic, frame.time, frame.labels);
+        }
+        if (csv) {
+          *csv << frame.index << "," << frame.stamp << "," << frame.width << "," << frame.height;
+          for (unsigned int i = 0; i < frame.counts.size(); i++) {
+            *csv << "," << frame.counts[i];
+          }
+          *csv << std::endl;
+        }
+      }
+
+      inline size_t getNumFailed() const {
+        return numFailed;
+      }
+
+    private:
+      rosbag::Bag *bag;
+      std::string labelTopic;
+      std::ofstream *csv;
+      size_t numFailed;
+  };
+
+  void printUsage(const char *program) {
+    std::cerr << "Usage: " << program << " table.col input.bag (-o output.bag | -c stats.csv) [-t topic] [-j threads]" << std::endl
+              << "  -o output.bag  Write a mono8 label image per frame, on <topic>_labels" << std::endl
+              << "  -c stats.csv   Write the number of pixels of each color per frame" << std::endl
+              << "  -t topic       Image topic (default /camera/rgb/image_color)" << std::endl
+              << "  -j threads     Number of worker threads (default: number of cores)" << std::endl;
+  }
+}
+
+int main(int argc, char **argv) {
+
+  std::string tableFile, inputBag, outputBag, csvFile;
+  std::string topic = "/camera/rgb/image_color";
+  unsigned int numThreads = boost::thread::hardware_concurrency();
+
+  std::vector<std::string> positional;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if ((arg == "-o" || arg == "-c" || arg == "-t" || arg == "-j") && i + 1 < argc) {
+      std::string value = argv[++i];
+      if (arg == "-o") outputBag = value;
+      else if (arg == "-c") csvFile = value;
+      else if (arg == "-t") topic = value;
+      else numThreads = atoi(value.c_str());
+    } else {
+      positional.push_back(arg);
+    }
+  }
+  if (positional.size() != 2 || (outputBag.empty() && csvFile.empty())) {
+    printUsage(argv[0]);
+    return 1;
+  }
+  tableFile = positional[0];
+  inputBag = positional[1];
+  numThreads = std::max(numThreads, 1u);
+
+  ColorTable table;
+  std::string error;
+  if (!table.load(tableFile, &error)) {
+    std::cerr << "Unable to load color table: " << error << std::endl;
+    return 1;
+  }
+
+  rosbag::Bag input, output;
+  try {
+    input.open(inputBag, rosbag::bagmode::Read);
+    if (!outputBag.empty()) {
+      output.open(outputBag, rosbag::bagmode::Write);
+    }
+  } catch (rosbag::BagException &e) {
+    std::cerr << "Error opening bag file: " << e.what() << std::endl;
+    return 1;
+  }
+
+  std::ofstream csv;
+  if (!csvFile.empty()) {
+    csv.open(csvFile.c_str());
+    if (!csv) {
+      std::cerr << "Unable to open " << csvFile << std::endl;
+      return 1;
+    }
+    csv << "frame,stamp,width,height";
+    for (unsigned int i = 0; i < NUM_COLORS; i++) {
+      csv << "," << COLOR_NAMES[i];
+    }
+    csv << std::endl;
+  }
+
+  std::cout << "Segmenting " << topic << " with " << numThreads << " threads ("
+            << getSimdLevelName(getSimdLevel()) << " kernel)" << std::endl;
+
+  FrameQueue queue(2 * numThreads);
+  ResultCollector results;
+  boost::thread_group workers;
+  for (unsigned int i = 0; i < numThreads; i++) {
+    workers.create_thread(boost::bind(&segmentFrames, boost::cref(table), !outputBag.empty(),
+          boost::ref(queue), boost::ref(results)));
+  }
+
+  // Read frames on this thread, and write out finished frames whenever
+  // enough of them are waiting, so that memory use stays bounded
+  FrameWriter writer(outputBag.empty() ? NULL : &output, topic + "_labels", csv.is_open() ? &csv : NULL);
+  size_t numRead = 0, numWritten = 0;
+  std::vector<std::string> topics(1, topic);
+  rosbag::View view(input, rosbag::TopicQuery(topics));
+  ros::WallTime start = ros::WallTime::now();
+
+  Frame done;
+  BOOST_FOREACH(rosbag::MessageInstance const m, view) {
+    sensor_msgs::ImageConstPtr image = m.instantiate<sensor_msgs::Image>();
+    if (!image)
+      continue;
+    Frame frame;
+    frame.index = numRead++;
+    frame.time = m.getTime();
+    frame.stamp = image->header.stamp;
+    frame.width = image->width;
+    frame.height = image->height;
+    frame.image = image;
+    frame.ok = false;
+    queue.push(frame);
+
+    while (numWritten + 4 * numThreads < numRead) {
+      results.next(done);
+      writer.write(done);
+      numWritten++;
+    }
+  }
+  queue.close();
+
+  while (numWritten < numRead) {
+    results.next(done);
+    writer.write(done);
+    numWritten++;
+  }
+  workers.join_all();
+
+  double seconds = (ros::WallTime::now() - start).toSec();
+  std::cout << "Segmented " << numRead - writer.getNumFailed() << " frames in " << seconds << "s ("
+            << numRead / std::max(seconds, 1e-6) << " frames/s)" << std::endl;
+  if (writer.getNumFailed() > 0) {
+    std::cerr << writer.getNumFailed() << " frames were skipped (unsupported image encoding)" << std::endl;
+  }
+
+  return 0;
+}
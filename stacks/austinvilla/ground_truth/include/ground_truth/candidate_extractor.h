@@ -0,0 +1,170 @@
+/**
+ * \file  candidate_extractor.h
+ * \brief Header for the CandidateExtractor class, which picks the points
+ * that may belong to the ball or to a robot out of a kinect cloud
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 09/12/2011 10:34:51 AM piyushk $
+ */
+
+#ifndef CANDIDATE_EXTRACTOR_P2HX7TMB
+#define CANDIDATE_EXTRACTOR_P2HX7TMB
+
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread.hpp>
+#include <Eigen/Geometry>
+#include <sensor_msgs/PointCloud2.h>
+
+#include <color_table/color_table.h>
+
+namespace ground_truth {
+
+  /**
+   * \struct Candidate
+   * \brief  A point of the cloud, transformed into field coordinates
+   */
+  struct Candidate {
+    float x, y, z;
+    float rgb;                    ///< Packed as in pcl::PointXYZRGB
+    uint32_t index;               ///< Row major index of the point in the cloud
+  };
+
+  /**
+   * \struct CandidateRegions
+   * \brief  Boxes (in field coordinates, centered on the field) that ball
+   *         and robot candidates have to lie in
+   */
+  struct CandidateRegions {
+    float ballMaxX, ballMaxY, ballMaxZ;   ///< Orange points below ballMaxZ
+    float robotMaxX, robotMaxY;           ///< Any point above robotMinZ
+    float robotMinZ;
+
+    CandidateRegions() : ballMaxX(3.5), ballMaxY(2.25), ballMaxZ(0.15),
+        robotMaxX(2.75), robotMaxY(2), robotMinZ(0.25) {}
+  };
+
+  /**
+   * \class CandidateExtractor
+   * \brief Transforms and classifies every point of a cloud in a single pass
+   *        over the raw PointCloud2 buffer
+   *
+   * The points of the cloud are split between threads, which are started
+   * once and reused for every cloud. Each point is read
+   * straight from the message, transformed into field coordinates, and
+   * dropped unless it lies in one of the candidate regions. Only points in
+   * the ball region are looked up in the color table. The candidates of each
+   * kind are written to a compact array, in cloud order.
+   */
+  class CandidateExtractor : boost::noncopyable {
+
+    public:
+
+      /**
+       * \param   numThreads 0 for one per core
+       */
+      CandidateExtractor(unsigned int numThreads = 0);
+      ~CandidateExtractor();
+
+      /**
+       * \brief   Sets the transformation from the kinect frame to the field
+       */
+      void setTransform(const Eigen::Affine3f &transform);
+
+      /**
+       * \brief   Sets the table ball candidates are classified with. It has
+       *          to outlive the extractor.
+       */
+      void setColorTable(const color_table::ColorTable *table);
+
+      void setRegions(const CandidateRegions &regions);
+
+      /**
+       * \brief   Also keeps every valid point (for displaying the full cloud)
+       */
+      void setKeepAll(bool keepAll);
+
+      /**
+       * \brief   Extracts the candidates of a cloud
+       * \return  false if the cloud lacks float x, y, z or rgb fields, or
+       *          if its data is too small for its dimensions and steps
+       */
+      bool extract(const sensor_msgs::PointCloud2 &cloud, std::string *error = NULL);
+
+      inline const std::vector<Candidate>& getBallCandidates() const {
+        return ball;
+      }
+      inline const std::vector<Candidate>& getRobotCandidates() const {
+        return robot;
+      }
+
+      /**
+       * \brief   Every valid point, if setKeepAll() is on
+       */
+      inline const std::vector<Candidate>& getAllPoints() const {
+        return all;
+      }
+
+      /**
+       * \brief   Dimensions of the last cloud, for organized clouds
+       */
+      inline unsigned int getWidth() const {
+        return width;
+      }
+      inline unsigned int getHeight() const {
+        return height;
+      }
+
+    private:
+
+      /**
+       * \struct Stripe
+       * \brief  Candidates found by one thread, kept between frames so that
+       *         their memory is reused
+       */
+      struct Stripe {
+        std::vector<Candidate> ball, robot, all;
+      };
+
+      /**
+       * \brief   Extracts the candidates of a range of points
+       */
+      void extractPoints(const sensor_msgs::PointCloud2 &cloud, size_t begin, size_t end, Stripe &stripe) const;
+
+      void run(unsigned int stripe);
+
+      unsigned int numThreads;
+      float matrix[3][4];                 ///< Rows of the transformation
+      const color_table::ColorTable *table;
+      CandidateRegions regions;
+      bool keepAll;
+
+      unsigned int xOffset, yOffset, zOffset, rgbOffset;
+      std::vector<Stripe> stripes;
+
+      std::vector<Candidate> ball, robot, all;
+      unsigned int width, height;
+
+      boost::mutex mutex;                     ///< Protects everything below
+      boost::condition_variable workAvailable;
+      boost::condition_variable workDone;
+      const sensor_msgs::PointCloud2 *cloud;  ///< Cloud being extracted, shared with the workers
+      size_t numPoints;
+      unsigned int numStripes;
+      unsigned int generation;                ///< Incremented for each cloud handed to the workers
+      unsigned int numBusy;                   ///< Workers still extracting the current cloud
+      bool stopping;
+
+      boost::thread_group threads;
+
+  };
+
+}
+
+#endif /* end of include guard: CANDIDATE_EXTRACTOR_P2HX7TMB */
@@ -0,0 +1,38 @@
+/**
+ * \file  field_dimensions.h
+ * \brief This header defines the dimensions of the field, without any of the
+ * drawing dependencies of field_provider.h
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 09/19/2011 02:14:32 PM piyushk $
+ */
+
+#ifndef FIELD_DIMENSIONS_R4NQ8WZE
+#define FIELD_DIMENSIONS_R4NQ8WZE
+
+namespace ground_truth {
+
+  /* constants describing the field */
+
+  const float FIELD_Y = 3.950;            ///< width of the field
+  const float FIELD_X = 5.950;            ///< length of the field
+
+  const float GRASS_Y = 4.725;            ///< width of the grass
+  const float GRASS_X = 6.725;            ///< length of the grass 
+
+  const float PENALTY_Y = 2.150;          ///< distance of penalty box along width 
+  const float PENALTY_X =  0.550;         ///< distance of penalty box along length
+  const float CIRCLE_RADIUS =  0.650;     ///< center circle radius
+
+  const float PENALTY_CROSS_X = 1.200;    ///< distance of penalty cross from field center
+
+  const float GOAL_HEIGHT = 0.8;          ///< height of top goal bar
+  const float GOAL_Y = 1.5;               ///< distance between goal posts
+
+}
+
+#endif /* end of include guard: FIELD_DIMENSIONS_R4NQ8WZE */
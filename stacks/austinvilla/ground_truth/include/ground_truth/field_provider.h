@@ -1,7 +1,7 @@
 /**
  * \file  field_provider.h
- * \brief This header defines the dimensions of the field, as well as 
- * declares the helper functions to draw out the field in 2D and 3D
+ * \brief This header defines the landmarks of the field (its dimensions are in
+ * field_dimensions.h), as well as declares the helper functions to draw out the field in 2D and 3D
  *
  * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
  * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
@@ -18,24 +18,9 @@
 #include <opencv/cv.h>
 #include <pcl_visualization/pcl_visualizer.h>
 
-namespace ground_truth {
-
-  /* constants describing the field */
-
-  const float FIELD_Y = 3.950;            ///< width of the field
-  const float FIELD_X = 5.950;            ///< length of the field
-
-  const float GRASS_Y = 4.725;            ///< width of the grass
-  const float GRASS_X = 6.725;            ///< length of the grass 
+#include <ground_truth/field_dimensions.h>
 
-  const float PENALTY_Y = 2.150;          ///< distance of penalty box along width 
-  const float PENALTY_X =  0.550;         ///< distance of penalty box along length
-  const float CIRCLE_RADIUS =  0.650;     ///< center circle radius
-
-  const float PENALTY_CROSS_X = 1.200;    ///< distance of penalty cross from field center
-
-  const float GOAL_HEIGHT = 0.8;          ///< height of top goal bar
-  const float GOAL_Y = 1.5;               ///< distance between goal posts
+namespace ground_truth {
 
   /* Different points of interest on the field */
 
@@ -0,0 +1,103 @@
+/**
+ * \file  occupancy_grid.h
+ * \brief Header for the OccupancyGrid class, a 2D grid of the points above
+ * the ground over the field, used to detect robots
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 09/14/2011 10:05:41 AM piyushk $
+ */
+
+#ifndef OCCUPANCY_GRID_J5TB8CWE
+#define OCCUPANCY_GRID_J5TB8CWE
+
+#include <vector>
+
+#include <ground_truth/candidate_extractor.h>
+#include <ground_truth/field_dimensions.h>
+#include <ground_truth/organized_clusterer.h>
+
+namespace ground_truth {
+
+  /**
+   * \class OccupancyGrid
+   * \brief Bins points into square cells over the ground plane, keeping
+   *        the number of points and the height of the highest point of
+   *        each cell
+   *
+   * The grid covers the grass (GRASS_X by GRASS_Y, centered on the field).
+   * Blobs are 8 connected components of occupied cells. Their cost depends
+   * on the area of the field rather than on the number of points, and the
+   * height of a blob is the largest height of its cells.
+   */
+  class OccupancyGrid {
+
+    public:
+
+      /**
+       * \param   cellSize Side of a cell in meters
+       */
+      OccupancyGrid(float cellSize = 0.02, float sizeX = GRASS_X, float sizeY = GRASS_Y);
+
+      /**
+       * \brief   Empties every cell
+       */
+      void clear();
+
+      /**
+       * \brief   Adds points to the grid. Points off the grass are ignored.
+       */
+      void add(const std::vector<Candidate> &points);
+
+      /**
+       * \brief   Finds the blobs of occupied cells
+       * \param   minPoints Blobs with fewer points are dropped
+       * \param   blobs Receives the blobs. The centroid is weighted by the
+       *          number of points in each cell, z is 0 and maxZ is the
+       *          height of the highest point. The covariance takes the
+       *          points of a cell to be spread uniformly over it.
+       */
+      void findBlobs(unsigned int minPoints, std::vector<Cluster> &blobs);
+
+      inline unsigned int getNumCellsX() const {
+        return numCellsX;
+      }
+      inline unsigned int getNumCellsY() const {
+        return numCellsY;
+      }
+      inline float getCellSize() const {
+        return cellSize;
+      }
+
+      /**
+       * \brief   Number of points in each cell, row major with y along rows
+       */
+      inline const std::vector<unsigned int>& getCounts() const {
+        return counts;
+      }
+
+      /**
+       * \brief   Height of the highest point of each cell (0 if empty)
+       */
+      inline const std::vector<float>& getHeights() const {
+        return heights;
+      }
+
+    private:
+
+      float cellSize;
+      float originX, originY;                 ///< Field coordinates of the corner of cell 0
+      unsigned int numCellsX, numCellsY;
+
+      std::vector<unsigned int> counts;
+      std::vector<float> heights;
+      std::vector<bool> visited;              ///< Cells already assigned to a blob
+      std::vector<unsigned int> stack;        ///< Cells left to visit in the current blob
+  };
+
+}
+
+#endif /* end of include guard: OCCUPANCY_GRID_J5TB8CWE */
@@ -0,0 +1,100 @@
+/**
+ * \file  organized_clusterer.h
+ * \brief Header for the OrganizedClusterer class, which clusters points of
+ * an organized cloud using its image grid
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 09/13/2011 09:52:18 AM piyushk $
+ */
+
+#ifndef ORGANIZED_CLUSTERER_F6RW3JNE
+#define ORGANIZED_CLUSTERER_F6RW3JNE
+
+#include <vector>
+
+#include <ground_truth/candidate_extractor.h>
+
+namespace ground_truth {
+
+  /**
+   * \struct Cluster
+   * \brief  Summary of a cluster of candidates
+   */
+  struct Cluster {
+    float x, y, z;                  ///< Centroid
+    float maxZ;                     ///< Height of the highest point
+    float covariance[3];            ///< xx, xy and yy covariance of the points on the ground plane
+    unsigned int size;              ///< Number of points
+  };
+
+  /**
+   * \class OrganizedClusterer
+   * \brief Connected component clustering over the pixel grid of an
+   *        organized cloud
+   *
+   * Two points are connected if they are 4 (or 8) neighbors in the image
+   * and are closer than the tolerance in 3D. Components are found with a
+   * union-find over a single raster sweep, so the cost is linear in the
+   * number of points, with no kd-tree. For the compact blobs that the ball
+   * and the robots make in the image, the clusters match those of
+   * pcl::EuclideanClusterExtraction with the same tolerance.
+   *
+   * Candidates must come from an organized cloud (height > 1), sorted by
+   * their index, as CandidateExtractor writes them.
+   */
+  class OrganizedClusterer {
+
+    public:
+
+      enum Connectivity {
+        FOUR_CONNECTED = 4,
+        EIGHT_CONNECTED = 8
+      };
+
+      OrganizedClusterer(float tolerance = 0.1, Connectivity connectivity = EIGHT_CONNECTED);
+
+      void setTolerance(float tolerance);
+      void setConnectivity(Connectivity connectivity);
+
+      /**
+       * \brief   Clusters one set of candidates
+       * \param   minSize Clusters with fewer points are dropped
+       * \param   clusters Receives the clusters, ordered by their first point
+       */
+      void cluster(const std::vector<Candidate> &candidates, unsigned int width, unsigned int height,
+          unsigned int minSize, std::vector<Cluster> &clusters);
+
+      /**
+       * \brief   Clusters several sets of candidates (for instance ball and
+       *          robot candidates) in the same sweep. Points are only
+       *          connected to points of the same set.
+       * \param   minSizes Minimum cluster size for each set
+       * \param   clusters Receives the clusters of each set
+       */
+      void cluster(const std::vector<const std::vector<Candidate>*> &sets, unsigned int width,
+          unsigned int height, const std::vector<unsigned int> &minSizes,
+          std::vector<std::vector<Cluster> > &clusters);
+
+    private:
+
+      unsigned int find(unsigned int i);
+
+      float tolerance;
+      Connectivity connectivity;
+
+      /* Reused between frames */
+
+      std::vector<int> grid;                  ///< Slot of the point at each pixel, -1 if none
+      std::vector<const Candidate*> points;   ///< Points of all sets, in raster order
+      std::vector<unsigned int> labels;       ///< Set of each point
+      std::vector<unsigned int> parent;       ///< Union-find forest
+      std::vector<int> clusterOf;             ///< Output cluster of each root
+  };
+
+}
+
+#endif /* end of include guard: ORGANIZED_CLUSTERER_F6RW3JNE */
@@ -0,0 +1,100 @@
+/**
+ * \file  triple_buffer.h
+ * \brief Header for the TripleBuffer class, a lock-free latest-wins handoff
+ * between a single producer thread and a single consumer thread
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 09/16/2011 11:20:37 AM piyushk $
+ */
+
+#ifndef TRIPLE_BUFFER_Q8ZK2DMH
+#define TRIPLE_BUFFER_Q8ZK2DMH
+
+#include <boost/noncopyable.hpp>
+
+namespace ground_truth {
+
+  /**
+   * \class TripleBuffer
+   * \brief Passes the latest value from one producer to one consumer
+   *        without locks
+   *
+   * The producer fills getBack() and calls publish(), the consumer calls
+   * update() and reads getFront(). Each side owns one of the three slots,
+   * and the third one (the middle) is swapped in and out atomically, so
+   * neither side ever waits for the other. Values that the consumer did not
+   * pick up in time are overwritten by newer ones. Slots are reused, so a T
+   * that holds buffers keeps its allocations between values.
+   */
+  template <typename T>
+  class TripleBuffer : boost::noncopyable {
+
+    public:
+
+      TripleBuffer() : back(0), front(1), middle(2) {}
+
+      /**
+       * \brief   Slot being filled by the producer
+       */
+      inline T& getBack() {
+        return slots[back];
+      }
+
+      /**
+       * \brief   Hands the back slot to the consumer and takes the middle
+       *          one in its place
+       */
+      inline void publish() {
+        back = exchange(back | FRESH) & INDEX;
+      }
+
+      /**
+       * \brief   Takes the newest published value, if any, as the front slot
+       * \return  false if nothing was published since the last update
+       */
+      inline bool update() {
+        if (!(middle & FRESH))
+          return false;
+        front = exchange(front) & INDEX;
+        return true;
+      }
+
+      /**
+       * \brief   Slot being read by the consumer
+       */
+      inline T& getFront() {
+        return slots[front];
+      }
+
+    private:
+
+      enum {
+        INDEX = 3,
+        FRESH = 4           ///< The middle slot has not been seen by the consumer
+      };
+
+      /**
+       * \brief   Swaps the middle slot. The full barrier of the swap makes
+       *          the writes to a slot visible before the slot changes hands.
+       */
+      inline unsigned int exchange(unsigned int value) {
+        unsigned int old;
+        do {
+          old = middle;
+        } while (__sync_val_compare_and_swap(&middle, old, value) != old);
+        return old;
+      }
+
+      T slots[3];
+      unsigned int back;                ///< Only touched by the producer
+      unsigned int front;               ///< Only touched by the consumer
+      volatile unsigned int middle;     ///< Index of the middle slot and the FRESH flag
+  };
+
+}
+
+#endif /* end of include guard: TRIPLE_BUFFER_Q8ZK2DMH */
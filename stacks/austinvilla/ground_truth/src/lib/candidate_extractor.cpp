@@ -0,0 +1,269 @@
+/**
+ * \file  candidate_extractor.cpp
+ * \brief Definitions for the CandidateExtractor class
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 09/12/2011 11:20:06 AM piyushk $
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+#include <ground_truth/candidate_extractor.h>
+
+namespace ground_truth {
+
+  namespace {
+
+    /** Clouds smaller than this are not worth splitting between threads */
+    const size_t MIN_POINTS_PER_THREAD = 16384;
+
+    /**
+     * \brief  Offset of a field of the cloud, or -1 if it is missing or not
+     *         one of the given types
+     */
+    int getFieldOffset(const sensor_msgs::PointCloud2 &cloud, const std::string &name,
+        uint8_t datatype, uint8_t otherDatatype) {
+      for (unsigned int i = 0; i < cloud.fields.size(); i++) {
+        const sensor_msgs::PointField &field = cloud.fields[i];
+        if (field.name == name && (field.datatype == datatype || field.datatype == otherDatatype))
+          return field.offset;
+      }
+      return -1;
+    }
+
+    /**
+     * \brief  False for NaN (invalid kinect points) and infinities
+     */
+    inline bool isFinite(float value) {
+      return value - value == 0;
+    }
+
+    inline float readFloat(const uint8_t *data) {
+      float value;
+      memcpy(&value, data, sizeof(value));
+      return value;
+    }
+
+    /**
+     * \brief  True if every point of a width x height cloud lies inside its
+     *         data, with fieldsEnd bytes of each point in use
+     */
+    bool hasPoints(const sensor_msgs::PointCloud2 &cloud, size_t fieldsEnd) {
+      if (cloud.width == 0 || cloud.height == 0)
+        return true;
+      size_t rowBytes = (size_t) (cloud.width - 1) * cloud.point_step + fieldsEnd;
+      return cloud.point_step >= fieldsEnd && cloud.row_step >= rowBytes &&
+          cloud.data.size() >= (size_t) (cloud.height - 1) * cloud.row_step + rowBytes;
+    }
+
+    inline void appendAll(std::vector<Candidate> &out, const std::vector<Candidate> &in) {
+      out.insert(out.end(), in.begin(), in.end());
+    }
+  }
+
+  CandidateExtractor::CandidateExtractor(unsigned int numThreads) : numThreads(numThreads),
+      table(NULL), keepAll(false), xOffset(0), yOffset(0), zOffset(0), rgbOffset(0), width(0), height(0),
+      cloud(NULL), numPoints(0), numStripes(0), generation(0), numBusy(0), stopping(false) {
+    if (this->numThreads == 0) {
+      this->numThreads = std::max(boost::thread::hardware_concurrency(), 1u);
+    }
+    setTransform(Eigen::Affine3f::Identity());
+
+    // The first stripe is done on the calling thread
+    stripes.resize(this->numThreads);
+    for (unsigned int i = 1; i < this->numThreads; i++) {
+      threads.create_thread(boost::bind(&CandidateExtractor::run, this, i));
+    }
+  }
+
+  CandidateExtractor::~CandidateExtractor() {
+    {
+      boost::mutex::scoped_lock lock(mutex);
+      stopping = true;
+      workAvailable.notify_all();
+    }
+    threads.join_all();
+  }
+
+  void CandidateExtractor::setTransform(const Eigen::Affine3f &transform) {
+    for (int i = 0; i < 3; i++) {
+      for (int j = 0; j < 4; j++) {
+        matrix[i][j] = transform(i, j);
+      }
+    }
+  }
+
+  void CandidateExtractor::setColorTable(const color_table::ColorTable *table) {
+    this->table = table;
+  }
+
+  void CandidateExtractor::setRegions(const CandidateRegions &regions) {
+    this->regions = regions;
+  }
+
+  void CandidateExtractor::setKeepAll(bool keepAll) {
+    this->keepAll = keepAll;
+  }
+
+  /**
+   * \brief   Extracts the candidates of a cloud
+   */
+  bool CandidateExtractor::extract(const sensor_msgs::PointCloud2 &cloud, std::string *error) {
+
+    using sensor_msgs::PointField;
+    int x = getFieldOffset(cloud, "x", PointField::FLOAT32, PointField::FLOAT32);
+    int y = getFieldOffset(cloud, "y", PointField::FLOAT32, PointField::FLOAT32);
+    int z = getFieldOffset(cloud, "z", PointField::FLOAT32, PointField::FLOAT32);
+    int rgb = getFieldOffset(cloud, "rgb", PointField::FLOAT32, PointField::UINT32);
+    if (rgb < 0) {
+      rgb = getFieldOffset(cloud, "rgba", PointField::FLOAT32, PointField::UINT32);
+    }
+    if (x < 0 || y < 0 || z < 0 || rgb < 0 || cloud.is_bigendian) {
+      if (error) *error = "Cloud does not have little endian float x, y, z and rgb fields";
+      return false;
+    }
+    size_t fieldsEnd = std::max(std::max(x, y), std::max(z, rgb)) + sizeof(float);
+    if (!hasPoints(cloud, fieldsEnd)) {
+      if (error) *error = "Cloud data is smaller than its width, height, point_step and row_step require";
+      return false;
+    }
+    if (table && table->getColorSpace() != color_table::COLOR_SPACE_RGB) {
+      if (error) *error = "Color table is not rgb indexed";
+      return false;
+    }
+    xOffset = x;
+    yOffset = y;
+    zOffset = z;
+    rgbOffset = rgb;
+    width = cloud.width;
+    height = cloud.height;
+
+    numPoints = (size_t) width * height;
+    numStripes = std::max((size_t) 1, std::min((size_t) numThreads, numPoints / MIN_POINTS_PER_THREAD));
+
+    if (numStripes > 1) {
+      boost::mutex::scoped_lock lock(mutex);
+      this->cloud = &cloud;
+      generation++;
+      numBusy = numStripes - 1;
+      workAvailable.notify_all();
+    }
+    extractPoints(cloud, 0, numPoints / numStripes, stripes[0]);
+    if (numStripes > 1) {
+      boost::mutex::scoped_lock lock(mutex);
+      while (numBusy != 0) {
+        workDone.wait(lock);
+      }
+      this->cloud = NULL;
+    }
+
+    ball.clear();
+    robot.clear();
+    all.clear();
+    for (unsigned int i = 0; i < numStripes; i++) {
+      appendAll(ball, stripes[i].ball);
+      appendAll(robot, stripes[i].robot);
+      appendAll(all, stripes[i].all);
+    }
+    return true;
+  }
+
+  /**
+   * \brief   Worker loop, extracts the given stripe of each cloud
+   */
+  void CandidateExtractor::run(unsigned int stripe) {
+
+    unsigned int seen = 0;
+    while (true) {
+      const sensor_msgs::PointCloud2 *cloud;
+      size_t begin, end;
+      {
+        boost::mutex::scoped_lock lock(mutex);
+        while (generation == seen && !stopping) {
+          workAvailable.wait(lock);
+        }
+        if (stopping)
+          return;
+        seen = generation;
+        if (stripe >= numStripes)
+          continue;
+        cloud = this->cloud;
+        begin = numPoints * stripe / numStripes;
+        end = numPoints * (stripe + 1) / numStripes;
+      }
+
+      extractPoints(*cloud, begin, end, stripes[stripe]);
+
+      boost::mutex::scoped_lock lock(mutex);
+      if (--numBusy == 0) {
+        workDone.notify_one();
+      }
+    }
+  }
+
+  /**
+   * \brief   Extracts the candidates of a range of points
+   */
+  void CandidateExtractor::extractPoints(const sensor_msgs::PointCloud2 &cloud, size_t begin, size_t end,
+      Stripe &stripe) const {
+
+    stripe.ball.clear();
+    stripe.robot.clear();
+    stripe.all.clear();
+    if (begin >= end)
+      return;
+
+    const uint8_t *data = &cloud.data[0];
+    unsigned int row = begin / width;
+    unsigned int col = begin % width;
+    const uint8_t *point = data + (size_t) row * cloud.row_step + (size_t) col * cloud.point_step;
+
+    for (size_t i = begin; i < end; i++) {
+
+      float px = readFloat(point + xOffset);
+      float py = readFloat(point + yOffset);
+      float pz = readFloat(point + zOffset);
+
+      if (isFinite(px) && isFinite(py) && isFinite(pz)) {
+        Candidate c;
+        c.x = matrix[0][0] * px + matrix[0][1] * py + matrix[0][2] * pz + matrix[0][3];
+        c.y = matrix[1][0] * px + matrix[1][1] * py + matrix[1][2] * pz + matrix[1][3];
+        c.z = matrix[2][0] * px + matrix[2][1] * py + matrix[2][2] * pz + matrix[2][3];
+        c.rgb = readFloat(point + rgbOffset);
+        c.index = i;
+
+        if (keepAll) {
+          stripe.all.push_back(c);
+        }
+        if (c.z > regions.robotMinZ && fabs(c.x) < regions.robotMaxX && fabs(c.y) < regions.robotMaxY) {
+          stripe.robot.push_back(c);
+        } else if (fabs(c.z) < regions.ballMaxZ && fabs(c.x) < regions.ballMaxX && fabs(c.y) < regions.ballMaxY &&
+            table) {
+          // rgb is packed as b, g, r from the lowest byte
+          const uint8_t *color = point + rgbOffset;
+          if (table->classify(color[2], color[1], color[0]) == color_table::ORANGE) {
+            stripe.ball.push_back(c);
+          }
+        }
+      }
+
+      if (++col == width) {
+        col = 0;
+        row++;
+        point = data + (size_t) row * cloud.row_step;
+      } else {
+        point += cloud.point_step;
+      }
+    }
+  }
+
+}
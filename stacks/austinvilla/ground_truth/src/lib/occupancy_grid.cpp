@@ -0,0 +1,117 @@
+/**
+ * \file  occupancy_grid.cpp
+ * \brief Definitions for the OccupancyGrid class
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 09/14/2011 10:48:27 AM piyushk $
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include <ground_truth/occupancy_grid.h>
+
+namespace ground_truth {
+
+  OccupancyGrid::OccupancyGrid(float cellSize, float sizeX, float sizeY) : cellSize(cellSize),
+      originX(-sizeX / 2), originY(-sizeY / 2) {
+    numCellsX = (unsigned int) ceil(sizeX / cellSize);
+    numCellsY = (unsigned int) ceil(sizeY / cellSize);
+    counts.assign(numCellsX * numCellsY, 0);
+    heights.assign(numCellsX * numCellsY, 0);
+    visited.assign(numCellsX * numCellsY, false);
+  }
+
+  void OccupancyGrid::clear() {
+    std::fill(counts.begin(), counts.end(), 0);
+    std::fill(heights.begin(), heights.end(), 0);
+  }
+
+  /**
+   * \brief   Adds points to the grid
+   */
+  void OccupancyGrid::add(const std::vector<Candidate> &points) {
+    for (unsigned int i = 0; i < points.size(); i++) {
+      float cellX = (points[i].x - originX) / cellSize;
+      float cellY = (points[i].y - originY) / cellSize;
+      if (cellX < 0 || cellY < 0 || cellX >= numCellsX || cellY >= numCellsY)
+        continue;
+      unsigned int cell = (unsigned int) cellY * numCellsX + (unsigned int) cellX;
+      counts[cell]++;
+      heights[cell] = std::max(heights[cell], points[i].z);
+    }
+  }
+
+  /**
+   * \brief   Finds the blobs of occupied cells
+   */
+  void OccupancyGrid::findBlobs(unsigned int minPoints, std::vector<Cluster> &blobs) {
+
+    blobs.clear();
+    std::fill(visited.begin(), visited.end(), false);
+
+    for (unsigned int seed = 0; seed < counts.size(); seed++) {
+      if (counts[seed] == 0 || visited[seed])
+        continue;
+
+      // Flood fill the blob from its first cell in raster order
+      double sumX = 0, sumY = 0;
+      double sumXX = 0, sumXY = 0, sumYY = 0;
+      unsigned int numPoints = 0;
+      float maxZ = 0;
+      visited[seed] = true;
+      stack.clear();
+      stack.push_back(seed);
+      while (!stack.empty()) {
+        unsigned int cell = stack.back();
+        stack.pop_back();
+        unsigned int x = cell % numCellsX;
+        unsigned int y = cell / numCellsX;
+        sumX += (double) counts[cell] * (x + 0.5);
+        sumY += (double) counts[cell] * (y + 0.5);
+        sumXX += (double) counts[cell] * (x + 0.5) * (x + 0.5);
+        sumXY += (double) counts[cell] * (x + 0.5) * (y + 0.5);
+        sumYY += (double) counts[cell] * (y + 0.5) * (y + 0.5);
+        numPoints += counts[cell];
+        maxZ = std::max(maxZ, heights[cell]);
+
+        for (int dy = -1; dy <= 1; dy++) {
+          for (int dx = -1; dx <= 1; dx++) {
+            int nx = (int) x + dx;
+            int ny = (int) y + dy;
+            if (nx < 0 || ny < 0 || nx >= (int) numCellsX || ny >= (int) numCellsY)
+              continue;
+            unsigned int neighbor = ny * numCellsX + nx;
+            if (counts[neighbor] > 0 && !visited[neighbor]) {
+              visited[neighbor] = true;
+              stack.push_back(neighbor);
+            }
+          }
+        }
+      }
+
+      if (numPoints < minPoints)
+        continue;
+      Cluster blob;
+      double meanX = sumX / numPoints;
+      double meanY = sumY / numPoints;
+      blob.x = originX + meanX * cellSize;
+      blob.y = originY + meanY * cellSize;
+      blob.z = 0;
+      blob.maxZ = maxZ;
+      // Points are taken at their cell centers, plus the spread of a
+      // uniform distribution over a cell
+      double squaredCellSize = (double) cellSize * cellSize;
+      blob.covariance[0] = (sumXX / numPoints - meanX * meanX + 1.0 / 12) * squaredCellSize;
+      blob.covariance[1] = (sumXY / numPoints - meanX * meanY) * squaredCellSize;
+      blob.covariance[2] = (sumYY / numPoints - meanY * meanY + 1.0 / 12) * squaredCellSize;
+      blob.size = numPoints;
+      blobs.push_back(blob);
+    }
+  }
+
+}
@@ -0,0 +1,201 @@
+/**
+ * \file  organized_clusterer.cpp
+ * \brief Definitions for the OrganizedClusterer class
+ *
+ * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
+ * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
+ *
+ * License: Modified BSD License
+ *
+ * $ Id: 09/13/2011 10:40:33 AM piyushk $
+ */
+
+#include <algorithm>
+
+#include <ground_truth/organized_clusterer.h>
+
+namespace ground_truth {
+
+  namespace {
+
+    /**
+     * \struct ClusterSum
+     * \brief  Running sums of a cluster while it is being collected
+     */
+    struct ClusterSum {
+      unsigned int label;
+      double x, y, z;
+      double xx, xy, yy;
+      float maxZ;
+      unsigned int size;
+    };
+
+    inline float getSquaredDistance(const Candidate &a, const Candidate &b) {
+      float dx = a.x - b.x;
+      float dy = a.y - b.y;
+      float dz = a.z - b.z;
+      return dx * dx + dy * dy + dz * dz;
+    }
+  }
+
+  OrganizedClusterer::OrganizedClusterer(float tolerance, Connectivity connectivity) :
+      tolerance(tolerance), connectivity(connectivity) {}
+
+  void OrganizedClusterer::setTolerance(float tolerance) {
+    this->tolerance = tolerance;
+  }
+
+  void OrganizedClusterer::setConnectivity(Connectivity connectivity) {
+    this->connectivity = connectivity;
+  }
+
+  /**
+   * \brief   Root of a point's component, halving the path on the way
+   */
+  unsigned int OrganizedClusterer::find(unsigned int i) {
+    while (parent[i] != i) {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+    return i;
+  }
+
+  void OrganizedClusterer::cluster(const std::vector<Candidate> &candidates, unsigned int width,
+      unsigned int height, unsigned int minSize, std::vector<Cluster> &clusters) {
+    std::vector<const std::vector<Candidate>*> sets(1, &candidates);
+    std::vector<unsigned int> minSizes(1, minSize);
+    std::vector<std::vector<Cluster> > result;
+    cluster(sets, width, height, minSizes, result);
+    clusters.swap(result[0]);
+  }
+
+  /**
+   * \brief   Clusters several sets of candidates in the same sweep
+   */
+  void OrganizedClusterer::cluster(const std::vector<const std::vector<Candidate>*> &sets, unsigned int width,
+      unsigned int height, const std::vector<unsigned int> &minSizes,
+      std::vector<std::vector<Cluster> > &clusters) {
+
+    clusters.assign(sets.size(), std::vector<Cluster>());
+    size_t numPixels = (size_t) width * height;
+    if (grid.size() != numPixels) {
+      grid.assign(numPixels, -1);
+    }
+
+    // Merge the sets (each in raster order) into a single raster order
+    points.clear();
+    labels.clear();
+    std::vector<size_t> next(sets.size(), 0);
+    while (true) {
+      int best = -1;
+      for (unsigned int s = 0; s < sets.size(); s++) {
+        if (next[s] < sets[s]->size() &&
+            (best < 0 || (*sets[s])[next[s]].index < (*sets[best])[next[best]].index)) {
+          best = s;
+        }
+      }
+      if (best < 0)
+        break;
+      points.push_back(&(*sets[best])[next[best]++]);
+      labels.push_back(best);
+    }
+
+    unsigned int numPoints = points.size();
+    parent.resize(numPoints);
+    for (unsigned int i = 0; i < numPoints; i++) {
+      parent[i] = i;
+      grid[points[i]->index] = i;
+    }
+
+    // Only the neighbors that come earlier in raster order are looked at
+    float squaredTolerance = tolerance * tolerance;
+    for (unsigned int i = 0; i < numPoints; i++) {
+      unsigned int index = points[i]->index;
+      unsigned int row = index / width;
+      unsigned int col = index % width;
+
+      int neighbors[4];
+      unsigned int numNeighbors = 0;
+      if (col > 0) {
+        neighbors[numNeighbors++] = grid[index - 1];
+      }
+      if (row > 0) {
+        neighbors[numNeighbors++] = grid[index - width];
+        if (connectivity == EIGHT_CONNECTED) {
+          if (col > 0) {
+            neighbors[numNeighbors++] = grid[index - width - 1];
+          }
+          if (col + 1 < width) {
+            neighbors[numNeighbors++] = grid[index - width + 1];
+          }
+        }
+      }
+
+      for (unsigned int n = 0; n < numNeighbors; n++) {
+        int j = neighbors[n];
+        if (j < 0 || labels[j] != labels[i] ||
+            getSquaredDistance(*points[i], *points[j]) >= squaredTolerance)
+          continue;
+        unsigned int rootI = find(i);
+        unsigned int rootJ = find(j);
+        // The root is always the earliest point of the component
+        if (rootI < rootJ) {
+          parent[rootJ] = rootI;
+        } else if (rootJ < rootI) {
+          parent[rootI] = rootJ;
+        }
+      }
+    }
+
+    // Sum up the components. Roots come first in their component, so the
+    // sums end up ordered by the first point of each cluster.
+    std::vector<ClusterSum> sums;
+    clusterOf.assign(numPoints, -1);
+    for (unsigned int i = 0; i < numPoints; i++) {
+      unsigned int root = find(i);
+      if (clusterOf[root] < 0) {
+        ClusterSum sum;
+        sum.label = labels[i];
+        sum.x = sum.y = sum.z = 0;
+        sum.xx = sum.xy = sum.yy = 0;
+        sum.maxZ = points[i]->z;
+        sum.size = 0;
+        clusterOf[root] = sums.size();
+        sums.push_back(sum);
+      }
+      ClusterSum &sum = sums[clusterOf[root]];
+      sum.x += points[i]->x;
+      sum.y += points[i]->y;
+      sum.z += points[i]->z;
+      sum.xx += (double) points[i]->x * points[i]->x;
+      sum.xy += (double) points[i]->x * points[i]->y;
+      sum.yy += (double) points[i]->y * points[i]->y;
+      sum.maxZ = std::max(sum.maxZ, points[i]->z);
+      sum.size++;
+    }
+
+    for (unsigned int i = 0; i < sums.size(); i++) {
+      const ClusterSum &sum = sums[i];
+      if (sum.size < minSizes[sum.label])
+        continue;
+      Cluster cluster;
+      double meanX = sum.x / sum.size;
+      double meanY = sum.y / sum.size;
+      cluster.x = meanX;
+      cluster.y = meanY;
+      cluster.z = sum.z / sum.size;
+      cluster.maxZ = sum.maxZ;
+      cluster.covariance[0] = sum.xx / sum.size - meanX * meanX;
+      cluster.covariance[1] = sum.xy / sum.size - meanX * meanY;
+      cluster.covariance[2] = sum.yy / sum.size - meanY * meanY;
+      cluster.size = sum.size;
+      clusters[sum.label].push_back(cluster);
+    }
+
+    // Leave the grid empty for the next cloud
+    for (unsigned int i = 0; i < numPoints; i++) {
+      grid[points[i]->index] = -1;
+    }
+  }
+
+}
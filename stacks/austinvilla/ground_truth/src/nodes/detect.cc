@@ -4,7 +4,8 @@
  *
  * This ROS node detects the ground truth locations of the ball and the robots
  * on the field. It uses the collected calibration info as well as the color
- * table
+ * table. Detections are published as GroundTruth messages, and are also
+ * displayed unless the node runs headless.
  *
  * \author  Piyush Khandelwal (piyushk), piyushk@cs.utexas.edu
  * Copyright (C) 2011, The University of Texas at Austin, Piyush Khandelwal
@@ -14,34 +15,63 @@
  * $ Id: 08/10/2011 12:48:11 PM piyushk $
  */
 
+#include <algorithm>
+#include <fstream>
+
 #include <ros/ros.h>
 #include <image_transport/image_transport.h>
 #include <image_geometry/pinhole_camera_model.h>
 
+#include <boost/thread/condition_variable.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/scoped_ptr.hpp>
 
 #include <pcl/point_types.h>
 #include <pcl_visualization/pcl_visualizer.h>
-#include <pcl/registration/transforms.h>
-#include <pcl/filters/extract_indices.h>
-#include <pcl/segmentation/extract_clusters.h>
 #include <terminal_tools/parse.h>
+#include <tf/transform_broadcaster.h>
 
 #include <Eigen/Core>
 
 #include <color_table/common.h>
+#include <color_table/color_table.h>
+#include <ground_truth/candidate_extractor.h>
 #include <ground_truth/field_provider.h>
+#include <ground_truth/GroundTruth.h>
+#include <ground_truth/occupancy_grid.h>
+#include <ground_truth/organized_clusterer.h>
+#include <ground_truth/triple_buffer.h>
 
-/* Display modes */
+/* Display modes: all points, or only the robot candidates. Detections are
+ * published in both. */
 #define FULL 1
 #define RELEVANT 2
 
 using namespace color_table;
 
 namespace {
-  sensor_msgs::PointCloud2ConstPtr cloudPtr, oldCloudPtr;
-  boost::mutex mCloud;
+
+  /**
+   * \struct Detection
+   * \brief  Output of the processing stage for one cloud
+   */
+  struct Detection {
+    std::vector<ground_truth::Cluster> balls;
+    std::vector<ground_truth::Cluster> robots;
+    pcl::PointCloud<pcl::PointXYZRGB> cloud;    ///< Points to display
+  };
+
+  /* Stages: the ROS spinner receives clouds, the processing thread detects
+   * the ball and the robots, and the main thread renders. Each stage only
+   * sees the latest output of the previous one. */
+  ground_truth::TripleBuffer<sensor_msgs::PointCloud2ConstPtr> cloudBuffer;
+  ground_truth::TripleBuffer<Detection> detectionBuffer;
+  boost::mutex mProcess;                    ///< Guards the processing thread's wait for new clouds
+  boost::condition_variable processCondition;
+  bool processing = true;
+
   pcl_visualization::PointCloudColorHandler<pcl::PointXYZRGB>::Ptr colorHandler;
   pcl_visualization::PointCloudGeometryHandler<pcl::PointXYZRGB>::Ptr geometryHandler;
 
@@ -49,26 +79,30 @@ namespace {
   std::string colorTableFile;
   std::string logFile;
   Eigen::Affine3f transformMatrix;
+  tf::Transform cameraToField;              ///< transformMatrix, as the pose of the camera in the field frame
+  ros::Publisher groundTruthPublisher;
 
   int qSize;
   std::string cloudTopic;
   int mode;
+  int renderRate;                           ///< Rendering rate in Hz
+  int headless;                             ///< No display at all, detections are only published
+  std::string fieldFrame;
+  std::string robotDetector;                ///< "cluster" (3D clusters) or "grid" (occupancy grid)
 
   unsigned int numRobotsDisplayed = 0;
   unsigned int numBallsDisplayed = 0;
 
   ColorTable colorTable;
-} 
+  ground_truth::CandidateExtractor extractor;
+  ground_truth::OrganizedClusterer clusterer(0.1);
+  ground_truth::OccupancyGrid occupancyGrid(0.02);
 
-/**
- * \brief  Loads color table from file into array 
- */
-void loadColorTable() {
-  FILE* f = fopen(colorTableFile.c_str(), "rb");
-  size_t size = fread(colorTable, 128*128*128, 1, f);
-  size = size; // remove warning
-  fclose(f);
-}
+  const unsigned int MIN_BALL_POINTS = 5;
+  const unsigned int MIN_ROBOT_POINTS = 200;
+
+  std::ofstream logStream;
+} 
 
 /**
  * \brief  Helper function to return time in seconds with micro-second precision 
@@ -90,124 +124,233 @@ inline std::string getUniqueName(const std::string &baseName, int uniqueId) {
 }
 
 /**
- * \brief  Function to detect the ball given the transformed point cloud from the kinect
- * \param cloudIn The transformed point cloud from the Kinect
- * \param ballPositions The detected ball positions (can be more than 1)
- * \param cloudOut The clusters contributing to the detected balls
+ * \brief  Copies candidate points into a pcl cloud
  */
-void detectBall(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloudIn, std::vector<pcl::PointXYZ> &ballPositions, pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloudOut) {
+void toPointCloud(const std::vector<ground_truth::Candidate> &candidates, pcl::PointCloud<pcl::PointXYZRGB> &cloud) {
+  cloud.points.resize(candidates.size());
+  for (unsigned int i = 0; i < candidates.size(); i++) {
+    pcl::PointXYZRGB &pt = cloud.points[i];
+    pt.x = candidates[i].x;
+    pt.y = candidates[i].y;
+    pt.z = candidates[i].z;
+    pt.rgb = candidates[i].rgb;
+  }
+  cloud.width = candidates.size();
+  cloud.height = 1;
+  cloud.is_dense = true;
+}
 
-  pcl::PointIndices inliers;
+/**
+ * \brief  Function to detect the ball given the clusters of ball candidates
+ * \param clusters The clusters of orange points near the ground
+ * \param balls The clusters detected as the ball (can be more than 1)
+ */
+void detectBall(const std::vector<ground_truth::Cluster> &clusters, std::vector<ground_truth::Cluster> &balls) {
 
-  ballPositions.clear();
+  balls = clusters;
 
-  for (unsigned int i = 0; i < cloudIn->points.size(); i++) {
-    pcl::PointXYZRGB *pt = &cloudIn->points[i];
-    int rgb = *reinterpret_cast<int*>(&pt->rgb);
-    int r = ((rgb >> 16) & 0xff);
-    int g = ((rgb >> 8) & 0xff);
-    int b = (rgb & 0xff);
-    if (colorTable[r/2][g/2][b/2] == ORANGE && fabs(pt->x) < 3.5 && fabs(pt->y) < 2.25 && fabs(pt->z) < 0.15 ) {
-      inliers.indices.push_back(i);
-    }
-  }
+}
 
-  pcl::ExtractIndices<pcl::PointXYZRGB> extract;
-  extract.setInputCloud(cloudIn);
-  extract.setIndices(boost::make_shared<pcl::PointIndices>(inliers));
-  extract.setNegative(false);
-  extract.filter(*cloudOut);
+/**
+ * \brief  Function to detect robots given the clusters of robot candidates
+ * \param clusters The clusters of points above the ground
+ * \param robots The clusters detected as robots
+ */
+void detectRobots(const std::vector<ground_truth::Cluster> &clusters, std::vector<ground_truth::Cluster> &robots) {
 
-  if (cloudOut->points.size() == 0)
-    return;
+  robots.clear();
+  for (unsigned int i = 0; i < clusters.size(); i++) {
+    // Too tall to be a robot (a person, or a goal)
+    if (clusters[i].maxZ > 0.7)
+      continue;
+    robots.push_back(clusters[i]);
+  }
 
-  pcl::EuclideanClusterExtraction<pcl::PointXYZRGB> cluster;
-  cluster.setClusterTolerance(0.1);
-  cluster.setMinClusterSize(5);
-  cluster.setInputCloud(cloudOut);
-  std::vector<pcl::PointIndices> clusters;
-  cluster.extract(clusters);
+}
 
-  for (unsigned int i = 0; i < clusters.size(); i++) {
-    pcl::PointIndices clusterIndex = clusters[i];
+/**
+ * \brief  Ground position of a detected object
+ */
+inline pcl::PointXYZ getGroundPosition(const ground_truth::Cluster &cluster) {
+  return pcl::PointXYZ(cluster.x, cluster.y, 0);
+}
 
-    pcl::PointXYZ point(0,0,0);
-    for (unsigned int j = 0; j < clusterIndex.indices.size(); j++) {
-      point.x += cloudOut->points[clusterIndex.indices[j]].x;
-      point.y += cloudOut->points[clusterIndex.indices[j]].y;
+/**
+ * \brief  Fills the message fields for detected objects
+ */
+void toObjects(const std::vector<ground_truth::Cluster> &clusters, std::vector<ground_truth::DetectedObject> &objects) {
+  objects.resize(clusters.size());
+  for (unsigned int i = 0; i < clusters.size(); i++) {
+    ground_truth::DetectedObject &object = objects[i];
+    object.position.x = clusters[i].x;
+    object.position.y = clusters[i].y;
+    object.position.z = 0;
+    for (unsigned int j = 0; j < 9; j++) {
+      object.covariance[j] = 0;
     }
-    point.z = 0;
-    point.x /= clusterIndex.indices.size();
-    point.y /= clusterIndex.indices.size();
-    ballPositions.push_back(point);
+    object.covariance[0] = clusters[i].covariance[0];
+    object.covariance[1] = object.covariance[3] = clusters[i].covariance[1];
+    object.covariance[4] = clusters[i].covariance[2];
+    object.num_points = clusters[i].size;
   }
+}
 
+/**
+ * \brief   Callback function for the point cloud message received from the kinect driver
+ */
+void cloudCallback (const sensor_msgs::PointCloud2ConstPtr& cloudPtrFromMsg) {
+  cloudBuffer.getBack() = cloudPtrFromMsg;
+  cloudBuffer.publish();
+  // Taking the lock makes sure the processing thread is not between its
+  // check for a new cloud and its wait, so that the notification is not lost
+  {
+    boost::mutex::scoped_lock lock(mProcess);
+  }
+  processCondition.notify_one();
 }
 
 /**
- * \brief  Function to detect robots given the transformed point cloud from the kinect
- * \param cloudIn The transformed point cloud from the Kinect
- * \param ballPositions The robot positions
- * \param cloudOut The clusters contributing to the detected robots
+ * \brief   Processing stage. Runs on its own thread, taking the latest
+ *          cloud from the spinner and handing detections to the renderer.
  */
-void detectRobots(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloudIn, std::vector<pcl::PointXYZ> &robotPositions, pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloudOut) {
+void processClouds() {
+
+  // Ball and robot candidates are clustered in the same sweep, unless
+  // robots are found on the occupancy grid
+  bool gridRobots = (robotDetector == "grid");
+  std::vector<const std::vector<ground_truth::Candidate>*> candidateSets;
+  std::vector<unsigned int> minClusterSizes;
+  candidateSets.push_back(&extractor.getBallCandidates());
+  minClusterSizes.push_back(MIN_BALL_POINTS);
+  if (!gridRobots) {
+    candidateSets.push_back(&extractor.getRobotCandidates());
+    minClusterSizes.push_back(MIN_ROBOT_POINTS);
+  }
+  std::vector<std::vector<ground_truth::Cluster> > clusters;
+  std::vector<ground_truth::Cluster> robotClusters;
 
-  pcl::PointIndices inliers;
+  tf::TransformBroadcaster transformBroadcaster;
+  ground_truth::GroundTruth groundTruth;
+  groundTruth.header.frame_id = fieldFrame;
 
-  robotPositions.clear();
+  while (true) {
 
-  for (unsigned int i = 0; i < cloudIn->points.size(); i++) {
-    pcl::PointXYZRGB *pt = &cloudIn->points[i];
-    if (pt->z > 0.25 && pt->y < 2 && pt->y > -2 && pt->x < 2.75 && pt->x > -2.75) {
-      inliers.indices.push_back(i);
+    {
+      boost::mutex::scoped_lock lock(mProcess);
+      while (processing && !cloudBuffer.update()) {
+        processCondition.wait(lock);
+      }
+      if (!processing)
+        break;
     }
-  }
 
-  pcl::ExtractIndices<pcl::PointXYZRGB> extract;
-  extract.setInputCloud(cloudIn);
-  extract.setIndices(boost::make_shared<pcl::PointIndices>(inliers));
-  extract.setNegative(false);
-  extract.filter(*cloudOut);
+    // Transform and classify all points in one pass over the message,
+    // keeping only the points that may be part of the ball or a robot
+    sensor_msgs::PointCloud2ConstPtr &cloudPtr = cloudBuffer.getFront();
+    groundTruth.header.stamp = cloudPtr->header.stamp;
+    std::string cloudFrame = cloudPtr->header.frame_id;
+    std::string extractError;
+    bool extracted = extractor.extract(*cloudPtr, &extractError);
+    cloudPtr.reset();   // Do not hold on to the message until the next one
+
+    Detection &detection = detectionBuffer.getBack();
+    detection.balls.clear();
+    detection.robots.clear();
+    if (!extracted) {
+      ROS_ERROR("Unable to process cloud: %s", extractError.c_str());
+      // Every cloud gets a message, an empty one if it cannot be used
+      groundTruth.balls.clear();
+      groundTruth.robots.clear();
+      groundTruthPublisher.publish(groundTruth);
+      continue;
+    }
 
-  if (cloudOut->points.size() == 0)
-    return;
+    // The field frame is given by the calibration of this camera
+    transformBroadcaster.sendTransform(tf::StampedTransform(cameraToField,
+          groundTruth.header.stamp, fieldFrame, cloudFrame));
 
-  pcl::EuclideanClusterExtraction<pcl::PointXYZRGB> cluster;
-  cluster.setClusterTolerance(0.1);
-  cluster.setMinClusterSize(200);
-  cluster.setInputCloud(cloudOut);
-  std::vector<pcl::PointIndices> clusters;
-  cluster.extract(clusters);
+    // The clusterer connects neighbors in the image, which an unorganized
+    // cloud does not have
+    if (extractor.getHeight() <= 1) {
+      ROS_ERROR("Unable to cluster cloud: it is not organized (height %u)", extractor.getHeight());
+    } else {
+      clusterer.cluster(candidateSets, extractor.getWidth(), extractor.getHeight(), minClusterSizes, clusters);
 
-  for (unsigned int i = 0; i < clusters.size(); i++) {
-    pcl::PointIndices clusterIndex = clusters[i];
+      // Ball
+      detectBall(clusters[0], detection.balls);
 
-    pcl::PointXYZ point(0,0,0);
-    bool highPoint = false;
-    for (unsigned int j = 0; j < clusterIndex.indices.size(); j++) {
-      if (cloudOut->points[clusterIndex.indices[j]].z > 0.7) {
-        highPoint = true;
+      /* 
+      //Sample log file code
+      logStream << std::fixed << getSystemTime() << ",";
+      if (detection.balls.size() == 0) {
+        logStream << "-7," << "-7,";
+      } else if (detection.balls.size() == 1) {
+        logStream << detection.balls[0].x << "," << detection.balls[0].y << ",";
+      }
+      */
+
+      // Robots
+      if (gridRobots) {
+        occupancyGrid.clear();
+        occupancyGrid.add(extractor.getRobotCandidates());
+        occupancyGrid.findBlobs(MIN_ROBOT_POINTS, robotClusters);
+      } else {
+        robotClusters.swap(clusters[1]);
       }
-      point.x += cloudOut->points[clusterIndex.indices[j]].x;
-      point.y += cloudOut->points[clusterIndex.indices[j]].y;
+      detectRobots(robotClusters, detection.robots);
+
+      /*
+      //Sample log file code
+      if (detection.robots.size() == 0) {
+        logStream << "-7," << "-7,";
+      } else if (detection.robots.size() == 1) {
+        logStream << detection.robots[0].x << "," << detection.robots[0].y << ",";
+      }
+      logStream << std::endl;
+      */
     }
-    if (highPoint)
-      continue;
-    point.z = 0;
-    point.x /= clusterIndex.indices.size();
-    point.y /= clusterIndex.indices.size();
-    robotPositions.push_back(point);
-  }
 
+    toObjects(detection.balls, groundTruth.balls);
+    toObjects(detection.robots, groundTruth.robots);
+    groundTruthPublisher.publish(groundTruth);
+
+    // The mode only picks the points displayed
+    if (!headless) {
+      if (mode == FULL) {
+        toPointCloud(extractor.getAllPoints(), detection.cloud);
+      } else {
+        toPointCloud(extractor.getRobotCandidates(), detection.cloud);
+      }
+      detectionBuffer.publish();
+    }
+  }
 }
 
 /**
- * \brief   Callback function for the point cloud message received from the kinect driver
+ * \brief   Render stage. Replaces the displayed cloud and markers.
  */
-void cloudCallback (const sensor_msgs::PointCloud2ConstPtr& cloudPtrFromMsg) {
-  mCloud.lock();
-  cloudPtr = cloudPtrFromMsg;
-  mCloud.unlock();
+void renderDetection(pcl_visualization::PCLVisualizer &visualizer, const Detection &detection) {
+
+  for (unsigned int i = 0; i < numBallsDisplayed; i++) {
+    visualizer.removeShape(getUniqueName("ball", i));
+  }
+  for (unsigned int i = 0; i < detection.balls.size(); i++) {
+    visualizer.addSphere(getGroundPosition(detection.balls[i]), 0.05, 1.0, 0.4, 0.0, getUniqueName("ball", i));
+  }
+  numBallsDisplayed = detection.balls.size();
+
+  for (unsigned int i = 0; i < numRobotsDisplayed; i++) {
+    visualizer.removeShape(getUniqueName("robot", i));
+  }
+  for (unsigned int i = 0; i < detection.robots.size(); i++) {
+    visualizer.addSphere(getGroundPosition(detection.robots[i]), 0.1, 1.0, 1.0, 1.0, getUniqueName("robot", i));
+  }
+  numRobotsDisplayed = detection.robots.size();
+
+  visualizer.removePointCloud();
+  colorHandler.reset (new pcl_visualization::PointCloudColorHandlerRGBField<pcl::PointXYZRGB> (detection.cloud));
+  geometryHandler.reset (new pcl_visualization::PointCloudGeometryHandlerXYZ<pcl::PointXYZRGB> (detection.cloud));
+  visualizer.addPointCloud<pcl::PointXYZRGB>(detection.cloud, *colorHandler, *geometryHandler);
 }
 
 /**
@@ -220,16 +363,25 @@ void getParameters(ros::NodeHandle &nh, int argc, char ** argv) {
   calibFile = "data/calib.txt";
   colorTableFile = "data/default.col";
   mode = 1;
+  robotDetector = "cluster";
+  renderRate = 30;
+  headless = 0;
+  fieldFrame = "field";
 
   terminal_tools::parse_argument (argc, argv, "-qsize", qSize);
   terminal_tools::parse_argument (argc, argv, "-calibFile", calibFile);
   terminal_tools::parse_argument (argc, argv, "-logFile", logFile);
   terminal_tools::parse_argument (argc, argv, "-colorTableFile", colorTableFile);
   terminal_tools::parse_argument (argc, argv, "-mode", mode);
+  terminal_tools::parse_argument (argc, argv, "-robotDetector", robotDetector);
+  terminal_tools::parse_argument (argc, argv, "-renderRate", renderRate);
+  terminal_tools::parse_argument (argc, argv, "-headless", headless);
+  terminal_tools::parse_argument (argc, argv, "-fieldFrame", fieldFrame);
 
   ROS_INFO("Calib File: %s", calibFile.c_str());
   ROS_INFO("Log File: %s", logFile.c_str());
   ROS_INFO("ColorTable File: %s", colorTableFile.c_str());
+  ROS_INFO("Robot Detector: %s", robotDetector.c_str());
 }
 
 int main (int argc, char** argv) {
@@ -241,6 +393,7 @@ int main (int argc, char** argv) {
 
   // Create a ROS subscriber for the point cloud
   ros::Subscriber subCloud = nh.subscribe (cloudTopic, qSize, cloudCallback);
+  groundTruthPublisher = nh.advertise<ground_truth::GroundTruth>("ground_truth", 1);
 
   // Get transformation that needs to be applied to each input cloud to get the cloud in the correct reference frame
   std::ifstream fin(calibFile.c_str());
@@ -254,118 +407,62 @@ int main (int argc, char** argv) {
     }
   }
   fin.close();
+  cameraToField.setBasis(btMatrix3x3(
+        transformMatrix(0,0), transformMatrix(0,1), transformMatrix(0,2),
+        transformMatrix(1,0), transformMatrix(1,1), transformMatrix(1,2),
+        transformMatrix(2,0), transformMatrix(2,1), transformMatrix(2,2)));
+  cameraToField.setOrigin(btVector3(transformMatrix(0,3), transformMatrix(1,3), transformMatrix(2,3)));
+
+  // No VTK context at all when headless
+  boost::scoped_ptr<pcl_visualization::PCLVisualizer> visualizer;
+  if (!headless) {
+    visualizer.reset(new pcl_visualization::PCLVisualizer(argc, argv, "PointCloud"));
+    visualizer->addCoordinateSystem(); // Good for reference
+    ground_truth::FieldProvider field;
+    field.get3dField(*visualizer);
+  }
 
-  pcl_visualization::PCLVisualizer visualizer(argc, argv, "PointCloud");
-  visualizer.addCoordinateSystem(); // Good for reference
-  ground_truth::FieldProvider field;
-  field.get3dField(visualizer);
-
-  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZRGB>);
-  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloudSwap(new pcl::PointCloud<pcl::PointXYZRGB>);
-  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloudDisplay;
-  
-  loadColorTable();
-
-  std::ofstream log(logFile.c_str());
-
-  while (nh.ok ()) {
-
-    // Spin
-    ros::spinOnce ();
-    ros::Duration (0.001).sleep ();
-    visualizer.spinOnce(10);
-
-    // If no cloud received yet, continue
-    if (!cloudPtr)
-      continue;
-
-    if (cloudPtr == oldCloudPtr)
-      continue;
-
-    // Convert to PointCloud<T>
-    mCloud.lock ();
-
-    pcl::fromROSMsg (*cloudPtr, *cloud);
-
-    // Apply transformation to get the correct reference frame
-    pcl::transformPointCloud(*cloud, *cloudSwap, transformMatrix);
-
-    // Apply filter to extract only those points which are on the field
-
-    if (mode == FULL) {
-
-      pcl::PointIndices inliers;
-      for (unsigned int i = 0; i < cloudSwap->points.size(); i++) {
-        pcl::PointXYZRGB *pt = &cloudSwap->points[i];
-        if (pcl_isfinite(pt->x)) {
-          inliers.indices.push_back(i);
-        }
-      }
-      pcl::ExtractIndices<pcl::PointXYZRGB> extract;
-      extract.setInputCloud(cloudSwap);
-      extract.setIndices(boost::make_shared<pcl::PointIndices>(inliers));
-      extract.setNegative(false);
-      extract.filter(*cloud);
-      
-      cloudDisplay.reset(new pcl::PointCloud<pcl::PointXYZRGB>);
-      *cloudDisplay = *cloud;
-    } else {
-
-      cloudDisplay.reset(new pcl::PointCloud<pcl::PointXYZRGB>);
-      // Ball
-      std::vector<pcl::PointXYZ> ballPositions;
-      detectBall(cloudSwap, ballPositions, cloud);
-      for (unsigned int i = 0; i < numBallsDisplayed; i++) {
-        visualizer.removeShape(getUniqueName("ball", i));
-      }
-      for (unsigned int i = 0; i < ballPositions.size(); i++) {
-        visualizer.addSphere(ballPositions[i], 0.05, 1.0, 0.4, 0.0, getUniqueName("ball", i));
-      }
-      numBallsDisplayed = ballPositions.size();
-
-      /* 
-      //Sample log file code
-      log << std::fixed << getSystemTime() << ",";
-      if (ballPositions.size() == 0) {
-        log << "-7," << "-7,";
-      } else if (ballPositions.size() == 1) {
-        log << ballPositions[0].x << "," << ballPositions[0].y << ",";
-      }
-      */
-
-      // Robots
-      std::vector<pcl::PointXYZ> robotPositions;
-      detectRobots(cloudSwap, robotPositions, cloud);
-      *cloudDisplay = *cloud;                           // Display the cloud
-      for (unsigned int i = 0; i < numRobotsDisplayed; i++) {
-        visualizer.removeShape(getUniqueName("robot", i));
-      }
-      for (unsigned int i = 0; i < robotPositions.size(); i++) {
-        visualizer.addSphere(robotPositions[i], 0.1, 1.0, 1.0, 1.0, getUniqueName("robot", i));
-      }
-      numRobotsDisplayed = robotPositions.size();
-
-      /*
-      //Sample log file code
-      if (robotPositions.size() == 0) {
-        log << "-7," << "-7,";
-      } else if (robotPositions.size() == 1) {
-        log << robotPositions[0].x << "," << robotPositions[0].y << ",";
+  std::string colorTableError;
+  if (!colorTable.load(colorTableFile, &colorTableError)) {
+    ROS_ERROR("Unable to load color table: %s", colorTableError.c_str());
+    return -1;
+  }
+  ROS_INFO("Segmentation kernel: %s", getSimdLevelName(getSimdLevel()));
+
+  extractor.setTransform(transformMatrix);
+  extractor.setColorTable(&colorTable);
+  extractor.setKeepAll(mode == FULL && !headless);   // Only needed for display
+
+  logStream.open(logFile.c_str());
+
+  // Clouds are received on the spinner's thread and processed on another,
+  // so neither waits for rendering. A single spinner thread keeps a single
+  // producer on the cloud buffer.
+  boost::thread processThread(processClouds);
+  ros::AsyncSpinner spinner(1);
+  spinner.start();
+
+  if (headless) {
+    ros::waitForShutdown();
+  } else {
+    ros::WallRate rate(std::max(renderRate, 1));
+    while (nh.ok ()) {
+      if (detectionBuffer.update()) {
+        renderDetection(*visualizer, detectionBuffer.getFront());
       }
-      log << std::endl;
-      */
-
+      visualizer->spinOnce(1);
+      rate.sleep();
     }
+  }
 
-    visualizer.removePointCloud();
-    colorHandler.reset (new pcl_visualization::PointCloudColorHandlerRGBField<pcl::PointXYZRGB> (*cloudDisplay));
-    geometryHandler.reset (new pcl_visualization::PointCloudGeometryHandlerXYZ<pcl::PointXYZRGB> (*cloudDisplay));
-    visualizer.addPointCloud<pcl::PointXYZRGB>(*cloudDisplay, *colorHandler, *geometryHandler);
-
-    oldCloudPtr = cloudPtr;
-
-    mCloud.unlock ();
+  spinner.stop();
+  {
+    boost::mutex::scoped_lock lock(mProcess);
+    processing = false;
   }
-  log.close();
+  processCondition.notify_one();
+  processThread.join();
+
+  logStream.close();
   return (0);
 }